@@ -1,4 +1,6 @@
 #include <animation/animation.h>
+#include <animation/compressed_anim_node.h>
+#include <math.h>
 
 namespace gef
 {
@@ -35,108 +37,119 @@ namespace gef
 
 
 
-	TransformAnimNode::TransformAnimNode() :
-		AnimNode(AnimNode::kTransform)
+	const Vector4 SampleKeys(const Vector3Key* keys, const UInt32 num_keys, const float time, UInt32& key_cursor)
 	{
-	}
+		Vector4 result(0.f, 0.f, 0.f);
 
-	TransformAnimNode::~TransformAnimNode()
-	{
-	}
+		if(num_keys == 0)
+			return result;
 
-	const Vector4 TransformAnimNode::GetTranslation(const float _time) const
-	{
-		return GetVector(_time, this->translation_keys_);
-	}
+		const UInt32 keyIndex = FindNextKey(KeyTimes<Vector3Key>(keys), num_keys, time, key_cursor);
 
-	const Vector4 TransformAnimNode::GetScale(const float _time) const
-	{
-		return GetVector(_time, this->scale_keys_);
+		if(keyIndex == 0 || keyIndex == num_keys)
+		{
+			// before the first key or after the last one
+			result = keys[keyIndex == 0 ? 0 : keyIndex-1].value;
+		}
+		else
+		{
+			const Vector3Key& prevKey = keys[keyIndex-1];
+			const Vector3Key& nextKey = keys[keyIndex];
+			float t = (time - prevKey.time) / (nextKey.time - prevKey.time);
+			result.Lerp(prevKey.value, nextKey.value, t);
+		}
+
+		return result;
 	}
 
-	const Quaternion TransformAnimNode::GetRotation(const float _time) const
+	const Quaternion SampleKeys(const QuaternionKey* keys, const UInt32 num_keys, const float time, UInt32& key_cursor)
 	{
 		Quaternion result;
 		result.Identity();
 
-		const QuaternionKey* pPrevKey = NULL;
-		const QuaternionKey* pNextKey = NULL;
-		UInt32 keyIndex;
-		for(keyIndex=0;keyIndex<this->rotation_keys_.size();keyIndex++)
-		{
-
-			if(this->rotation_keys_[keyIndex].time > _time)
-			{
-				pNextKey = &this->rotation_keys_[keyIndex];
-
-				if(keyIndex > 0)
-					pPrevKey = &this->rotation_keys_[keyIndex-1];
+		if(num_keys == 0)
+			return result;
 
-				break;
-			}
-		}
+		const UInt32 keyIndex = FindNextKey(KeyTimes<QuaternionKey>(keys), num_keys, time, key_cursor);
 
-		if(keyIndex == this->rotation_keys_.size())
+		if(keyIndex == 0 || keyIndex == num_keys)
 		{
-			pNextKey =  &this->rotation_keys_[keyIndex-1];
+			// before the first key or after the last one
+			result = keys[keyIndex == 0 ? 0 : keyIndex-1].value;
 		}
-
-		if(pPrevKey)
+		else
 		{
-			if(pNextKey)
-			{
-				float t = (_time - pPrevKey->time) / (pNextKey->time - pPrevKey->time);
-				result.Slerp(pPrevKey->value, pNextKey->value, t);
-			}
-			else
-				result = pPrevKey->value;
+			const QuaternionKey& prevKey = keys[keyIndex-1];
+			const QuaternionKey& nextKey = keys[keyIndex];
+			float t = (time - prevKey.time) / (nextKey.time - prevKey.time);
+			result.Slerp(prevKey.value, nextKey.value, t);
 		}
-		else if(pNextKey)
-				result = pNextKey->value;
 
 		return result;
 	}
 
-	const Vector4 TransformAnimNode::GetVector(float _time, const std::vector<Vector3Key>& _keys) const
+	TransformAnimNodeCursor::TransformAnimNodeCursor()
 	{
-		Vector4 result(0.f, 0.f, 0.f);
+		Reset();
+	}
 
-		const Vector3Key* pPrevKey = NULL;
-		const Vector3Key* pNextKey = NULL;
-		UInt32 keyIndex;
-		for(keyIndex=0;keyIndex<_keys.size();keyIndex++)
-		{
+	void TransformAnimNodeCursor::Reset()
+	{
+		scale_key = 0;
+		rotation_key = 0;
+		translation_key = 0;
+	}
 
-			if(_keys[keyIndex].time > _time)
-			{
-				pNextKey = &_keys[keyIndex];
+	TransformAnimNode::TransformAnimNode() :
+		AnimNode(AnimNode::kTransform)
+	{
+	}
 
-				if(keyIndex > 0)
-					pPrevKey = &_keys[keyIndex-1];
+	TransformAnimNode::~TransformAnimNode()
+	{
+	}
 
-				break;
-			}
-		}
+	const Vector4 TransformAnimNode::GetTranslation(const float _time) const
+	{
+		UInt32 key_cursor = 0;
+		return GetVector(_time, this->translation_keys_, key_cursor);
+	}
 
-		if(keyIndex == _keys.size())
-		{
-			pNextKey =  &_keys[keyIndex-1];
-		}
+	const Vector4 TransformAnimNode::GetScale(const float _time) const
+	{
+		UInt32 key_cursor = 0;
+		return GetVector(_time, this->scale_keys_, key_cursor);
+	}
 
-		if(pPrevKey)
-		{
-			if(pNextKey)
-			{
-				float t = (_time - pPrevKey->time) / (pNextKey->time - pPrevKey->time);
-				result.Lerp(pPrevKey->value, pNextKey->value, t);
-			}
-			else
-				result = pPrevKey->value;
-		}
-		else if(pNextKey)
-			result = pNextKey->value;
+	const Quaternion TransformAnimNode::GetRotation(const float _time) const
+	{
+		UInt32 key_cursor = 0;
+		return GetQuaternion(_time, this->rotation_keys_, key_cursor);
+	}
 
-		return result;
+	const Vector4 TransformAnimNode::GetTranslation(const float _time, TransformAnimNodeCursor& cursor) const
+	{
+		return GetVector(_time, this->translation_keys_, cursor.translation_key);
+	}
+
+	const Vector4 TransformAnimNode::GetScale(const float _time, TransformAnimNodeCursor& cursor) const
+	{
+		return GetVector(_time, this->scale_keys_, cursor.scale_key);
+	}
+
+	const Quaternion TransformAnimNode::GetRotation(const float _time, TransformAnimNodeCursor& cursor) const
+	{
+		return GetQuaternion(_time, this->rotation_keys_, cursor.rotation_key);
+	}
+
+	const Quaternion TransformAnimNode::GetQuaternion(const float _time, const std::vector<QuaternionKey>& _keys, UInt32& key_cursor) const
+	{
+		return SampleKeys(_keys.empty() ? NULL : &_keys[0], (UInt32)_keys.size(), _time, key_cursor);
+	}
+
+	const Vector4 TransformAnimNode::GetVector(float _time, const std::vector<Vector3Key>& _keys, UInt32& key_cursor) const
+	{
+		return SampleKeys(_keys.empty() ? NULL : &_keys[0], (UInt32)_keys.size(), _time, key_cursor);
 	}
 
 	float TransformAnimNode::GetMaximumKeyTime() const
@@ -220,6 +233,191 @@ namespace gef
 	}
 
 
+	SampledTransformAnimNode::SampledTransformAnimNode() :
+		AnimNode(AnimNode::kSampledTransform),
+		sample_rate_(0.0f),
+		start_time_(0.0f),
+		sample_count_(0)
+	{
+	}
+
+	SampledTransformAnimNode::~SampledTransformAnimNode()
+	{
+	}
+
+	bool SampledTransformAnimNode::Resample(const TransformAnimNode& node, const float start_time, const float end_time, const float sample_rate)
+	{
+		// the sample times are found by dividing by the rate, so a rate that isn't positive, or is NaN, is rejected
+		if(!(sample_rate > 0.0f))
+			return false;
+
+		set_name_id(node.name_id());
+		sample_rate_ = sample_rate;
+		start_time_ = start_time;
+
+		// allow for rounding errors so a duration that is a whole number of samples doesn't get an extra one
+		sample_count_ = 1;
+		if(end_time > start_time)
+			sample_count_ += (UInt32)ceilf((end_time - start_time) * sample_rate - 1e-3f);
+
+		// a single key gives a constant track so there is no need to store more than one sample
+		const UInt32 scale_count = node.scale_keys().size() > 1 ? sample_count_ : (UInt32)node.scale_keys().size();
+		const UInt32 rotation_count = node.rotation_keys().size() > 1 ? sample_count_ : (UInt32)node.rotation_keys().size();
+		const UInt32 translation_count = node.translation_keys().size() > 1 ? sample_count_ : (UInt32)node.translation_keys().size();
+		scales_.resize(scale_count);
+		rotations_.resize(rotation_count);
+		translations_.resize(translation_count);
+
+		TransformAnimNodeCursor cursor;
+		for(UInt32 sample_num = 0; sample_num < sample_count_; ++sample_num)
+		{
+			const float time = start_time + (float)sample_num / sample_rate;
+
+			if(sample_num < scale_count)
+				scales_[sample_num] = node.GetScale(time, cursor);
+
+			if(sample_num < rotation_count)
+			{
+				Quaternion rotation = node.GetRotation(time, cursor);
+
+				// keep neighbouring samples in the same hemisphere so they can be interpolated without checking
+				if(sample_num > 0)
+				{
+					const Quaternion& previous = rotations_[sample_num-1];
+					if(rotation.x*previous.x + rotation.y*previous.y + rotation.z*previous.z + rotation.w*previous.w < 0.0f)
+						rotation = -rotation;
+				}
+				rotations_[sample_num] = rotation;
+			}
+
+			if(sample_num < translation_count)
+				translations_[sample_num] = node.GetTranslation(time, cursor);
+		}
+
+		return true;
+	}
+
+	void SampledTransformAnimNode::GetSampleIndex(const float time, UInt32& sample_index, float& fraction) const
+	{
+		const float position = (time - start_time_) * sample_rate_;
+		if(position <= 0.0f || sample_count_ < 2)
+		{
+			sample_index = 0;
+			fraction = 0.0f;
+		}
+		else if(position >= (float)(sample_count_ - 1))
+		{
+			sample_index = sample_count_ - 2;
+			fraction = 1.0f;
+		}
+		else
+		{
+			sample_index = (UInt32)position;
+			fraction = position - (float)sample_index;
+		}
+	}
+
+	const Vector4 SampledTransformAnimNode::GetVector(const float time, const std::vector<Vector4>& samples) const
+	{
+		if(samples.size() < 2)
+			return samples.empty() ? Vector4(0.f, 0.f, 0.f) : samples[0];
+
+		UInt32 sample_index;
+		float fraction;
+		GetSampleIndex(time, sample_index, fraction);
+
+		Vector4 result;
+		result.Lerp(samples[sample_index], samples[sample_index+1], fraction);
+		return result;
+	}
+
+	const Vector4 SampledTransformAnimNode::GetTranslation(const float time) const
+	{
+		return GetVector(time, translations_);
+	}
+
+	const Vector4 SampledTransformAnimNode::GetScale(const float time) const
+	{
+		return GetVector(time, scales_);
+	}
+
+	const Quaternion SampledTransformAnimNode::GetRotation(const float time) const
+	{
+		if(rotations_.size() < 2)
+			return rotations_.empty() ? Quaternion::kIdentity : rotations_[0];
+
+		UInt32 sample_index;
+		float fraction;
+		GetSampleIndex(time, sample_index, fraction);
+
+		// the samples are close together so a normalised lerp is indistinguishable from a slerp
+		Quaternion result;
+		result.Lerp(rotations_[sample_index], rotations_[sample_index+1], fraction);
+		result.Normalise();
+		return result;
+	}
+
+	float SampledTransformAnimNode::GetMaximumKeyTime() const
+	{
+		if(sample_count_ == 0 || sample_rate_ <= 0.0f)
+			return start_time_;
+
+		return start_time_ + (float)(sample_count_ - 1) / sample_rate_;
+	}
+
+	bool SampledTransformAnimNode::Read(std::istream& stream)
+	{
+		// name_id and type have already been read so don't read them in here
+		stream.read((char*)&sample_rate_, sizeof(float));
+		stream.read((char*)&start_time_, sizeof(float));
+		stream.read((char*)&sample_count_, sizeof(UInt32));
+
+		Int32 num_scales;
+		stream.read((char*)&num_scales, sizeof(Int32));
+		scales_.resize(num_scales);
+		if(num_scales > 0)
+			stream.read((char*)&scales_.front(), sizeof(Vector4)*num_scales);
+
+		Int32 num_rotations;
+		stream.read((char*)&num_rotations, sizeof(Int32));
+		rotations_.resize(num_rotations);
+		if(num_rotations > 0)
+			stream.read((char*)&rotations_.front(), sizeof(Quaternion)*num_rotations);
+
+		Int32 num_translations;
+		stream.read((char*)&num_translations, sizeof(Int32));
+		translations_.resize(num_translations);
+		if(num_translations > 0)
+			stream.read((char*)&translations_.front(), sizeof(Vector4)*num_translations);
+
+		return true;
+	}
+
+	bool SampledTransformAnimNode::Write(std::ostream& stream) const
+	{
+		bool success = AnimNode::Write(stream);
+
+		stream.write((char*)&sample_rate_, sizeof(float));
+		stream.write((char*)&start_time_, sizeof(float));
+		stream.write((char*)&sample_count_, sizeof(UInt32));
+
+		Int32 num_scales = (Int32)scales_.size();
+		stream.write((char*)&num_scales, sizeof(Int32));
+		if(num_scales > 0)
+			stream.write((char*)&scales_.front(), sizeof(Vector4)*num_scales);
+		Int32 num_rotations = (Int32)rotations_.size();
+		stream.write((char*)&num_rotations, sizeof(Int32));
+		if(num_rotations > 0)
+			stream.write((char*)&rotations_.front(), sizeof(Quaternion)*num_rotations);
+		Int32 num_translations = (Int32)translations_.size();
+		stream.write((char*)&num_translations, sizeof(Int32));
+		if(num_translations > 0)
+			stream.write((char*)&translations_.front(), sizeof(Vector4)*num_translations);
+
+		return success;
+	}
+
+
 	ChannelAnimNode::ChannelAnimNode() :
 		AnimNode(AnimNode::kChannel)
 	{
@@ -246,40 +444,24 @@ namespace gef
 	{
 		float result = 0.0f;
 
-		const ChannelKey* pPrevKey = NULL;
-		const ChannelKey* pNextKey = NULL;
-		UInt32 keyIndex;
-		for(keyIndex=0;keyIndex<keys_.size();keyIndex++)
-		{
-
-			if(keys_[keyIndex].time > time)
-			{
-				pNextKey = &keys_[keyIndex];
+		if(keys_.empty())
+			return result;
 
-				if(keyIndex > 0)
-					pPrevKey = &keys_[keyIndex-1];
-
-				break;
-			}
-		}
+		UInt32 key_cursor = 0;
+		const UInt32 keyIndex = FindNextKey(KeyTimes<ChannelKey>(&keys_[0]), (UInt32)keys_.size(), time, key_cursor);
 
-		if(keyIndex == keys_.size())
+		if(keyIndex == 0 || keyIndex == keys_.size())
 		{
-			pNextKey =  &keys_[keyIndex-1];
+			// before the first key or after the last one
+			result = keys_[keyIndex == 0 ? 0 : keyIndex-1].value;
 		}
-
-		if(pPrevKey)
+		else
 		{
-			if(pNextKey)
-			{
-				float t = (time - pPrevKey->time) / (pNextKey->time - pPrevKey->time);
-				result = (1.0f - t)*pPrevKey->value +t*pNextKey->value;
-			}
-			else
-				result = pPrevKey->value;
+			const ChannelKey& prevKey = keys_[keyIndex-1];
+			const ChannelKey& nextKey = keys_[keyIndex];
+			float t = (time - prevKey.time) / (nextKey.time - prevKey.time);
+			result = (1.0f - t)*prevKey.value +t*nextKey.value;
 		}
-		else if(pNextKey)
-			result = pNextKey->value;
 
 		return result;
 	}
@@ -342,6 +524,14 @@ namespace gef
 				case AnimNode::kChannel:
 					anim_node = new ChannelAnimNode(*(static_cast<ChannelAnimNode*>(anim_node_iter->second)));
 				break;
+
+				case AnimNode::kSampledTransform:
+					anim_node = new SampledTransformAnimNode(*(static_cast<SampledTransformAnimNode*>(anim_node_iter->second)));
+				break;
+
+				case AnimNode::kCompressedTransform:
+					anim_node = new CompressedTransformAnimNode(*(static_cast<CompressedTransformAnimNode*>(anim_node_iter->second)));
+				break;
 			}
 
 			anim_nodes_[anim_node_iter->first] = anim_node;
@@ -392,6 +582,39 @@ namespace gef
 		}
 	}
 
+	bool Animation::Resample(const float sample_rate)
+	{
+		if(!(sample_rate > 0.0f))
+			return false;
+
+		for(std::map<StringId, AnimNode*>::iterator anim_node_iter=anim_nodes_.begin(); anim_node_iter != anim_nodes_.end(); ++anim_node_iter)
+		{
+			if(anim_node_iter->second->type() == AnimNode::kTransform)
+			{
+				SampledTransformAnimNode* sampled_node = new SampledTransformAnimNode();
+				sampled_node->Resample(*static_cast<TransformAnimNode*>(anim_node_iter->second), start_time_, end_time_, sample_rate);
+				delete anim_node_iter->second;
+				anim_node_iter->second = sampled_node;
+			}
+		}
+
+		return true;
+	}
+
+	void Animation::Compress(const float rotation_tolerance, const float translation_tolerance)
+	{
+		for(std::map<StringId, AnimNode*>::iterator anim_node_iter=anim_nodes_.begin(); anim_node_iter != anim_nodes_.end(); ++anim_node_iter)
+		{
+			if(anim_node_iter->second->type() == AnimNode::kTransform)
+			{
+				CompressedTransformAnimNode* compressed_node = new CompressedTransformAnimNode();
+				compressed_node->Compress(*static_cast<TransformAnimNode*>(anim_node_iter->second), rotation_tolerance, translation_tolerance);
+				delete anim_node_iter->second;
+				anim_node_iter->second = compressed_node;
+			}
+		}
+	}
+
 	bool Animation::Read(std::istream& stream)
 	{
 		stream.read((char*)&name_id_, sizeof(StringId));
@@ -420,6 +643,14 @@ namespace gef
 			case AnimNode::kChannel:
 				anim_node = new ChannelAnimNode();
 				break;
+
+			case AnimNode::kSampledTransform:
+				anim_node = new SampledTransformAnimNode();
+				break;
+
+			case AnimNode::kCompressedTransform:
+				anim_node = new CompressedTransformAnimNode();
+				break;
 			}
 
 			anim_node->set_name_id(name_id);
@@ -451,4 +682,20 @@ namespace gef
 
 		return true;
 	}
+
+	AnimationSamplingContext::AnimationSamplingContext()
+	{
+	}
+
+	void AnimationSamplingContext::Init(const Int32 track_count)
+	{
+		cursors_.resize(track_count);
+		Reset();
+	}
+
+	void AnimationSamplingContext::Reset()
+	{
+		for(std::vector<TransformAnimNodeCursor>::iterator cursor_iter = cursors_.begin(); cursor_iter != cursors_.end(); ++cursor_iter)
+			cursor_iter->Reset();
+	}
 }
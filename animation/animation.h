@@ -16,7 +16,9 @@ namespace gef
 		enum Type
 		{
 			kTransform = 0,
-			kChannel
+			kChannel,
+			kSampledTransform,
+			kCompressedTransform
 		};
 
 		AnimNode(Type type);
@@ -56,6 +58,77 @@ namespace gef
 		float time;
 	};
 
+	/// @brief Samples a track of keys, interpolating between the keys either side of the sample time.
+	/// @param[in] keys				The keys, in time order.
+	/// @param[in] num_keys			The number of keys.
+	/// @param[in] time				The time to sample the track at.
+	/// @param[in,out] key_cursor	Index of the key after the previous sample time, or zero. Updated for this sample.
+	/// @return The sampled value. Zero, or the identity rotation, if there are no keys.
+	const Vector4 SampleKeys(const Vector3Key* keys, const UInt32 num_keys, const float time, UInt32& key_cursor);
+	const Quaternion SampleKeys(const QuaternionKey* keys, const UInt32 num_keys, const float time, UInt32& key_cursor);
+
+	/// Gets the time of each key in an array of keys for FindNextKey.
+	template<class KeyType>
+	struct KeyTimes
+	{
+		KeyTimes(const KeyType* keys) : keys(keys) {}
+		inline float operator()(const UInt32 key_index) const { return keys[key_index].time; }
+
+		const KeyType* keys;
+	};
+
+	/// @brief Finds the first key with a time greater than the sample time. The key at the cursor and the one after it
+	/// are checked first, so sampling forwards rarely has to search.
+	/// @param[in] key_times		Gets the time of a key from its index, e.g. KeyTimes for an array of keys.
+	/// @param[in] num_keys			The number of keys.
+	/// @param[in] time				The sample time.
+	/// @param[in,out] key_cursor	The index returned last time, or zero. Set to the index returned.
+	/// @return The index of the key, or num_keys if there isn't one.
+	template<class GetKeyTime>
+	UInt32 FindNextKey(const GetKeyTime& key_times, const UInt32 num_keys, const float time, UInt32& key_cursor)
+	{
+		for (UInt32 key_index = key_cursor; key_index <= key_cursor + 1 && key_index <= num_keys; ++key_index)
+		{
+			if ((key_index == 0 || key_times(key_index - 1) <= time) && (key_index == num_keys || key_times(key_index) > time))
+			{
+				key_cursor = key_index;
+				return key_index;
+			}
+		}
+
+		UInt32 low = 0;
+		UInt32 high = num_keys;
+		while (low < high)
+		{
+			const UInt32 middle = (low + high) / 2;
+			if (key_times(middle) > time)
+				high = middle;
+			else
+				low = middle + 1;
+		}
+
+		key_cursor = low;
+		return low;
+	}
+
+	/**
+	Remembers which keys were used the last time each track of a TransformAnimNode was sampled.
+	The next sample starts looking from those keys, so playing forwards only ever has to check one or two keys.
+	Seeking or looping falls back to a binary search.
+	*/
+	struct TransformAnimNodeCursor
+	{
+		TransformAnimNodeCursor();
+
+		/// @brief Forgets the previous sample times.
+		void Reset();
+
+		/// Index of the first key after the time of the last sample for each track.
+		UInt32 scale_key;
+		UInt32 rotation_key;
+		UInt32 translation_key;
+	};
+
 	class TransformAnimNode : public AnimNode
 	{
 	public:
@@ -66,6 +139,13 @@ namespace gef
 		const Vector4 GetScale(const float time) const;
 		const Quaternion GetRotation(const float time) const;
 
+		/// @brief Samples a track starting from the keys used by the previous sample.
+		/// @param[in] time			The time to sample the track at.
+		/// @param[in,out] cursor	The keys used by the previous sample. Updated with the keys used by this one.
+		const Vector4 GetTranslation(const float time, TransformAnimNodeCursor& cursor) const;
+		const Vector4 GetScale(const float time, TransformAnimNodeCursor& cursor) const;
+		const Quaternion GetRotation(const float time, TransformAnimNodeCursor& cursor) const;
+
 		inline const std::vector<Vector3Key>& scale_keys() const {return scale_keys_;}
 		inline std::vector<Vector3Key>& scale_keys() { return const_cast<std::vector<Vector3Key>&>(static_cast<const TransformAnimNode&>(*this).scale_keys()); }
 		inline const std::vector<QuaternionKey>& rotation_keys() const {return rotation_keys_;}
@@ -79,13 +159,61 @@ namespace gef
 		bool Write(std::ostream& stream) const;
 
 	private:
-		const Vector4 GetVector(const float _time, const std::vector<Vector3Key>& keys) const;
+		const Vector4 GetVector(const float _time, const std::vector<Vector3Key>& keys, UInt32& key_cursor) const;
+		const Quaternion GetQuaternion(const float _time, const std::vector<QuaternionKey>& keys, UInt32& key_cursor) const;
 
 		std::vector<Vector3Key> scale_keys_;
 		std::vector<QuaternionKey> rotation_keys_;
 		std::vector<Vector3Key> translation_keys_;
 	};
 
+	/**
+	A transform animation stored as samples taken at a fixed rate instead of keys at arbitrary times.
+	Sampling it is an index calculation and one interpolation, with no searching for keys.
+	Each track holds either no samples, when it isn't animated, a single constant sample, or sample_count() samples.
+	*/
+	class SampledTransformAnimNode : public AnimNode
+	{
+	public:
+		SampledTransformAnimNode();
+		~SampledTransformAnimNode();
+
+		/// @brief Fills the tracks by sampling a keyed transform animation.
+		/// @param[in] node				The keyed animation. Its name is copied.
+		/// @param[in] start_time		The time of the first sample.
+		/// @param[in] end_time			The time to take samples up to. The last sample is taken at or just after this time.
+		/// @param[in] sample_rate		The number of samples per second. Must be positive.
+		/// @return false if the sample rate isn't positive, in which case the node is left as it was.
+		bool Resample(const TransformAnimNode& node, const float start_time, const float end_time, const float sample_rate);
+
+		const Vector4 GetTranslation(const float time) const;
+		const Vector4 GetScale(const float time) const;
+		const Quaternion GetRotation(const float time) const;
+
+		inline const std::vector<Vector4>& scales() const { return scales_; }
+		inline const std::vector<Quaternion>& rotations() const { return rotations_; }
+		inline const std::vector<Vector4>& translations() const { return translations_; }
+		inline float sample_rate() const { return sample_rate_; }
+		inline float start_time() const { return start_time_; }
+		inline UInt32 sample_count() const { return sample_count_; }
+
+		float GetMaximumKeyTime() const;
+
+		bool Read(std::istream& stream);
+		bool Write(std::ostream& stream) const;
+
+	private:
+		void GetSampleIndex(const float time, UInt32& sample_index, float& fraction) const;
+		const Vector4 GetVector(const float time, const std::vector<Vector4>& samples) const;
+
+		std::vector<Vector4> scales_;
+		std::vector<Quaternion> rotations_;
+		std::vector<Vector4> translations_;
+		float sample_rate_;
+		float start_time_;
+		UInt32 sample_count_;
+	};
+
 	class ChannelAnimNode : public AnimNode
 	{
 	public:
@@ -116,6 +244,16 @@ namespace gef
 		const AnimNode* FindNode(const StringId name) const;
 		void CalculateDuration();
 
+		/// @brief Replaces every TransformAnimNode with a SampledTransformAnimNode sampled between the start and end times.
+		/// @param[in] sample_rate		The number of samples per second. Must be positive.
+		/// @return false if the sample rate isn't positive, in which case the animation is left as it was.
+		bool Resample(const float sample_rate);
+
+		/// @brief Replaces every TransformAnimNode with a CompressedTransformAnimNode.
+		/// @param[in] rotation_tolerance		The largest allowed rotation error in radians.
+		/// @param[in] translation_tolerance	The largest allowed error in the translations and scales.
+		void Compress(const float rotation_tolerance, const float translation_tolerance);
+
 		bool Read(std::istream& stream);
 		bool Write(std::ostream& stream) const;
 
@@ -136,5 +274,28 @@ namespace gef
 		StringId name_id_;
 
 	};
+
+	/**
+	The state kept between samples of an Animation by one instance playing it, so that many instances
+	can share the same Animation. Owned by whatever is playing the animation for the instance.
+	*/
+	class AnimationSamplingContext
+	{
+	public:
+		AnimationSamplingContext();
+
+		/// @brief Sets the number of tracks and forgets the previous sample times.
+		/// @param[in] track_count		The number of tracks, one for each joint when sampling in to a SkeletonPose.
+		void Init(const Int32 track_count);
+
+		/// @brief Forgets the previous sample times, e.g. when a different animation starts playing.
+		void Reset();
+
+		inline Int32 track_count() const { return (Int32)cursors_.size(); }
+		inline TransformAnimNodeCursor& cursor(const Int32 track_index) { return cursors_[track_index]; }
+
+	private:
+		std::vector<TransformAnimNodeCursor> cursors_;
+	};
 }
 #endif // _GEF_ANIM_H
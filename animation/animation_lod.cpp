@@ -0,0 +1,143 @@
+#include <animation/animation_lod.h>
+#include <animation/animation.h>
+#include <animation/bone_mask.h>
+#include <graphics/skinned_mesh_instance.h>
+#include <graphics/mesh.h>
+#include <maths/sphere.h>
+#include <cfloat>
+
+namespace gef
+{
+	AnimationLod::AnimationLod()
+	{
+	}
+
+	void AnimationLod::AddLevel(const float min_screen_size, const Int32 update_interval, const BoneMask* bone_mask)
+	{
+		Level level;
+		level.min_screen_size = min_screen_size;
+		level.update_interval = update_interval;
+		level.bone_mask = bone_mask;
+		levels_.push_back(level);
+	}
+
+	Int32 AnimationLod::SelectLevel(const float screen_size) const
+	{
+		const Int32 level_count = (Int32)levels_.size();
+		for (Int32 level_num = 0; level_num < level_count; ++level_num)
+		{
+			if (screen_size >= levels_[level_num].min_screen_size)
+				return level_num;
+		}
+
+		return level_count - 1;
+	}
+
+	Int32 AnimationLod::SelectLevel(const SkinnedMeshInstance& mesh_instance, const Matrix44& view_matrix, const float projection_scale) const
+	{
+		// without a mesh there's nothing to measure, so use the most detailed level
+		if (!mesh_instance.mesh())
+			return 0;
+
+		const Sphere bounding_sphere = mesh_instance.mesh()->bounding_sphere().Transform(mesh_instance.transform());
+		return SelectLevel(CalculateScreenSize(bounding_sphere, view_matrix, projection_scale));
+	}
+
+	float AnimationLod::CalculateScreenSize(const Sphere& sphere, const Matrix44& view_matrix, const float projection_scale)
+	{
+		// the camera looks down the negative z axis in view space
+		const float distance = -sphere.position().Transform(view_matrix).z();
+		if (distance <= sphere.radius())
+			return FLT_MAX;
+
+		// the projection maps a height of one at this distance to projection_scale / distance of the screen's half height
+		return sphere.radius() * projection_scale / distance;
+	}
+
+	AnimationLodState::AnimationLodState() :
+		start_time_(0.0f),
+		target_time_(0.0f),
+		level_index_(-1),
+		frame_offset_(0)
+	{
+	}
+
+	void AnimationLodState::Init(const SkeletonPose& bind_pose, const Int32 frame_offset)
+	{
+		start_pose_ = bind_pose;
+		target_pose_ = bind_pose;
+		start_time_ = 0.0f;
+		target_time_ = 0.0f;
+		level_index_ = -1;
+		frame_offset_ = frame_offset;
+	}
+
+	void AnimationLodState::SamplePose(SkeletonPose& pose, const Animation& anim, const SkeletonPose& bind_pose, const float time, const AnimationLod::Level& level, AnimationSamplingContext* context)
+	{
+		if (level.bone_mask)
+			pose.SetPoseFromAnim(anim, bind_pose, time, *level.bone_mask, context, false);
+		else if (context)
+			pose.SetPoseFromAnim(anim, bind_pose, time, *context, false);
+		else
+			pose.SetPoseFromAnim(anim, bind_pose, time, false);
+	}
+
+	bool AnimationLodState::UpdatePose(SkeletonPose& pose, const Animation& anim, const SkeletonPose& bind_pose, const float time, const float time_step,
+		const AnimationLod& lod, const Int32 level_index, const UInt32 frame_number, AnimationSamplingContext* context)
+	{
+		const AnimationLod::Level& level = lod.level(level_index);
+		const Int32 update_interval = level.update_interval > 1 ? level.update_interval : 1;
+		const Int32 joint_count = (Int32)pose.local_pose().size();
+
+		// joints that aren't in the new level's mask won't be sampled any more, so put them back to the bind pose
+		const bool level_changed = level_index != level_index_;
+		if (level_changed && level.bone_mask)
+			pose.local_pose() = bind_pose.local_pose();
+		level_index_ = level_index;
+
+		if (update_interval == 1)
+		{
+			SamplePose(pose, anim, bind_pose, time, level, context);
+			pose.CalculateGlobalPose();
+			return true;
+		}
+
+		const Int32 mask_joint_count = level.bone_mask ? (Int32)level.bone_mask->joint_indices().size() : joint_count;
+
+		bool sampled = false;
+		if (level_changed || time < start_time_ || time > target_time_)
+		{
+			// start from the current animation rather than blending from a pose that could be a long way from it
+			SamplePose(pose, anim, bind_pose, time, level, context);
+			sampled = true;
+		}
+		else
+		{
+			// blend between the two samples by how far through the interval the current time is
+			const float blend = target_time_ > start_time_ ? (time - start_time_) / (target_time_ - start_time_) : 1.0f;
+			for (Int32 mask_joint_num = 0; mask_joint_num < mask_joint_count; ++mask_joint_num)
+			{
+				const Int32 joint_index = level.bone_mask ? level.bone_mask->joint_indices()[mask_joint_num] : mask_joint_num;
+				pose.local_pose()[joint_index].Linear2TransformBlend(start_pose_.local_pose()[joint_index], target_pose_.local_pose()[joint_index], blend);
+			}
+		}
+
+		// on update frames, sample the pose at the next update to blend towards from the current one
+		if (sampled || (frame_number + frame_offset_) % update_interval == 0)
+		{
+			for (Int32 mask_joint_num = 0; mask_joint_num < mask_joint_count; ++mask_joint_num)
+			{
+				const Int32 joint_index = level.bone_mask ? level.bone_mask->joint_indices()[mask_joint_num] : mask_joint_num;
+				start_pose_.local_pose()[joint_index] = pose.local_pose()[joint_index];
+			}
+
+			start_time_ = time;
+			target_time_ = time + update_interval*time_step;
+			SamplePose(target_pose_, anim, bind_pose, target_time_, level, context);
+			sampled = true;
+		}
+
+		pose.CalculateGlobalPose();
+		return sampled;
+	}
+}
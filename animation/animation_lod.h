@@ -0,0 +1,115 @@
+#ifndef _GEF_ANIMATION_LOD_H
+#define _GEF_ANIMATION_LOD_H
+
+#include <gef.h>
+#include <animation/skeleton.h>
+#include <vector>
+
+namespace gef
+{
+	// forward declarations
+	class Animation;
+	class AnimationSamplingContext;
+	class BoneMask;
+	class SkinnedMeshInstance;
+	class Sphere;
+	class Matrix44;
+
+	/**
+	Levels of detail for animating characters, chosen by how large a character is on screen.
+	Lower levels sample the animation less often and can leave joints that can't be seen, e.g. fingers, at their bind pose.
+	*/
+	class AnimationLod
+	{
+	public:
+		struct Level
+		{
+			/// The smallest screen size this level is used for, as a fraction of the screen height. See CalculateScreenSize.
+			float min_screen_size;
+
+			/// The number of frames between each time the animation is sampled. One samples every frame.
+			Int32 update_interval;
+
+			/// The joints that are animated, or NULL for every joint. Joints outside the mask are left at the bind pose.
+			const BoneMask* bone_mask;
+		};
+
+		AnimationLod();
+
+		/// @brief Adds a level. Levels must be added from the largest screen size to the smallest.
+		void AddLevel(const float min_screen_size, const Int32 update_interval, const BoneMask* bone_mask = NULL);
+
+		/// @brief Chooses the level for a screen size.
+		/// @return The first level whose min_screen_size the screen size reaches, or the last level if it doesn't reach any.
+		Int32 SelectLevel(const float screen_size) const;
+
+		/// @brief Chooses the level for a skinned mesh instance from the bounding sphere of its mesh.
+		/// @param[in] mesh_instance		The instance. Its transform places the mesh's bounding sphere in the world.
+		/// @param[in] view_matrix			The camera's view matrix.
+		/// @param[in] projection_scale		The vertical scale of the projection matrix, i.e. element (1,1).
+		Int32 SelectLevel(const SkinnedMeshInstance& mesh_instance, const Matrix44& view_matrix, const float projection_scale) const;
+
+		/// @brief Calculates the height of a sphere on screen as a fraction of the screen height.
+		/// @param[in] sphere				The sphere in world space.
+		/// @param[in] view_matrix			The camera's view matrix.
+		/// @param[in] projection_scale		The vertical scale of the projection matrix, i.e. element (1,1).
+		/// @return The size, or FLT_MAX if the camera is inside the sphere.
+		static float CalculateScreenSize(const Sphere& sphere, const Matrix44& view_matrix, const float projection_scale);
+
+		inline Int32 level_count() const { return (Int32)levels_.size(); }
+		inline const Level& level(const Int32 index) const { return levels_[index]; }
+
+	private:
+		std::vector<Level> levels_;
+	};
+
+	/**
+	The animation state of one character using an AnimationLod.
+	When a level samples less often than every frame, the pose is sampled ahead at the time of the next update and
+	blended towards from the pose shown when it was sampled, so the character keeps moving smoothly in between.
+	*/
+	class AnimationLodState
+	{
+	public:
+		AnimationLodState();
+
+		/// @brief Allocates the poses for a skeleton.
+		/// @param[in] bind_pose		The bind pose of the character's skeleton.
+		/// @param[in] frame_offset		Added to the frame number when choosing the frames to sample on, so characters on the
+		///								same level can be spread across different frames.
+		void Init(const SkeletonPose& bind_pose, const Int32 frame_offset);
+
+		/// @brief Updates the pose of the character.
+		/// @param[in,out] pose			The character's pose. Must be the same pose each frame. The global pose is calculated.
+		/// @param[in] anim				The animation.
+		/// @param[in] bind_pose		The bind pose.
+		/// @param[in] time				The time in the animation.
+		/// @param[in] time_step		The time the animation moves on by each frame, used to work out the time of the next update.
+		/// @param[in] lod				The levels of detail.
+		/// @param[in] level_index		The index of the level to use, e.g. from AnimationLod::SelectLevel.
+		/// @param[in] frame_number		A number that goes up by one each frame.
+		/// @param[in,out] context		If not NULL, the sampling state for the character.
+		/// @return true if the animation was sampled this frame.
+		bool UpdatePose(SkeletonPose& pose, const Animation& anim, const SkeletonPose& bind_pose, const float time, const float time_step,
+			const AnimationLod& lod, const Int32 level_index, const UInt32 frame_number, AnimationSamplingContext* context = NULL);
+
+		/// @brief Makes the next update sample the animation, e.g. when a different animation starts playing.
+		inline void Reset() { level_index_ = -1; }
+
+	private:
+		void SamplePose(SkeletonPose& pose, const Animation& anim, const SkeletonPose& bind_pose, const float time, const AnimationLod::Level& level, AnimationSamplingContext* context);
+
+		/// The pose when the current target was sampled and the pose at the next update.
+		SkeletonPose start_pose_;
+		SkeletonPose target_pose_;
+		float start_time_;
+		float target_time_;
+
+		/// The index of the level used by the last update, or -1 if the next update must sample the animation.
+		/// An index rather than a pointer, as adding levels to the AnimationLod moves them.
+		Int32 level_index_;
+		Int32 frame_offset_;
+	};
+}
+
+#endif // _GEF_ANIMATION_LOD_H
@@ -0,0 +1,158 @@
+#include <animation/baked_animation.h>
+#include <animation/skeleton.h>
+#include <animation/compressed_anim_node.h>
+
+namespace gef
+{
+	BakedAnimation::BakedAnimation() :
+		skeleton_(NULL),
+		duration_(0.0f),
+		start_time_(0.0f),
+		end_time_(0.0f),
+		name_id_(0)
+	{
+	}
+
+	void BakedAnimation::Bake(const Animation& animation, const SkeletonPose& bind_pose)
+	{
+		skeleton_ = bind_pose.skeleton();
+		duration_ = animation.duration();
+		start_time_ = animation.start_time();
+		end_time_ = animation.end_time();
+		name_id_ = animation.name_id();
+
+		joint_tracks_.clear();
+		default_pose_.clear();
+		rotation_keys_.clear();
+		translation_keys_.clear();
+
+		if(!skeleton_)
+			return;
+
+		const Int32 joint_count = skeleton_->joint_count();
+		joint_tracks_.resize(joint_count);
+		default_pose_.resize(joint_count);
+
+		for(Int32 joint_index = 0; joint_index < joint_count; ++joint_index)
+		{
+			JointTracks& tracks = joint_tracks_[joint_index];
+			JointPose& default_pose = default_pose_[joint_index];
+
+			tracks.flags = 0;
+			tracks.first_rotation_key = (UInt32)rotation_keys_.size();
+			tracks.rotation_key_count = 0;
+			tracks.first_translation_key = (UInt32)translation_keys_.size();
+			tracks.translation_key_count = 0;
+			default_pose = bind_pose.local_pose()[joint_index];
+
+			const AnimNode* anim_node = animation.FindNode(skeleton_->joint(joint_index).name_id);
+			if(!anim_node || anim_node->type() == AnimNode::kChannel)
+				continue;
+
+			// animated joints always have a scale of one, as they do in SkeletonPose::SetPoseFromAnim
+			default_pose.set_scale(gef::Vector4(1.f, 1.f, 1.f));
+
+			if(anim_node->type() == AnimNode::kTransform)
+			{
+				const TransformAnimNode* transform_node = static_cast<const TransformAnimNode*>(anim_node);
+
+				if(transform_node->rotation_keys().size() > 0)
+				{
+					tracks.flags |= kRotationTrack;
+					tracks.rotation_key_count = (UInt32)transform_node->rotation_keys().size();
+					rotation_keys_.insert(rotation_keys_.end(), transform_node->rotation_keys().begin(), transform_node->rotation_keys().end());
+				}
+
+				if(transform_node->translation_keys().size() > 0)
+				{
+					tracks.flags |= kTranslationTrack;
+					tracks.translation_key_count = (UInt32)transform_node->translation_keys().size();
+					translation_keys_.insert(translation_keys_.end(), transform_node->translation_keys().begin(), transform_node->translation_keys().end());
+				}
+			}
+			else if(anim_node->type() == AnimNode::kCompressedTransform)
+			{
+				const CompressedTransformAnimNode* compressed_node = static_cast<const CompressedTransformAnimNode*>(anim_node);
+
+				if(compressed_node->rotation_key_count() > 0)
+				{
+					std::vector<QuaternionKey> keys;
+					compressed_node->GetRotationKeys(keys);
+					tracks.flags |= kRotationTrack;
+					tracks.rotation_key_count = (UInt32)keys.size();
+					rotation_keys_.insert(rotation_keys_.end(), keys.begin(), keys.end());
+				}
+
+				if(compressed_node->translation_key_count() > 0)
+				{
+					std::vector<Vector3Key> keys;
+					compressed_node->GetTranslationKeys(keys);
+					tracks.flags |= kTranslationTrack;
+					tracks.translation_key_count = (UInt32)keys.size();
+					translation_keys_.insert(translation_keys_.end(), keys.begin(), keys.end());
+				}
+			}
+			else
+			{
+				// turn the samples back in to keys. Sampling them with a cursor still only looks at one or two keys
+				const SampledTransformAnimNode* sampled_node = static_cast<const SampledTransformAnimNode*>(anim_node);
+				const float sample_interval = sampled_node->sample_rate() > 0.0f ? 1.0f / sampled_node->sample_rate() : 0.0f;
+
+				if(sampled_node->rotations().size() > 0)
+				{
+					tracks.flags |= kRotationTrack;
+					tracks.rotation_key_count = (UInt32)sampled_node->rotations().size();
+					for(UInt32 sample_num = 0; sample_num < tracks.rotation_key_count; ++sample_num)
+					{
+						QuaternionKey key;
+						key.value = sampled_node->rotations()[sample_num];
+						key.time = sampled_node->start_time() + sample_num*sample_interval;
+						rotation_keys_.push_back(key);
+					}
+				}
+
+				if(sampled_node->translations().size() > 0)
+				{
+					tracks.flags |= kTranslationTrack;
+					tracks.translation_key_count = (UInt32)sampled_node->translations().size();
+					for(UInt32 sample_num = 0; sample_num < tracks.translation_key_count; ++sample_num)
+					{
+						Vector3Key key;
+						key.value = sampled_node->translations()[sample_num];
+						key.time = sampled_node->start_time() + sample_num*sample_interval;
+						translation_keys_.push_back(key);
+					}
+				}
+			}
+		}
+	}
+
+	void BakedAnimation::SampleLocalPose(const float time, JointPose* local_pose, AnimationSamplingContext* context) const
+	{
+		const Int32 joint_count = (Int32)joint_tracks_.size();
+		if(context && context->track_count() != joint_count)
+			context->Init(joint_count);
+
+		const QuaternionKey* rotation_keys = rotation_keys_.empty() ? NULL : &rotation_keys_[0];
+		const Vector3Key* translation_keys = translation_keys_.empty() ? NULL : &translation_keys_[0];
+
+		for(Int32 joint_index = 0; joint_index < joint_count; ++joint_index)
+		{
+			const JointTracks& tracks = joint_tracks_[joint_index];
+			JointPose& joint_pose = local_pose[joint_index];
+
+			joint_pose = default_pose_[joint_index];
+			if(tracks.flags == 0)
+				continue;
+
+			TransformAnimNodeCursor search_cursor;
+			TransformAnimNodeCursor& cursor = context ? context->cursor(joint_index) : search_cursor;
+
+			if(tracks.flags & kRotationTrack)
+				joint_pose.set_rotation(SampleKeys(rotation_keys + tracks.first_rotation_key, tracks.rotation_key_count, time, cursor.rotation_key));
+
+			if(tracks.flags & kTranslationTrack)
+				joint_pose.set_translation(SampleKeys(translation_keys + tracks.first_translation_key, tracks.translation_key_count, time, cursor.translation_key));
+		}
+	}
+}
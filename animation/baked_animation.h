@@ -0,0 +1,94 @@
+#ifndef _GEF_BAKED_ANIMATION_H
+#define _GEF_BAKED_ANIMATION_H
+
+#include <gef.h>
+#include <animation/animation.h>
+#include <animation/joint.h>
+#include <vector>
+
+namespace gef
+{
+	class Skeleton;
+	class SkeletonPose;
+
+	/**
+	An Animation bound to a Skeleton, with the tracks stored in skeleton joint order.
+	The name lookups are done once when the animation is baked, so sampling a pose is a single pass over the
+	joints with no map lookups or virtual calls. Joints that aren't animated are left at their bind pose.
+	The keys are copied so the Animation doesn't need to be kept once it has been baked.
+	*/
+	class BakedAnimation
+	{
+	public:
+		/// Flags for the tracks a joint has keys for.
+		enum JointTrackFlags
+		{
+			kRotationTrack = 1,
+			kTranslationTrack = 2
+		};
+
+		/// @brief Default constructor. Creates an empty animation.
+		BakedAnimation();
+
+		/// @brief Binds an animation to the skeleton of a bind pose.
+		/// @param[in] animation	The animation.
+		/// @param[in] bind_pose	The bind pose. Provides the skeleton and the pose for anything that isn't animated.
+		/// @note Any previous contents are discarded.
+		void Bake(const Animation& animation, const SkeletonPose& bind_pose);
+
+		/// @brief Samples the local pose of every joint.
+		/// @param[in] time				The time to sample the animation at.
+		/// @param[out] local_pose		Receives a pose for each joint in the skeleton.
+		/// @param[in,out] context		If not NULL, the keys used by the previous sample, which are updated for this one.
+		///								Initialised if it doesn't match the skeleton.
+		/// @note The same as SkeletonPose::SetPoseFromAnim with the unbaked animation, including the scale of animated joints being one.
+		void SampleLocalPose(const float time, JointPose* local_pose, AnimationSamplingContext* context = NULL) const;
+
+		/// @brief Get the number of joints in the skeleton the animation was baked for.
+		inline Int32 joint_count() const { return (Int32)joint_tracks_.size(); }
+
+		/// @brief Get the skeleton the animation was baked for.
+		inline const Skeleton* skeleton() const { return skeleton_; }
+
+		/// @brief Get the JointTrackFlags of a joint. Zero for joints that stay at their bind pose.
+		inline UInt32 joint_track_flags(const Int32 joint_index) const { return joint_tracks_[joint_index].flags; }
+
+		inline float duration() const { return duration_; }
+		inline float start_time() const { return start_time_; }
+		inline float end_time() const { return end_time_; }
+		inline StringId name_id() const { return name_id_; }
+
+	private:
+		struct JointTracks
+		{
+			/// JointTrackFlags for the tracks this joint has keys for.
+			UInt32 flags;
+
+			/// Range of this joint's keys in rotation_keys_.
+			UInt32 first_rotation_key;
+			UInt32 rotation_key_count;
+
+			/// Range of this joint's keys in translation_keys_.
+			UInt32 first_translation_key;
+			UInt32 translation_key_count;
+		};
+
+		/// The tracks of each joint, in skeleton order.
+		std::vector<JointTracks> joint_tracks_;
+
+		/// The pose of each joint with everything that isn't animated already set.
+		std::vector<JointPose> default_pose_;
+
+		/// The keys of every joint, in skeleton order.
+		std::vector<QuaternionKey> rotation_keys_;
+		std::vector<Vector3Key> translation_keys_;
+
+		const Skeleton* skeleton_;
+		float duration_;
+		float start_time_;
+		float end_time_;
+		StringId name_id_;
+	};
+}
+
+#endif // _GEF_BAKED_ANIMATION_H
@@ -0,0 +1,353 @@
+#include <animation/blend_tree.h>
+#include <animation/skeleton.h>
+#include <animation/baked_animation.h>
+
+namespace gef
+{
+	// blends two local poses, writing the result over the start pose
+	static void BlendLocalPoses(JointPose* start_pose, const JointPose* end_pose, const float weight, const Int32 joint_count)
+	{
+		for (Int32 joint_num = 0; joint_num < joint_count; ++joint_num)
+		{
+			const JointPose start = start_pose[joint_num];
+			start_pose[joint_num].Linear2TransformBlend(start, end_pose[joint_num], weight);
+		}
+	}
+
+	BlendNode::BlendNode()
+	{
+	}
+
+	BlendNode::~BlendNode()
+	{
+	}
+
+	ClipBlendNode::ClipBlendNode() :
+		animation_(NULL),
+		baked_animation_(NULL),
+		time_(0.0f)
+	{
+	}
+
+	void ClipBlendNode::set_animation(const Animation* animation)
+	{
+		animation_ = animation;
+		context_.Reset();
+	}
+
+	void ClipBlendNode::set_baked_animation(const BakedAnimation* baked_animation)
+	{
+		baked_animation_ = baked_animation;
+		context_.Reset();
+	}
+
+	void ClipBlendNode::Evaluate(BlendTree& tree, JointPose* local_pose, const Int32 /*scratch_index*/)
+	{
+		const SkeletonPose& bind_pose = *tree.bind_pose();
+
+		if (baked_animation_ && baked_animation_->skeleton() == bind_pose.skeleton())
+			baked_animation_->SampleLocalPose(time_, local_pose, &context_);
+		else if (animation_)
+			SkeletonPose::SampleLocalPose(*animation_, bind_pose, time_, local_pose, &context_);
+		else
+		{
+			for (Int32 joint_num = 0; joint_num < tree.joint_count(); ++joint_num)
+				local_pose[joint_num] = bind_pose.local_pose()[joint_num];
+		}
+	}
+
+	LerpBlendNode::LerpBlendNode(BlendNode* start, BlendNode* end) :
+		start_(start),
+		end_(end),
+		weight_(0.0f)
+	{
+	}
+
+	LerpBlendNode::~LerpBlendNode()
+	{
+		delete start_;
+		delete end_;
+	}
+
+	void LerpBlendNode::Evaluate(BlendTree& tree, JointPose* local_pose, const Int32 scratch_index)
+	{
+		if (weight_ <= 0.0f)
+		{
+			start_->Evaluate(tree, local_pose, scratch_index);
+		}
+		else if (weight_ >= 1.0f)
+		{
+			end_->Evaluate(tree, local_pose, scratch_index);
+		}
+		else
+		{
+			JointPose* end_pose = tree.scratch_pose(scratch_index);
+			start_->Evaluate(tree, local_pose, scratch_index);
+			end_->Evaluate(tree, end_pose, scratch_index + 1);
+			BlendLocalPoses(local_pose, end_pose, weight_, tree.joint_count());
+		}
+	}
+
+	Int32 LerpBlendNode::GetScratchPoseCount() const
+	{
+		const Int32 start_count = start_->GetScratchPoseCount();
+		const Int32 end_count = end_->GetScratchPoseCount() + 1;
+		return start_count > end_count ? start_count : end_count;
+	}
+
+	AdditiveBlendNode::AdditiveBlendNode(BlendNode* base, BlendNode* additive, const SkeletonPose& reference_pose) :
+		base_(base),
+		additive_(additive),
+		reference_pose_(&reference_pose),
+		weight_(1.0f)
+	{
+	}
+
+	AdditiveBlendNode::~AdditiveBlendNode()
+	{
+		delete base_;
+		delete additive_;
+	}
+
+	void AdditiveBlendNode::Evaluate(BlendTree& tree, JointPose* local_pose, const Int32 scratch_index)
+	{
+		base_->Evaluate(tree, local_pose, scratch_index);
+		if (weight_ <= 0.0f)
+			return;
+
+		JointPose* additive_pose = tree.scratch_pose(scratch_index);
+		additive_->Evaluate(tree, additive_pose, scratch_index + 1);
+
+		const std::vector<JointPose>& reference_pose = reference_pose_->local_pose();
+		for (Int32 joint_num = 0; joint_num < tree.joint_count(); ++joint_num)
+			AddJointPose(local_pose[joint_num], additive_pose[joint_num], reference_pose[joint_num], weight_);
+	}
+
+	Int32 AdditiveBlendNode::GetScratchPoseCount() const
+	{
+		const Int32 base_count = base_->GetScratchPoseCount();
+		const Int32 additive_count = additive_->GetScratchPoseCount() + 1;
+		return base_count > additive_count ? base_count : additive_count;
+	}
+
+	BlendSpace1DNode::BlendSpace1DNode() :
+		parameter_(0.0f)
+	{
+	}
+
+	BlendSpace1DNode::~BlendSpace1DNode()
+	{
+		for (std::vector<BlendNode*>::iterator child_iter = children_.begin(); child_iter != children_.end(); ++child_iter)
+			delete *child_iter;
+	}
+
+	void BlendSpace1DNode::AddChild(BlendNode* child, const float position)
+	{
+		children_.push_back(child);
+		positions_.push_back(position);
+	}
+
+	void BlendSpace1DNode::Evaluate(BlendTree& tree, JointPose* local_pose, const Int32 scratch_index)
+	{
+		const Int32 child_count = (Int32)children_.size();
+		if (child_count == 0)
+		{
+			for (Int32 joint_num = 0; joint_num < tree.joint_count(); ++joint_num)
+				local_pose[joint_num] = tree.bind_pose()->local_pose()[joint_num];
+			return;
+		}
+
+		// clamp to the children at either end
+		if (parameter_ <= positions_.front())
+		{
+			children_.front()->Evaluate(tree, local_pose, scratch_index);
+			return;
+		}
+		if (parameter_ >= positions_.back())
+		{
+			children_.back()->Evaluate(tree, local_pose, scratch_index);
+			return;
+		}
+
+		Int32 end_child = 1;
+		while (positions_[end_child] < parameter_)
+			++end_child;
+
+		const float range = positions_[end_child] - positions_[end_child - 1];
+		const float weight = range > 0.0f ? (parameter_ - positions_[end_child - 1]) / range : 1.0f;
+		if (weight >= 1.0f)
+		{
+			children_[end_child]->Evaluate(tree, local_pose, scratch_index);
+		}
+		else
+		{
+			JointPose* end_pose = tree.scratch_pose(scratch_index);
+			children_[end_child - 1]->Evaluate(tree, local_pose, scratch_index);
+			children_[end_child]->Evaluate(tree, end_pose, scratch_index + 1);
+			BlendLocalPoses(local_pose, end_pose, weight, tree.joint_count());
+		}
+	}
+
+	Int32 BlendSpace1DNode::GetScratchPoseCount() const
+	{
+		Int32 scratch_pose_count = 0;
+		for (std::vector<BlendNode*>::const_iterator child_iter = children_.begin(); child_iter != children_.end(); ++child_iter)
+		{
+			const Int32 child_count = (*child_iter)->GetScratchPoseCount() + 1;
+			if (child_count > scratch_pose_count)
+				scratch_pose_count = child_count;
+		}
+
+		return scratch_pose_count;
+	}
+
+	BlendSpace2DNode::BlendSpace2DNode() :
+		parameter_x_(0.0f),
+		parameter_y_(0.0f)
+	{
+	}
+
+	BlendSpace2DNode::~BlendSpace2DNode()
+	{
+		for (std::vector<BlendNode*>::iterator child_iter = children_.begin(); child_iter != children_.end(); ++child_iter)
+			delete *child_iter;
+	}
+
+	void BlendSpace2DNode::AddChild(BlendNode* child, const float x, const float y)
+	{
+		children_.push_back(child);
+		positions_x_.push_back(x);
+		positions_y_.push_back(y);
+		weights_.push_back(0.0f);
+	}
+
+	void BlendSpace2DNode::CalculateWeights(float* weights) const
+	{
+		const Int32 child_count = (Int32)children_.size();
+
+		// each child's weight falls from one at its own position to zero at the position of any other child,
+		// measured along the line between the two
+		float total_weight = 0.0f;
+		for (Int32 child_num = 0; child_num < child_count; ++child_num)
+		{
+			const float to_parameter_x = parameter_x_ - positions_x_[child_num];
+			const float to_parameter_y = parameter_y_ - positions_y_[child_num];
+
+			float weight = 1.0f;
+			for (Int32 other_num = 0; other_num < child_count && weight > 0.0f; ++other_num)
+			{
+				if (other_num == child_num)
+					continue;
+
+				const float to_other_x = positions_x_[other_num] - positions_x_[child_num];
+				const float to_other_y = positions_y_[other_num] - positions_y_[child_num];
+				const float length_squared = to_other_x*to_other_x + to_other_y*to_other_y;
+				if (length_squared <= 0.0f)
+					continue;
+
+				const float band_weight = 1.0f - (to_parameter_x*to_other_x + to_parameter_y*to_other_y) / length_squared;
+				if (band_weight < weight)
+					weight = band_weight;
+			}
+
+			weights[child_num] = weight > 0.0f ? weight : 0.0f;
+			total_weight += weights[child_num];
+		}
+
+		if (total_weight > 0.0f)
+		{
+			for (Int32 child_num = 0; child_num < child_count; ++child_num)
+				weights[child_num] /= total_weight;
+		}
+	}
+
+	void BlendSpace2DNode::Evaluate(BlendTree& tree, JointPose* local_pose, const Int32 scratch_index)
+	{
+		const Int32 child_count = (Int32)children_.size();
+		if (child_count == 0)
+		{
+			for (Int32 joint_num = 0; joint_num < tree.joint_count(); ++joint_num)
+				local_pose[joint_num] = tree.bind_pose()->local_pose()[joint_num];
+			return;
+		}
+
+		CalculateWeights(&weights_[0]);
+
+		// the first child with any weight is evaluated straight in to the result, then each of the others is blended in
+		// by its share of the weight so far
+		float total_weight = 0.0f;
+		JointPose* child_pose = tree.scratch_pose(scratch_index);
+		for (Int32 child_num = 0; child_num < child_count; ++child_num)
+		{
+			const float weight = weights_[child_num];
+			if (weight <= 0.0f)
+				continue;
+
+			total_weight += weight;
+			if (total_weight == weight)
+			{
+				children_[child_num]->Evaluate(tree, local_pose, scratch_index);
+			}
+			else
+			{
+				children_[child_num]->Evaluate(tree, child_pose, scratch_index + 1);
+				BlendLocalPoses(local_pose, child_pose, weight / total_weight, tree.joint_count());
+			}
+		}
+
+		if (total_weight <= 0.0f)
+		{
+			for (Int32 joint_num = 0; joint_num < tree.joint_count(); ++joint_num)
+				local_pose[joint_num] = tree.bind_pose()->local_pose()[joint_num];
+		}
+	}
+
+	Int32 BlendSpace2DNode::GetScratchPoseCount() const
+	{
+		Int32 scratch_pose_count = 0;
+		for (std::vector<BlendNode*>::const_iterator child_iter = children_.begin(); child_iter != children_.end(); ++child_iter)
+		{
+			const Int32 child_count = (*child_iter)->GetScratchPoseCount() + 1;
+			if (child_count > scratch_pose_count)
+				scratch_pose_count = child_count;
+		}
+
+		return scratch_pose_count;
+	}
+
+	BlendTree::BlendTree() :
+		bind_pose_(NULL),
+		root_(NULL),
+		joint_count_(0)
+	{
+	}
+
+	BlendTree::~BlendTree()
+	{
+		delete root_;
+	}
+
+	void BlendTree::Init(const SkeletonPose& bind_pose, BlendNode* root)
+	{
+		if (root != root_)
+			delete root_;
+
+		bind_pose_ = &bind_pose;
+		root_ = root;
+		joint_count_ = (Int32)bind_pose.local_pose().size();
+
+		const Int32 scratch_pose_count = root_ ? root_->GetScratchPoseCount() : 0;
+		scratch_poses_.resize(scratch_pose_count * joint_count_);
+	}
+
+	void BlendTree::Evaluate(SkeletonPose& pose, const bool update_global_pose, const Matrix44* pose_transform)
+	{
+		if (!root_ || joint_count_ == 0 || (Int32)pose.local_pose().size() != joint_count_)
+			return;
+
+		root_->Evaluate(*this, &pose.local_pose()[0], 0);
+
+		if (update_global_pose)
+			pose.CalculateGlobalPose(pose_transform);
+	}
+}
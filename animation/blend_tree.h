@@ -0,0 +1,215 @@
+#ifndef _GEF_BLEND_TREE_H
+#define _GEF_BLEND_TREE_H
+
+#include <gef.h>
+#include <animation/animation.h>
+#include <animation/joint.h>
+#include <vector>
+
+namespace gef
+{
+	// forward declarations
+	class BakedAnimation;
+	class SkeletonPose;
+	class BlendTree;
+	class Matrix44;
+
+	/**
+	A node in a BlendTree that produces a local pose for every joint in the tree's skeleton.
+	Nodes with children own them and delete them when they are deleted.
+	*/
+	class BlendNode
+	{
+	public:
+		BlendNode();
+		virtual ~BlendNode();
+
+		/// @brief Calculates the local pose.
+		/// @param[in] tree				The tree being evaluated, which provides the bind pose and scratch poses.
+		/// @param[out] local_pose		Receives a pose for each joint.
+		/// @param[in] scratch_index	The first of the tree's scratch poses this node and its children can use.
+		virtual void Evaluate(BlendTree& tree, JointPose* local_pose, const Int32 scratch_index) = 0;
+
+		/// @brief Gets the number of scratch poses needed to evaluate this node and its children.
+		virtual Int32 GetScratchPoseCount() const = 0;
+	};
+
+	/**
+	Samples an Animation, or a BakedAnimation if one is set.
+	*/
+	class ClipBlendNode : public BlendNode
+	{
+	public:
+		ClipBlendNode();
+
+		void Evaluate(BlendTree& tree, JointPose* local_pose, const Int32 scratch_index);
+		Int32 GetScratchPoseCount() const { return 0; }
+
+		/// @brief Sets the animation to sample. Resets the sampling context.
+		void set_animation(const Animation* animation);
+
+		/// @brief Sets a baked animation to sample instead of an Animation. Resets the sampling context.
+		void set_baked_animation(const BakedAnimation* baked_animation);
+
+		inline const Animation* animation() const { return animation_; }
+		inline const BakedAnimation* baked_animation() const { return baked_animation_; }
+		inline void set_time(const float time) { time_ = time; }
+		inline float time() const { return time_; }
+
+	private:
+		const Animation* animation_;
+		const BakedAnimation* baked_animation_;
+		float time_;
+		AnimationSamplingContext context_;
+	};
+
+	/**
+	Blends from one pose to another by a weight. Only one child is evaluated when the weight is zero or one.
+	*/
+	class LerpBlendNode : public BlendNode
+	{
+	public:
+		/// @param[in] start	The pose for a weight of zero. Owned by this node.
+		/// @param[in] end		The pose for a weight of one. Owned by this node.
+		LerpBlendNode(BlendNode* start, BlendNode* end);
+		~LerpBlendNode();
+
+		void Evaluate(BlendTree& tree, JointPose* local_pose, const Int32 scratch_index);
+		Int32 GetScratchPoseCount() const;
+
+		inline void set_weight(const float weight) { weight_ = weight; }
+		inline float weight() const { return weight_; }
+
+	private:
+		BlendNode* start_;
+		BlendNode* end_;
+		float weight_;
+	};
+
+	/**
+	Adds the difference between a pose and a reference pose on to a base pose, scaled by a weight.
+	The additive child isn't evaluated when the weight is zero.
+	*/
+	class AdditiveBlendNode : public BlendNode
+	{
+	public:
+		/// @param[in] base				The pose to add to. Owned by this node.
+		/// @param[in] additive			The pose whose difference from the reference pose is added. Owned by this node.
+		/// @param[in] reference_pose	The pose the additive pose is relative to, e.g. its first frame or the bind pose. Must outlive this node.
+		AdditiveBlendNode(BlendNode* base, BlendNode* additive, const SkeletonPose& reference_pose);
+		~AdditiveBlendNode();
+
+		void Evaluate(BlendTree& tree, JointPose* local_pose, const Int32 scratch_index);
+		Int32 GetScratchPoseCount() const;
+
+		inline void set_weight(const float weight) { weight_ = weight; }
+		inline float weight() const { return weight_; }
+
+	private:
+		BlendNode* base_;
+		BlendNode* additive_;
+		const SkeletonPose* reference_pose_;
+		float weight_;
+	};
+
+	/**
+	Blends the children nearest to a parameter value, e.g. walk and run animations by speed.
+	Only the two children either side of the parameter are evaluated.
+	*/
+	class BlendSpace1DNode : public BlendNode
+	{
+	public:
+		BlendSpace1DNode();
+		~BlendSpace1DNode();
+
+		/// @brief Adds a child at a position in the blend space. Children must be added in increasing position order.
+		/// @param[in] child		The child. Owned by this node.
+		/// @param[in] position		The parameter value the child is played at on its own.
+		void AddChild(BlendNode* child, const float position);
+
+		void Evaluate(BlendTree& tree, JointPose* local_pose, const Int32 scratch_index);
+		Int32 GetScratchPoseCount() const;
+
+		inline void set_parameter(const float parameter) { parameter_ = parameter; }
+		inline float parameter() const { return parameter_; }
+
+	private:
+		std::vector<BlendNode*> children_;
+		std::vector<float> positions_;
+		float parameter_;
+	};
+
+	/**
+	Blends children placed anywhere in a two dimensional blend space, e.g. locomotion by forward and sideways speed.
+	Weights use gradient band interpolation, so playing at a child's position gives just that child and children
+	with no weight aren't evaluated.
+	*/
+	class BlendSpace2DNode : public BlendNode
+	{
+	public:
+		BlendSpace2DNode();
+		~BlendSpace2DNode();
+
+		/// @brief Adds a child at a position in the blend space.
+		/// @param[in] child		The child. Owned by this node.
+		/// @param[in] x, y			The parameter values the child is played at on its own.
+		void AddChild(BlendNode* child, const float x, const float y);
+
+		void Evaluate(BlendTree& tree, JointPose* local_pose, const Int32 scratch_index);
+		Int32 GetScratchPoseCount() const;
+
+		/// @brief Calculates the weight of each child for the current parameters. The weights add up to one.
+		void CalculateWeights(float* weights) const;
+
+		inline void set_parameters(const float x, const float y) { parameter_x_ = x; parameter_y_ = y; }
+		inline float parameter_x() const { return parameter_x_; }
+		inline float parameter_y() const { return parameter_y_; }
+		inline Int32 child_count() const { return (Int32)children_.size(); }
+
+	private:
+		std::vector<BlendNode*> children_;
+		std::vector<float> positions_x_;
+		std::vector<float> positions_y_;
+		std::vector<float> weights_;
+		float parameter_x_;
+		float parameter_y_;
+	};
+
+	/**
+	Evaluates a tree of BlendNodes in to a SkeletonPose. The nodes only work with local poses, and the global pose
+	is calculated once from the result. Scratch poses for the nodes are allocated by Init, so evaluating doesn't allocate.
+	*/
+	class BlendTree
+	{
+	public:
+		BlendTree();
+		~BlendTree();
+
+		/// @brief Sets the skeleton and the root node and allocates the scratch poses the nodes need.
+		/// @param[in] bind_pose	The bind pose, which provides the skeleton and the pose of any joints that aren't animated. Must outlive the tree.
+		/// @param[in] root			The root node. Owned by the tree. Any previous root is deleted.
+		/// @note Call again if nodes are added after this, so enough scratch poses are allocated.
+		void Init(const SkeletonPose& bind_pose, BlendNode* root);
+
+		/// @brief Evaluates the tree.
+		/// @param[out] pose				Receives the local pose and, if update_global_pose is true, the global pose.
+		/// @param[in] update_global_pose	Whether to calculate the global pose as well.
+		/// @param[in] pose_transform		If not NULL, passed to SkeletonPose::CalculateGlobalPose.
+		void Evaluate(SkeletonPose& pose, const bool update_global_pose = true, const Matrix44* pose_transform = NULL);
+
+		/// @brief Get one of the scratch poses, for nodes to evaluate their children in to.
+		inline JointPose* scratch_pose(const Int32 index) { return &scratch_poses_[index * joint_count_]; }
+
+		inline const SkeletonPose* bind_pose() const { return bind_pose_; }
+		inline Int32 joint_count() const { return joint_count_; }
+		inline BlendNode* root() { return root_; }
+
+	private:
+		const SkeletonPose* bind_pose_;
+		BlendNode* root_;
+		Int32 joint_count_;
+		std::vector<JointPose> scratch_poses_;
+	};
+}
+
+#endif // _GEF_BLEND_TREE_H
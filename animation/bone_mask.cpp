@@ -0,0 +1,47 @@
+#include <animation/bone_mask.h>
+#include <animation/skeleton.h>
+
+namespace gef
+{
+	BoneMask::BoneMask()
+	{
+	}
+
+	void BoneMask::Init(const Skeleton& skeleton, const float weight)
+	{
+		weights_.assign(skeleton.joint_count(), weight);
+		UpdateJointIndices();
+	}
+
+	void BoneMask::SetJointWeight(const Int32 joint_index, const float weight)
+	{
+		weights_[joint_index] = weight;
+		UpdateJointIndices();
+	}
+
+	void BoneMask::SetHierarchyWeight(const Skeleton& skeleton, const Int32 root_joint_index, const float weight)
+	{
+		// a joint is in the hierarchy if the root is one of its ancestors
+		for (Int32 joint_index = 0; joint_index < joint_count(); ++joint_index)
+		{
+			Int32 ancestor = joint_index;
+			while (ancestor != -1 && ancestor != root_joint_index)
+				ancestor = skeleton.joint(ancestor).parent;
+
+			if (ancestor == root_joint_index)
+				weights_[joint_index] = weight;
+		}
+
+		UpdateJointIndices();
+	}
+
+	void BoneMask::UpdateJointIndices()
+	{
+		joint_indices_.clear();
+		for (Int32 joint_index = 0; joint_index < joint_count(); ++joint_index)
+		{
+			if (weights_[joint_index] > 0.0f)
+				joint_indices_.push_back(joint_index);
+		}
+	}
+}
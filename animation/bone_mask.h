@@ -0,0 +1,52 @@
+#ifndef _GEF_BONE_MASK_H
+#define _GEF_BONE_MASK_H
+
+#include <gef.h>
+#include <vector>
+
+namespace gef
+{
+	// forward declarations
+	class Skeleton;
+
+	/**
+	A weight for each joint in a skeleton, for layering animations on part of the body, e.g. an upper body layer.
+	Joints with a weight of zero aren't affected and aren't sampled, so applying an animation through a mask costs
+	in proportion to the number of joints in the mask rather than the size of the skeleton.
+	*/
+	class BoneMask
+	{
+	public:
+		BoneMask();
+
+		/// @brief Sets the number of joints from a skeleton and sets every weight.
+		/// @param[in] skeleton		The skeleton the mask is for.
+		/// @param[in] weight		The weight of every joint.
+		void Init(const Skeleton& skeleton, const float weight = 0.0f);
+
+		/// @brief Sets the weight of one joint.
+		void SetJointWeight(const Int32 joint_index, const float weight);
+
+		/// @brief Sets the weight of a joint and every joint below it in the hierarchy.
+		/// @param[in] skeleton				The skeleton the mask is for.
+		/// @param[in] root_joint_index		The joint at the top of the hierarchy, e.g. the spine for an upper body mask.
+		/// @param[in] weight				The weight.
+		void SetHierarchyWeight(const Skeleton& skeleton, const Int32 root_joint_index, const float weight);
+
+		inline float joint_weight(const Int32 joint_index) const { return weights_[joint_index]; }
+
+		/// @brief Get the indices of the joints with a weight greater than zero, in skeleton order.
+		inline const std::vector<Int32>& joint_indices() const { return joint_indices_; }
+
+		/// @brief Get the number of joints in the skeleton the mask is for.
+		inline Int32 joint_count() const { return (Int32)weights_.size(); }
+
+	private:
+		void UpdateJointIndices();
+
+		std::vector<float> weights_;
+		std::vector<Int32> joint_indices_;
+	};
+}
+
+#endif // _GEF_BONE_MASK_H
@@ -0,0 +1,530 @@
+#include <animation/compressed_anim_node.h>
+#include <math.h>
+#include <cfloat>
+
+namespace gef
+{
+	// the three smallest components of a unit quaternion are all within +-1/sqrt(2)
+	static const float kSmallestThreeRange = 0.70710678f;
+	static const float kSmallestThreeSteps = 32767.0f;
+	static const float kVectorSteps = 65535.0f;
+	static const float kTimeSteps = 65535.0f;
+
+	static UInt16 QuantiseUnit(const float value, const float steps)
+	{
+		float quantised = floorf(value*steps + 0.5f);
+		if (quantised < 0.0f)
+			quantised = 0.0f;
+		else if (quantised > steps)
+			quantised = steps;
+		return (UInt16)quantised;
+	}
+
+	// stores the three smallest components in 15 bits each, with the index of the largest component
+	// in the top bits of the first two values. The largest component is made positive so it can be
+	// recreated from the others
+	static void EncodeRotation(const Quaternion& rotation, UInt16* encoded)
+	{
+		Quaternion normalised = rotation;
+		normalised.Normalise();
+		const float components[4] = { normalised.x, normalised.y, normalised.z, normalised.w };
+
+		Int32 largest = 0;
+		for (Int32 component_num = 1; component_num < 4; ++component_num)
+		{
+			if (fabsf(components[component_num]) > fabsf(components[largest]))
+				largest = component_num;
+		}
+		const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+		Int32 encoded_num = 0;
+		for (Int32 component_num = 0; component_num < 4; ++component_num)
+		{
+			if (component_num != largest)
+			{
+				const float unit_value = (components[component_num] * sign / kSmallestThreeRange) * 0.5f + 0.5f;
+				encoded[encoded_num++] = QuantiseUnit(unit_value, kSmallestThreeSteps);
+			}
+		}
+
+		encoded[0] |= (UInt16)((largest & 1) << 15);
+		encoded[1] |= (UInt16)((largest >> 1) << 15);
+	}
+
+	static const Quaternion DecodeRotation(const UInt16* encoded)
+	{
+		const Int32 largest = (encoded[0] >> 15) | ((encoded[1] >> 15) << 1);
+
+		float components[4];
+		float sum_of_squares = 0.0f;
+		Int32 encoded_num = 0;
+		for (Int32 component_num = 0; component_num < 4; ++component_num)
+		{
+			if (component_num != largest)
+			{
+				const float unit_value = (float)(encoded[encoded_num++] & 0x7fff) / kSmallestThreeSteps;
+				const float value = (unit_value * 2.0f - 1.0f) * kSmallestThreeRange;
+				components[component_num] = value;
+				sum_of_squares += value*value;
+			}
+		}
+		components[largest] = sqrtf(sum_of_squares < 1.0f ? 1.0f - sum_of_squares : 0.0f);
+
+		return Quaternion(components[0], components[1], components[2], components[3]);
+	}
+
+	static const Vector4 DecodeVector(const UInt16* encoded, const Vector4& minimum, const Vector4& extent)
+	{
+		return Vector4(
+			minimum.x() + encoded[0] * (extent.x() / kVectorSteps),
+			minimum.y() + encoded[1] * (extent.y() / kVectorSteps),
+			minimum.z() + encoded[2] * (extent.z() / kVectorSteps));
+	}
+
+	// normalised lerp, taking the shortest path
+	static const Quaternion InterpolateRotation(const Quaternion& start, const Quaternion& end, const float fraction)
+	{
+		const float dot = start.x*end.x + start.y*end.y + start.z*end.z + start.w*end.w;
+
+		Quaternion result;
+		result.Lerp(start, dot < 0.0f ? -end : end, fraction);
+		result.Normalise();
+		return result;
+	}
+
+	// gets the quantised time of each key of a track for FindNextKey
+	struct QuantisedKeyTimes
+	{
+		QuantisedKeyTimes(const std::vector<UInt16>& times) : times(times) {}
+		inline float operator()(const UInt32 key_index) const { return (float)times[key_index]; }
+
+		const std::vector<UInt16>& times;
+	};
+
+	// chooses the keys to keep. Starting from the last key kept, each span is extended for as long as
+	// interpolating across it stays within tolerance at every original key it covers.
+	// key_error(first, last, key) returns the error at key when interpolating between first and last
+	template<class KeyError>
+	static void ReduceKeys(const UInt32 key_count, const float tolerance, KeyError& key_error, std::vector<UInt32>& kept_keys)
+	{
+		kept_keys.clear();
+		kept_keys.push_back(0);
+		if (key_count < 2)
+			return;
+
+		// a constant track only needs one key
+		bool constant = true;
+		for (UInt32 key_num = 1; key_num < key_count && constant; ++key_num)
+			constant = key_error(0, 0, key_num) <= tolerance;
+		if (constant)
+			return;
+
+		UInt32 span_start = 0;
+		while (span_start < key_count - 1)
+		{
+			UInt32 span_end = span_start + 1;
+			while (span_end + 1 < key_count)
+			{
+				bool within_tolerance = true;
+				for (UInt32 key_num = span_start; key_num <= span_end + 1 && within_tolerance; ++key_num)
+					within_tolerance = key_error(span_start, span_end + 1, key_num) <= tolerance;
+				if (!within_tolerance)
+					break;
+				++span_end;
+			}
+
+			kept_keys.push_back(span_end);
+			span_start = span_end;
+		}
+	}
+
+	// the fraction of the way from the first key to the last that sampling at the time of another key interpolates by.
+	// times holds the original key times in quantised time units so the error from quantising the times is included
+	static float InterpolationFraction(const std::vector<UInt16>& quantised_times, const std::vector<float>& times, const UInt32 first, const UInt32 last, const UInt32 key)
+	{
+		if (quantised_times[last] == quantised_times[first])
+			return 0.0f;
+
+		const float fraction = (times[key] - quantised_times[first]) / (float)(quantised_times[last] - quantised_times[first]);
+		return fraction < 0.0f ? 0.0f : (fraction > 1.0f ? 1.0f : fraction);
+	}
+
+	class VectorKeyError
+	{
+	public:
+		VectorKeyError(const std::vector<Vector3Key>& keys, const std::vector<Vector4>& decoded, const std::vector<UInt16>& quantised_times, const std::vector<float>& times) :
+			keys_(keys),
+			decoded_(decoded),
+			quantised_times_(quantised_times),
+			times_(times)
+		{
+		}
+
+		float operator()(const UInt32 first, const UInt32 last, const UInt32 key) const
+		{
+			Vector4 value;
+			value.Lerp(decoded_[first], decoded_[last], InterpolationFraction(quantised_times_, times_, first, last, key));
+			const Vector4& original = keys_[key].value;
+			return (value - Vector4(original.x(), original.y(), original.z())).Length();
+		}
+
+	private:
+		const std::vector<Vector3Key>& keys_;
+		const std::vector<Vector4>& decoded_;
+		const std::vector<UInt16>& quantised_times_;
+		const std::vector<float>& times_;
+	};
+
+	class RotationKeyError
+	{
+	public:
+		RotationKeyError(const std::vector<QuaternionKey>& keys, const std::vector<Quaternion>& decoded, const std::vector<UInt16>& quantised_times, const std::vector<float>& times) :
+			keys_(keys),
+			decoded_(decoded),
+			quantised_times_(quantised_times),
+			times_(times)
+		{
+		}
+
+		float operator()(const UInt32 first, const UInt32 last, const UInt32 key) const
+		{
+			const Quaternion value = InterpolateRotation(decoded_[first], decoded_[last], InterpolationFraction(quantised_times_, times_, first, last, key));
+			Quaternion original = keys_[key].value;
+			original.Normalise();
+
+			// angle between the two rotations, from the vector part of the rotation between them.
+			// acos of their dot product doesn't have enough precision in floats for small angles
+			const float x = value.w*original.x - original.w*value.x - (value.y*original.z - value.z*original.y);
+			const float y = value.w*original.y - original.w*value.y - (value.z*original.x - value.x*original.z);
+			const float z = value.w*original.z - original.w*value.z - (value.x*original.y - value.y*original.x);
+			const float half_angle_sin = sqrtf(x*x + y*y + z*z);
+			return 2.0f * asinf(half_angle_sin < 1.0f ? half_angle_sin : 1.0f);
+		}
+
+	private:
+		const std::vector<QuaternionKey>& keys_;
+		const std::vector<Quaternion>& decoded_;
+		const std::vector<UInt16>& quantised_times_;
+		const std::vector<float>& times_;
+	};
+
+	CompressedTransformAnimNode::CompressedTransformAnimNode() :
+		AnimNode(AnimNode::kCompressedTransform),
+		start_time_(0.0f),
+		time_step_(0.0f)
+	{
+	}
+
+	CompressedTransformAnimNode::~CompressedTransformAnimNode()
+	{
+	}
+
+	UInt16 CompressedTransformAnimNode::QuantiseTime(const float time) const
+	{
+		if (time_step_ <= 0.0f)
+			return 0;
+		return QuantiseUnit((time - start_time_) / (time_step_ * kTimeSteps), kTimeSteps);
+	}
+
+	void CompressedTransformAnimNode::Compress(const TransformAnimNode& node, const float rotation_tolerance, const float translation_tolerance)
+	{
+		set_name_id(node.name_id());
+
+		// the key times are stored as fractions of the range covered by all the tracks
+		float start_time = FLT_MAX;
+		float end_time = -FLT_MAX;
+		const std::vector<Vector3Key>* vector_tracks[2] = { &node.scale_keys(), &node.translation_keys() };
+		for (Int32 track_num = 0; track_num < 2; ++track_num)
+		{
+			if (!vector_tracks[track_num]->empty())
+			{
+				start_time = fminf(start_time, vector_tracks[track_num]->front().time);
+				end_time = fmaxf(end_time, vector_tracks[track_num]->back().time);
+			}
+		}
+		if (!node.rotation_keys().empty())
+		{
+			start_time = fminf(start_time, node.rotation_keys().front().time);
+			end_time = fmaxf(end_time, node.rotation_keys().back().time);
+		}
+
+		if (start_time > end_time)
+		{
+			start_time_ = 0.0f;
+			time_step_ = 0.0f;
+		}
+		else
+		{
+			start_time_ = start_time;
+			time_step_ = (end_time - start_time) / kTimeSteps;
+		}
+
+		CompressVectorTrack(scale_track_, node.scale_keys(), translation_tolerance);
+		CompressRotationTrack(rotation_track_, node.rotation_keys(), rotation_tolerance);
+		CompressVectorTrack(translation_track_, node.translation_keys(), translation_tolerance);
+	}
+
+	void CompressedTransformAnimNode::CompressVectorTrack(VectorTrack& track, const std::vector<Vector3Key>& keys, const float tolerance)
+	{
+		track.times.clear();
+		track.values.clear();
+		track.minimum = Vector4(0.0f, 0.0f, 0.0f);
+		track.extent = Vector4(0.0f, 0.0f, 0.0f);
+		if (keys.empty())
+			return;
+
+		const UInt32 key_count = (UInt32)keys.size();
+
+		Vector4 minimum(FLT_MAX, FLT_MAX, FLT_MAX);
+		Vector4 maximum(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (std::vector<Vector3Key>::const_iterator key_iter = keys.begin(); key_iter != keys.end(); ++key_iter)
+		{
+			minimum = Vector4(fminf(minimum.x(), key_iter->value.x()), fminf(minimum.y(), key_iter->value.y()), fminf(minimum.z(), key_iter->value.z()));
+			maximum = Vector4(fmaxf(maximum.x(), key_iter->value.x()), fmaxf(maximum.y(), key_iter->value.y()), fmaxf(maximum.z(), key_iter->value.z()));
+		}
+		track.minimum = minimum;
+		track.extent = maximum - minimum;
+
+		// quantise every key first so the key reduction measures the error of what will actually be sampled
+		std::vector<UInt16> times(key_count);
+		std::vector<float> unit_times(key_count);
+		std::vector<UInt16> values(key_count * 3);
+		std::vector<Vector4> decoded(key_count);
+		for (UInt32 key_num = 0; key_num < key_count; ++key_num)
+		{
+			times[key_num] = QuantiseTime(keys[key_num].time);
+			unit_times[key_num] = time_step_ > 0.0f ? (keys[key_num].time - start_time_) / time_step_ : 0.0f;
+			for (Int32 component_num = 0; component_num < 3; ++component_num)
+			{
+				const float extent = track.extent[component_num];
+				const float unit_value = extent > 0.0f ? (keys[key_num].value[component_num] - minimum[component_num]) / extent : 0.0f;
+				values[key_num * 3 + component_num] = QuantiseUnit(unit_value, kVectorSteps);
+			}
+			decoded[key_num] = DecodeVector(&values[key_num * 3], track.minimum, track.extent);
+		}
+
+		VectorKeyError key_error(keys, decoded, times, unit_times);
+		std::vector<UInt32> kept_keys;
+		ReduceKeys(key_count, tolerance, key_error, kept_keys);
+
+		for (std::vector<UInt32>::const_iterator kept_iter = kept_keys.begin(); kept_iter != kept_keys.end(); ++kept_iter)
+		{
+			track.times.push_back(times[*kept_iter]);
+			track.values.insert(track.values.end(), values.begin() + *kept_iter * 3, values.begin() + *kept_iter * 3 + 3);
+		}
+	}
+
+	void CompressedTransformAnimNode::CompressRotationTrack(RotationTrack& track, const std::vector<QuaternionKey>& keys, const float tolerance)
+	{
+		track.times.clear();
+		track.values.clear();
+		if (keys.empty())
+			return;
+
+		const UInt32 key_count = (UInt32)keys.size();
+
+		std::vector<UInt16> times(key_count);
+		std::vector<float> unit_times(key_count);
+		std::vector<UInt16> values(key_count * 3);
+		std::vector<Quaternion> decoded(key_count);
+		for (UInt32 key_num = 0; key_num < key_count; ++key_num)
+		{
+			times[key_num] = QuantiseTime(keys[key_num].time);
+			unit_times[key_num] = time_step_ > 0.0f ? (keys[key_num].time - start_time_) / time_step_ : 0.0f;
+			EncodeRotation(keys[key_num].value, &values[key_num * 3]);
+			decoded[key_num] = DecodeRotation(&values[key_num * 3]);
+		}
+
+		RotationKeyError key_error(keys, decoded, times, unit_times);
+		std::vector<UInt32> kept_keys;
+		ReduceKeys(key_count, tolerance, key_error, kept_keys);
+
+		for (std::vector<UInt32>::const_iterator kept_iter = kept_keys.begin(); kept_iter != kept_keys.end(); ++kept_iter)
+		{
+			track.times.push_back(times[*kept_iter]);
+			track.values.insert(track.values.end(), values.begin() + *kept_iter * 3, values.begin() + *kept_iter * 3 + 3);
+		}
+	}
+
+	const Vector4 CompressedTransformAnimNode::SampleVectorTrack(const VectorTrack& track, const float time, UInt32& key_cursor) const
+	{
+		const UInt32 key_count = (UInt32)track.times.size();
+		if (key_count == 0)
+			return Vector4(0.f, 0.f, 0.f);
+
+		const float quantised_time = time_step_ > 0.0f ? (time - start_time_) / time_step_ : 0.0f;
+		const UInt32 key_index = FindNextKey(QuantisedKeyTimes(track.times), (UInt32)track.times.size(), quantised_time, key_cursor);
+
+		// before the first key or after the last one
+		if (key_index == 0 || key_index == key_count)
+			return DecodeVector(&track.values[(key_index == 0 ? 0 : key_index - 1) * 3], track.minimum, track.extent);
+
+		const float prev_time = track.times[key_index - 1];
+		const float next_time = track.times[key_index];
+
+		Vector4 result;
+		result.Lerp(
+			DecodeVector(&track.values[(key_index - 1) * 3], track.minimum, track.extent),
+			DecodeVector(&track.values[key_index * 3], track.minimum, track.extent),
+			(quantised_time - prev_time) / (next_time - prev_time));
+		return result;
+	}
+
+	const Quaternion CompressedTransformAnimNode::SampleRotationTrack(const RotationTrack& track, const float time, UInt32& key_cursor) const
+	{
+		const UInt32 key_count = (UInt32)track.times.size();
+		if (key_count == 0)
+			return Quaternion::kIdentity;
+
+		const float quantised_time = time_step_ > 0.0f ? (time - start_time_) / time_step_ : 0.0f;
+		const UInt32 key_index = FindNextKey(QuantisedKeyTimes(track.times), (UInt32)track.times.size(), quantised_time, key_cursor);
+
+		// before the first key or after the last one
+		if (key_index == 0 || key_index == key_count)
+			return DecodeRotation(&track.values[(key_index == 0 ? 0 : key_index - 1) * 3]);
+
+		const float prev_time = track.times[key_index - 1];
+		const float next_time = track.times[key_index];
+
+		return InterpolateRotation(
+			DecodeRotation(&track.values[(key_index - 1) * 3]),
+			DecodeRotation(&track.values[key_index * 3]),
+			(quantised_time - prev_time) / (next_time - prev_time));
+	}
+
+	const Vector4 CompressedTransformAnimNode::GetTranslation(const float time) const
+	{
+		UInt32 key_cursor = 0;
+		return SampleVectorTrack(translation_track_, time, key_cursor);
+	}
+
+	const Vector4 CompressedTransformAnimNode::GetScale(const float time) const
+	{
+		UInt32 key_cursor = 0;
+		return SampleVectorTrack(scale_track_, time, key_cursor);
+	}
+
+	const Quaternion CompressedTransformAnimNode::GetRotation(const float time) const
+	{
+		UInt32 key_cursor = 0;
+		return SampleRotationTrack(rotation_track_, time, key_cursor);
+	}
+
+	const Vector4 CompressedTransformAnimNode::GetTranslation(const float time, TransformAnimNodeCursor& cursor) const
+	{
+		return SampleVectorTrack(translation_track_, time, cursor.translation_key);
+	}
+
+	const Vector4 CompressedTransformAnimNode::GetScale(const float time, TransformAnimNodeCursor& cursor) const
+	{
+		return SampleVectorTrack(scale_track_, time, cursor.scale_key);
+	}
+
+	const Quaternion CompressedTransformAnimNode::GetRotation(const float time, TransformAnimNodeCursor& cursor) const
+	{
+		return SampleRotationTrack(rotation_track_, time, cursor.rotation_key);
+	}
+
+	void CompressedTransformAnimNode::GetRotationKeys(std::vector<QuaternionKey>& keys) const
+	{
+		keys.resize(rotation_track_.times.size());
+		for (UInt32 key_num = 0; key_num < keys.size(); ++key_num)
+		{
+			keys[key_num].value = DecodeRotation(&rotation_track_.values[key_num * 3]);
+			keys[key_num].time = GetKeyTime(rotation_track_.times[key_num]);
+		}
+	}
+
+	void CompressedTransformAnimNode::GetTranslationKeys(std::vector<Vector3Key>& keys) const
+	{
+		keys.resize(translation_track_.times.size());
+		for (UInt32 key_num = 0; key_num < keys.size(); ++key_num)
+		{
+			keys[key_num].value = DecodeVector(&translation_track_.values[key_num * 3], translation_track_.minimum, translation_track_.extent);
+			keys[key_num].time = GetKeyTime(translation_track_.times[key_num]);
+		}
+	}
+
+	UInt32 CompressedTransformAnimNode::GetKeyDataSize() const
+	{
+		const UInt32 key_count = scale_key_count() + rotation_key_count() + translation_key_count();
+		return key_count * 4 * sizeof(UInt16);
+	}
+
+	float CompressedTransformAnimNode::GetMaximumKeyTime() const
+	{
+		float maximum_key_time = 0.0f;
+
+		if (!scale_track_.times.empty())
+			maximum_key_time = fmaxf(maximum_key_time, GetKeyTime(scale_track_.times.back()));
+		if (!rotation_track_.times.empty())
+			maximum_key_time = fmaxf(maximum_key_time, GetKeyTime(rotation_track_.times.back()));
+		if (!translation_track_.times.empty())
+			maximum_key_time = fmaxf(maximum_key_time, GetKeyTime(translation_track_.times.back()));
+
+		return maximum_key_time;
+	}
+
+	static void ReadTrackKeys(std::istream& stream, std::vector<UInt16>& times, std::vector<UInt16>& values)
+	{
+		Int32 num_keys;
+		stream.read((char*)&num_keys, sizeof(Int32));
+		times.resize(num_keys);
+		values.resize(num_keys * 3);
+		if (num_keys > 0)
+		{
+			stream.read((char*)&times.front(), sizeof(UInt16)*num_keys);
+			stream.read((char*)&values.front(), sizeof(UInt16)*num_keys*3);
+		}
+	}
+
+	static void WriteTrackKeys(std::ostream& stream, const std::vector<UInt16>& times, const std::vector<UInt16>& values)
+	{
+		Int32 num_keys = (Int32)times.size();
+		stream.write((char*)&num_keys, sizeof(Int32));
+		if (num_keys > 0)
+		{
+			stream.write((char*)&times.front(), sizeof(UInt16)*num_keys);
+			stream.write((char*)&values.front(), sizeof(UInt16)*num_keys*3);
+		}
+	}
+
+	bool CompressedTransformAnimNode::Read(std::istream& stream)
+	{
+		// name_id and type have already been read so don't read them in here
+		stream.read((char*)&start_time_, sizeof(float));
+		stream.read((char*)&time_step_, sizeof(float));
+
+		ReadTrackKeys(stream, scale_track_.times, scale_track_.values);
+		stream.read((char*)&scale_track_.minimum, sizeof(Vector4));
+		stream.read((char*)&scale_track_.extent, sizeof(Vector4));
+
+		ReadTrackKeys(stream, rotation_track_.times, rotation_track_.values);
+
+		ReadTrackKeys(stream, translation_track_.times, translation_track_.values);
+		stream.read((char*)&translation_track_.minimum, sizeof(Vector4));
+		stream.read((char*)&translation_track_.extent, sizeof(Vector4));
+
+		return true;
+	}
+
+	bool CompressedTransformAnimNode::Write(std::ostream& stream) const
+	{
+		bool success = AnimNode::Write(stream);
+
+		stream.write((char*)&start_time_, sizeof(float));
+		stream.write((char*)&time_step_, sizeof(float));
+
+		WriteTrackKeys(stream, scale_track_.times, scale_track_.values);
+		stream.write((char*)&scale_track_.minimum, sizeof(Vector4));
+		stream.write((char*)&scale_track_.extent, sizeof(Vector4));
+
+		WriteTrackKeys(stream, rotation_track_.times, rotation_track_.values);
+
+		WriteTrackKeys(stream, translation_track_.times, translation_track_.values);
+		stream.write((char*)&translation_track_.minimum, sizeof(Vector4));
+		stream.write((char*)&translation_track_.extent, sizeof(Vector4));
+
+		return success;
+	}
+}
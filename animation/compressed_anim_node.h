@@ -0,0 +1,99 @@
+#ifndef _GEF_COMPRESSED_ANIM_NODE_H
+#define _GEF_COMPRESSED_ANIM_NODE_H
+
+#include <gef.h>
+#include <animation/animation.h>
+#include <vector>
+
+namespace gef
+{
+	/**
+	A transform animation with quantised keys and with the keys that can be recreated by interpolation removed.
+	Rotations use the smallest three encoding in 48 bits, translations and scales are stored as 16 bits per
+	component within the range of each track and key times are stored as 16 bit fractions of the node's time range.
+	Each key takes 8 bytes compared to 20 for a QuaternionKey or Vector3Key.
+	*/
+	class CompressedTransformAnimNode : public AnimNode
+	{
+	public:
+		CompressedTransformAnimNode();
+		~CompressedTransformAnimNode();
+
+		/// @brief Fills the tracks by compressing a keyed transform animation.
+		/// @param[in] node						The keyed animation. Its name is copied.
+		/// @param[in] rotation_tolerance		The largest allowed rotation error in radians.
+		/// @param[in] translation_tolerance	The largest allowed distance from the original translations and scales.
+		/// @note The tolerances are checked at the times of the original keys and include the quantisation error.
+		void Compress(const TransformAnimNode& node, const float rotation_tolerance, const float translation_tolerance);
+
+		const Vector4 GetTranslation(const float time) const;
+		const Vector4 GetScale(const float time) const;
+		const Quaternion GetRotation(const float time) const;
+
+		/// @brief Samples a track starting from the keys used by the previous sample.
+		/// @param[in] time			The time to sample the track at.
+		/// @param[in,out] cursor	The keys used by the previous sample. Updated with the keys used by this one.
+		const Vector4 GetTranslation(const float time, TransformAnimNodeCursor& cursor) const;
+		const Vector4 GetScale(const float time, TransformAnimNodeCursor& cursor) const;
+		const Quaternion GetRotation(const float time, TransformAnimNodeCursor& cursor) const;
+
+		inline UInt32 scale_key_count() const { return (UInt32)scale_track_.times.size(); }
+		inline UInt32 rotation_key_count() const { return (UInt32)rotation_track_.times.size(); }
+		inline UInt32 translation_key_count() const { return (UInt32)translation_track_.times.size(); }
+
+		/// @brief Get the time of a key.
+		/// @param[in] key_time		The quantised key time from one of the tracks.
+		inline float GetKeyTime(const UInt16 key_time) const { return start_time_ + key_time*time_step_; }
+
+		/// @brief Decompresses the keys of each track, e.g. to bake them with other animations.
+		void GetRotationKeys(std::vector<QuaternionKey>& keys) const;
+		void GetTranslationKeys(std::vector<Vector3Key>& keys) const;
+
+		/// @brief Get the number of bytes used by the keys.
+		UInt32 GetKeyDataSize() const;
+
+		float GetMaximumKeyTime() const;
+
+		bool Read(std::istream& stream);
+		bool Write(std::ostream& stream) const;
+
+	private:
+		struct VectorTrack
+		{
+			/// Quantised key times.
+			std::vector<UInt16> times;
+
+			/// Three quantised components for each key.
+			std::vector<UInt16> values;
+
+			/// The smallest value of each component and the range of the values.
+			Vector4 minimum;
+			Vector4 extent;
+		};
+
+		struct RotationTrack
+		{
+			/// Quantised key times.
+			std::vector<UInt16> times;
+
+			/// Three components for each key, using the smallest three encoding.
+			std::vector<UInt16> values;
+		};
+
+		void CompressVectorTrack(VectorTrack& track, const std::vector<Vector3Key>& keys, const float tolerance);
+		void CompressRotationTrack(RotationTrack& track, const std::vector<QuaternionKey>& keys, const float tolerance);
+		const Vector4 SampleVectorTrack(const VectorTrack& track, const float time, UInt32& key_cursor) const;
+		const Quaternion SampleRotationTrack(const RotationTrack& track, const float time, UInt32& key_cursor) const;
+		UInt16 QuantiseTime(const float time) const;
+
+		VectorTrack scale_track_;
+		RotationTrack rotation_track_;
+		VectorTrack translation_track_;
+
+		/// The time of the first key and the time between each quantised time step.
+		float start_time_;
+		float time_step_;
+	};
+}
+
+#endif // _GEF_COMPRESSED_ANIM_NODE_H
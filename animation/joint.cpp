@@ -19,5 +19,23 @@ namespace gef
 
 		return true;
 	}
-}
 
+	void AddJointPose(JointPose& pose, const JointPose& additive, const JointPose& reference, const float weight)
+	{
+		// the rotation that takes the reference pose to the additive pose, applied before the rotation of the pose
+		Quaternion inv_reference_rotation;
+		inv_reference_rotation.Conjugate(reference.rotation());
+		Quaternion difference = additive.rotation() * inv_reference_rotation;
+		if (weight < 1.0f)
+		{
+			const Quaternion full_difference = difference;
+			difference.Slerp(Quaternion::kIdentity, full_difference, weight);
+		}
+
+		Quaternion rotation = difference * pose.rotation();
+		rotation.Normalise();
+		pose.set_rotation(rotation);
+		pose.set_translation(pose.translation() + (additive.translation() - reference.translation()) * weight);
+		pose.set_scale(pose.scale() + (additive.scale() - reference.scale()) * weight);
+	}
+}
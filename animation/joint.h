@@ -23,6 +23,13 @@ namespace gef
 	};
 
 	typedef Transform JointPose;
+
+	/// @brief Adds the difference between an additive pose and the reference pose it was made relative to on to a pose.
+	/// @param[in,out] pose		The pose to add to.
+	/// @param[in] additive		The additive pose.
+	/// @param[in] reference	The pose the additive pose is relative to, e.g. the first frame of an additive animation.
+	/// @param[in] weight		How much of the difference to add, from zero to one.
+	void AddJointPose(JointPose& pose, const JointPose& additive, const JointPose& reference, const float weight);
 }
 
 #endif // _JOINT_H
\ No newline at end of file
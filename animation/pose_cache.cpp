@@ -0,0 +1,116 @@
+#include <animation/pose_cache.h>
+#include <animation/animation.h>
+#include <math.h>
+
+namespace gef
+{
+	bool PoseCache::Key::operator<(const Key& key) const
+	{
+		if (animation != key.animation)
+			return animation < key.animation;
+		if (skeleton != key.skeleton)
+			return skeleton < key.skeleton;
+		return frame < key.frame;
+	}
+
+	PoseCache::PoseCache() :
+		memory_budget_(0),
+		memory_used_(0),
+		time_step_(0.0f),
+		hit_count_(0),
+		miss_count_(0)
+	{
+	}
+
+	void PoseCache::Init(const UInt32 memory_budget, const float time_step)
+	{
+		Clear();
+		memory_budget_ = memory_budget;
+		time_step_ = time_step;
+		hit_count_ = 0;
+		miss_count_ = 0;
+	}
+
+	void PoseCache::Clear()
+	{
+		poses_.clear();
+		spare_poses_.clear();
+		pose_lookup_.clear();
+		memory_used_ = 0;
+	}
+
+	UInt32 PoseCache::GetPoseMemory(const Int32 joint_count)
+	{
+		return sizeof(CachedPose) + 2 * joint_count * sizeof(Matrix44);
+	}
+
+	Int32 PoseCache::QuantiseFrame(const float time) const
+	{
+		return time_step_ > 0.0f ? (Int32)floorf(time / time_step_ + 0.5f) : 0;
+	}
+
+	float PoseCache::QuantiseTime(const float time) const
+	{
+		return time_step_ > 0.0f ? QuantiseFrame(time) * time_step_ : time;
+	}
+
+	const CachedPose& PoseCache::GetPose(const Animation& anim, const SkeletonPose& bind_pose, const float time)
+	{
+		Key key;
+		key.animation = &anim;
+		key.skeleton = bind_pose.skeleton();
+		key.frame = QuantiseFrame(time);
+
+		std::map<Key, PoseList::iterator>::iterator lookup_iter = pose_lookup_.find(key);
+		if (lookup_iter != pose_lookup_.end())
+		{
+			// move to the front of the list as the most recently used
+			++hit_count_;
+			poses_.splice(poses_.begin(), poses_, lookup_iter->second);
+			return *lookup_iter->second;
+		}
+
+		++miss_count_;
+
+		// make room by dropping the least recently used poses. The new pose is always kept, even if it's over budget on its own
+		const Int32 joint_count = (Int32)bind_pose.local_pose().size();
+		const UInt32 pose_memory = GetPoseMemory(joint_count);
+		while (!poses_.empty() && memory_used_ + pose_memory > memory_budget_)
+		{
+			PoseList::iterator oldest_iter = --poses_.end();
+			Key oldest_key;
+			oldest_key.animation = oldest_iter->animation_;
+			oldest_key.skeleton = oldest_iter->skeleton_;
+			oldest_key.frame = oldest_iter->frame_;
+			pose_lookup_.erase(oldest_key);
+			memory_used_ -= GetPoseMemory((Int32)oldest_iter->global_pose_.size());
+
+			spare_poses_.clear();
+			spare_poses_.splice(spare_poses_.begin(), poses_, oldest_iter);
+		}
+
+		if (spare_poses_.empty())
+			poses_.push_front(CachedPose());
+		else
+			poses_.splice(poses_.begin(), spare_poses_);
+
+		CachedPose& pose = poses_.front();
+		pose.animation_ = &anim;
+		pose.skeleton_ = bind_pose.skeleton();
+		pose.frame_ = key.frame;
+		pose_lookup_[key] = poses_.begin();
+		memory_used_ += pose_memory;
+
+		// sample the pose and calculate the skinning matrices the same way as SkinnedMeshInstance::UpdateBoneMatrices
+		if (sample_pose_.skeleton() != bind_pose.skeleton() || (Int32)sample_pose_.local_pose().size() != joint_count)
+			sample_pose_ = bind_pose;
+		sample_pose_.SetPoseFromAnim(anim, bind_pose, QuantiseTime(time));
+
+		pose.global_pose_ = sample_pose_.global_pose();
+		pose.bone_matrices_.resize(joint_count);
+		for (Int32 joint_num = 0; joint_num < joint_count; ++joint_num)
+			pose.bone_matrices_[joint_num] = bind_pose.skeleton()->joint(joint_num).inv_bind_pose * pose.global_pose_[joint_num];
+
+		return pose;
+	}
+}
@@ -0,0 +1,107 @@
+#ifndef _GEF_POSE_CACHE_H
+#define _GEF_POSE_CACHE_H
+
+#include <gef.h>
+#include <animation/skeleton.h>
+#include <maths/matrix44.h>
+#include <vector>
+#include <list>
+#include <map>
+
+namespace gef
+{
+	// forward declarations
+	class Animation;
+
+	/**
+	A pose sampled by a PoseCache.
+	*/
+	class CachedPose
+	{
+	public:
+		/// @brief Get the global transform of each joint.
+		inline const std::vector<Matrix44>& global_pose() const { return global_pose_; }
+
+		/// @brief Get the skinning matrix of each joint, the same as SkinnedMeshInstance::UpdateBoneMatrices calculates.
+		inline const std::vector<Matrix44>& bone_matrices() const { return bone_matrices_; }
+
+	private:
+		friend class PoseCache;
+
+		std::vector<Matrix44> global_pose_;
+		std::vector<Matrix44> bone_matrices_;
+		const Animation* animation_;
+		const Skeleton* skeleton_;
+		Int32 frame_;
+	};
+
+	/**
+	Shares sampled poses between instances playing the same animation on the same skeleton at the same time, e.g. in crowds.
+	Times are rounded to a fixed time step so nearby times share a pose. Least recently used poses are dropped to stay
+	within a memory budget, and their storage is reused for the next pose that's sampled.
+	The cache isn't thread safe.
+	*/
+	class PoseCache
+	{
+	public:
+		PoseCache();
+
+		/// @brief Sets up the cache, discarding any poses already in it.
+		/// @param[in] memory_budget	The most bytes of pose data to keep.
+		/// @param[in] time_step		The time between the times that poses are sampled at, e.g. 1/30 for 30 poses a second.
+		void Init(const UInt32 memory_budget, const float time_step);
+
+		/// @brief Gets a pose, sampling it if it isn't in the cache.
+		/// @param[in] anim			The animation.
+		/// @param[in] bind_pose	The bind pose, which provides the skeleton and the pose of any joints that aren't animated.
+		/// @param[in] time			The time. It's rounded to the nearest multiple of the time step.
+		/// @return The pose. It is only valid until the next call to GetPose, which can reuse its storage.
+		const CachedPose& GetPose(const Animation& anim, const SkeletonPose& bind_pose, const float time);
+
+		/// @brief Discards every pose, e.g. when an animation is unloaded.
+		void Clear();
+
+		/// @brief Get the time a pose is sampled at for a time.
+		float QuantiseTime(const float time) const;
+
+		inline UInt32 memory_used() const { return memory_used_; }
+		inline UInt32 memory_budget() const { return memory_budget_; }
+		inline Int32 pose_count() const { return (Int32)poses_.size(); }
+		inline UInt32 hit_count() const { return hit_count_; }
+		inline UInt32 miss_count() const { return miss_count_; }
+
+	private:
+		struct Key
+		{
+			const Animation* animation;
+			const Skeleton* skeleton;
+			Int32 frame;
+
+			bool operator<(const Key& key) const;
+		};
+
+		typedef std::list<CachedPose> PoseList;
+
+		static UInt32 GetPoseMemory(const Int32 joint_count);
+		Int32 QuantiseFrame(const float time) const;
+
+		/// Most recently used first.
+		PoseList poses_;
+
+		/// Holds the last pose evicted to make room for a new one, so its storage can be reused.
+		PoseList spare_poses_;
+
+		std::map<Key, PoseList::iterator> pose_lookup_;
+
+		/// Used to sample poses before they are copied in to the cache.
+		SkeletonPose sample_pose_;
+
+		UInt32 memory_budget_;
+		UInt32 memory_used_;
+		float time_step_;
+		UInt32 hit_count_;
+		UInt32 miss_count_;
+	};
+}
+
+#endif // _GEF_POSE_CACHE_H
@@ -0,0 +1,88 @@
+#include <animation/pose_update_batch.h>
+#include <animation/skeleton.h>
+#include <animation/animation.h>
+#include <animation/baked_animation.h>
+#include <graphics/skinned_mesh_instance.h>
+
+namespace gef
+{
+	PoseUpdateJob::PoseUpdateJob() :
+		pose(NULL),
+		animation(NULL),
+		bind_pose(NULL),
+		baked_animation(NULL),
+		time(0.0f),
+		context(NULL),
+		pose_transform(NULL),
+		mesh_instance(NULL)
+	{
+	}
+
+	PoseUpdateBatch::PoseUpdateBatch()
+	{
+	}
+
+	PoseUpdateBatch::~PoseUpdateBatch()
+	{
+		CleanUp();
+	}
+
+	void PoseUpdateBatch::Init(const Int32 max_job_count, const Int32 worker_count)
+	{
+		CleanUp();
+
+		jobs_.reserve(max_job_count);
+		worker_pool_.Init(worker_count);
+	}
+
+	void PoseUpdateBatch::CleanUp()
+	{
+		worker_pool_.CleanUp();
+		std::vector<PoseUpdateJob>().swap(jobs_);
+	}
+
+	bool PoseUpdateBatch::AddJob(const PoseUpdateJob& job)
+	{
+		// the job array never grows once it has been allocated
+		if (jobs_.size() == jobs_.capacity())
+			return false;
+
+		jobs_.push_back(job);
+		return true;
+	}
+
+	void PoseUpdateBatch::Update()
+	{
+		// jobs are taken one at a time as they vary a lot in cost with the number of joints
+		worker_pool_.Run((Int32)jobs_.size(), RunJob, this);
+	}
+
+	Int32 PoseUpdateBatch::GetDefaultWorkerCount()
+	{
+		return WorkerPool::GetDefaultWorkerCount();
+	}
+
+	void PoseUpdateBatch::RunJob(void* batch, const Int32 job_index)
+	{
+		const PoseUpdateJob& job = static_cast<PoseUpdateBatch*>(batch)->jobs_[job_index];
+		if (!job.pose)
+			return;
+
+		if (job.baked_animation)
+		{
+			job.pose->SetPoseFromAnim(*job.baked_animation, job.time, job.context, false);
+		}
+		else if (job.animation && job.bind_pose)
+		{
+			if (job.context)
+				job.pose->SetPoseFromAnim(*job.animation, *job.bind_pose, job.time, *job.context, false);
+			else
+				job.pose->SetPoseFromAnim(*job.animation, *job.bind_pose, job.time, false);
+		}
+
+		job.pose->CalculateGlobalPose(job.pose_transform);
+
+		if (job.mesh_instance)
+			job.mesh_instance->UpdateBoneMatrices(*job.pose);
+	}
+}
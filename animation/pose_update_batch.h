@@ -0,0 +1,96 @@
+#ifndef _GEF_POSE_UPDATE_BATCH_H
+#define _GEF_POSE_UPDATE_BATCH_H
+
+#include <gef.h>
+#include <system/worker_pool.h>
+#include <vector>
+
+namespace gef
+{
+	// forward declarations
+	class Animation;
+	class BakedAnimation;
+	class AnimationSamplingContext;
+	class SkeletonPose;
+	class SkinnedMeshInstance;
+	class Matrix44;
+
+	/**
+	The work to update one animated character: sample its local pose, calculate the global pose and,
+	optionally, update the bone matrices of its mesh instance.
+	*/
+	struct PoseUpdateJob
+	{
+		PoseUpdateJob();
+
+		/// The pose to update. Must not be used by any other job in the same batch.
+		SkeletonPose* pose;
+
+		/// The animation to sample. baked_animation is used if it isn't NULL, otherwise animation and bind_pose are used.
+		const Animation* animation;
+		const SkeletonPose* bind_pose;
+		const BakedAnimation* baked_animation;
+
+		/// The time to sample the animation at.
+		float time;
+
+		/// If not NULL, the sampling state of the instance playing the animation. Must not be used by any other job in the same batch.
+		AnimationSamplingContext* context;
+
+		/// If not NULL, passed to SkeletonPose::CalculateGlobalPose.
+		const Matrix44* pose_transform;
+
+		/// If not NULL, the mesh instance to update the bone matrices of. Must not be used by any other job in the same batch.
+		SkinnedMeshInstance* mesh_instance;
+	};
+
+	/**
+	Updates the poses of many animated characters at once, sharing the jobs between worker threads and the calling thread.
+	Every job only writes to its own pose, sampling context and mesh instance, so the results are the same as updating each
+	one in turn whatever the number of threads. The job array is allocated by Init, so adding and running jobs doesn't allocate
+	as long as the poses and contexts have already been set up for their skeletons.
+	*/
+	class PoseUpdateBatch
+	{
+	public:
+		PoseUpdateBatch();
+		~PoseUpdateBatch();
+
+		/// @brief Allocates the job array and starts the worker threads.
+		/// @param[in] max_job_count	The most jobs that can be added between updates.
+		/// @param[in] worker_count		The number of worker threads. Zero runs every job on the thread that calls Update.
+		/// @note Anything from a previous Init is cleaned up first.
+		void Init(const Int32 max_job_count, const Int32 worker_count);
+
+		/// @brief Stops the worker threads and frees the job array.
+		void CleanUp();
+
+		/// @brief Adds a job to be run by the next Update.
+		/// @return false if the batch already holds max_job_count jobs.
+		bool AddJob(const PoseUpdateJob& job);
+
+		/// @brief Removes all the jobs.
+		inline void ClearJobs() { jobs_.clear(); }
+
+		/// @brief Runs all the jobs and waits for them to finish. The jobs are kept so they can be updated and run again.
+		void Update();
+
+		/// @brief Gets the number of worker threads that can be used by this machine in addition to the calling thread.
+		static Int32 GetDefaultWorkerCount();
+
+		inline Int32 job_count() const { return (Int32)jobs_.size(); }
+		inline PoseUpdateJob& job(const Int32 index) { return jobs_[index]; }
+		inline Int32 worker_count() const { return worker_pool_.worker_count(); }
+
+	private:
+		PoseUpdateBatch(const PoseUpdateBatch&);
+		PoseUpdateBatch& operator=(const PoseUpdateBatch&);
+
+		static void RunJob(void* batch, const Int32 job_index);
+
+		std::vector<PoseUpdateJob> jobs_;
+		WorkerPool worker_pool_;
+	};
+}
+
+#endif // _GEF_POSE_UPDATE_BATCH_H
@@ -1,5 +1,10 @@
 #include <animation/skeleton.h>
 #include <animation/animation.h>
+#include <animation/baked_animation.h>
+#include <animation/compressed_anim_node.h>
+#include <animation/bone_mask.h>
+#include <maths/simd.h>
+#include <assert.h>
 
 namespace gef
 {
@@ -35,35 +40,246 @@ namespace gef
 			return &joints_[joint_index];
 	}
 
+	bool Skeleton::HasParentsBeforeChildren() const
+	{
+		Int32 joint_num = 0;
+		for(std::vector<Joint>::const_iterator joint_iter = joints_.begin(); joint_iter != joints_.end(); ++joint_iter, ++joint_num)
+		{
+			if(joint_iter->parent >= joint_num)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool Skeleton::SortJoints(std::vector<Int32>* new_joint_indices)
+	{
+		const Int32 joint_count = (Int32)joints_.size();
+		std::vector<Int32> joint_order;
+		std::vector<Int32> new_indices(joint_count, -1);
+		std::vector<Int32> ancestors;
+		joint_order.reserve(joint_count);
+
+		// add each joint in turn, after any of its ancestors that haven't been added yet
+		for(Int32 joint_num = 0; joint_num < joint_count; ++joint_num)
+		{
+			ancestors.clear();
+			for(Int32 ancestor = joint_num; ancestor != -1 && new_indices[ancestor] == -1; ancestor = joints_[ancestor].parent)
+				ancestors.push_back(ancestor);
+
+			for(std::vector<Int32>::reverse_iterator ancestor_iter = ancestors.rbegin(); ancestor_iter != ancestors.rend(); ++ancestor_iter)
+			{
+				new_indices[*ancestor_iter] = (Int32)joint_order.size();
+				joint_order.push_back(*ancestor_iter);
+			}
+		}
+
+		bool moved = false;
+		std::vector<Joint> sorted_joints(joint_count);
+		for(Int32 joint_num = 0; joint_num < joint_count; ++joint_num)
+		{
+			const Joint& joint = joints_[joint_order[joint_num]];
+			sorted_joints[joint_num] = joint;
+			sorted_joints[joint_num].parent = joint.parent == -1 ? -1 : new_indices[joint.parent];
+			moved = moved || joint_order[joint_num] != joint_num;
+		}
+		joints_.swap(sorted_joints);
+
+		if(new_joint_indices)
+			new_joint_indices->swap(new_indices);
+
+		return moved;
+	}
+
+	// sets a joint pose from the animation, using the bind pose for anything that isn't animated.
+	// if cursor is NULL each track is searched without using the keys from the previous sample
+	static void SampleJointPose(JointPose& joint_pose, const Animation* anim, const SkeletonPose& bind_pose, const float time, const Int32 joint_index, TransformAnimNodeCursor* cursor)
+	{
+		const AnimNode* anim_node = NULL;
+		if (anim)
+			anim_node = anim->FindNode(bind_pose.skeleton()->joints()[joint_index].name_id);
+
+		if(anim_node)
+		{
+			if(anim_node->type() == AnimNode::kTransform) // this should always be true since the find uses the joint transform name
+			{
+				const TransformAnimNode* transform_node = static_cast<const TransformAnimNode*>(anim_node);
+				TransformAnimNodeCursor search_cursor;
+				TransformAnimNodeCursor& track_cursor = cursor ? *cursor : search_cursor;
+
+				// scale
+				if(transform_node->scale_keys().size() > 0.f)
+					joint_pose.set_scale(transform_node->GetScale(time, track_cursor));
+				else
+					joint_pose.set_scale(bind_pose.local_pose()[joint_index].scale());
+				joint_pose.set_scale(gef::Vector4(1.f, 1.f, 1.f));
+
+				// rotation
+				if(transform_node->rotation_keys().size() > 0.f)
+					joint_pose.set_rotation(transform_node->GetRotation(time, track_cursor));
+				else
+					joint_pose.set_rotation(bind_pose.local_pose()[joint_index].rotation());
+
+				// translation
+				if(transform_node->translation_keys().size() > 0.f)
+					joint_pose.set_translation(transform_node->GetTranslation(time, track_cursor));
+				else
+					joint_pose.set_translation(bind_pose.local_pose()[joint_index].translation());
+			}
+			else if(anim_node->type() == AnimNode::kSampledTransform)
+			{
+				const SampledTransformAnimNode* sampled_node = static_cast<const SampledTransformAnimNode*>(anim_node);
+
+				joint_pose.set_scale(gef::Vector4(1.f, 1.f, 1.f));
+
+				if(sampled_node->rotations().size() > 0)
+					joint_pose.set_rotation(sampled_node->GetRotation(time));
+				else
+					joint_pose.set_rotation(bind_pose.local_pose()[joint_index].rotation());
+
+				if(sampled_node->translations().size() > 0)
+					joint_pose.set_translation(sampled_node->GetTranslation(time));
+				else
+					joint_pose.set_translation(bind_pose.local_pose()[joint_index].translation());
+			}
+			else if(anim_node->type() == AnimNode::kCompressedTransform)
+			{
+				const CompressedTransformAnimNode* compressed_node = static_cast<const CompressedTransformAnimNode*>(anim_node);
+				TransformAnimNodeCursor search_cursor;
+				TransformAnimNodeCursor& track_cursor = cursor ? *cursor : search_cursor;
+
+				joint_pose.set_scale(gef::Vector4(1.f, 1.f, 1.f));
+
+				if(compressed_node->rotation_key_count() > 0)
+					joint_pose.set_rotation(compressed_node->GetRotation(time, track_cursor));
+				else
+					joint_pose.set_rotation(bind_pose.local_pose()[joint_index].rotation());
+
+				if(compressed_node->translation_key_count() > 0)
+					joint_pose.set_translation(compressed_node->GetTranslation(time, track_cursor));
+				else
+					joint_pose.set_translation(bind_pose.local_pose()[joint_index].translation());
+			}
+		}
+		else
+		{
+			joint_pose = bind_pose.local_pose()[joint_index];
+		}
+	}
+
 	SkeletonPose::SkeletonPose() :
 	skeleton_(NULL)
 	{
 	}
 
+	// converts the local poses of four joints to matrices, the same as JointPose::GetMatrix.
+	// The poses are transposed so each SimdVector holds one component of all four joints
+	static void CalculateLocalMatrices4(Matrix44* matrices, const JointPose* joint_poses)
+	{
+		SimdVector qx = SimdLoad(&joint_poses[0].rotation().x);
+		SimdVector qy = SimdLoad(&joint_poses[1].rotation().x);
+		SimdVector qz = SimdLoad(&joint_poses[2].rotation().x);
+		SimdVector qw = SimdLoad(&joint_poses[3].rotation().x);
+		SimdTranspose(qx, qy, qz, qw);
+
+		SimdVector sx = SimdLoad(joint_poses[0].scale().float_ptr());
+		SimdVector sy = SimdLoad(joint_poses[1].scale().float_ptr());
+		SimdVector sz = SimdLoad(joint_poses[2].scale().float_ptr());
+		SimdVector sw = SimdLoad(joint_poses[3].scale().float_ptr());
+		SimdTranspose(sx, sy, sz, sw);
+
+		SimdVector tx = SimdLoad(joint_poses[0].translation().float_ptr());
+		SimdVector ty = SimdLoad(joint_poses[1].translation().float_ptr());
+		SimdVector tz = SimdLoad(joint_poses[2].translation().float_ptr());
+		SimdVector tw = SimdLoad(joint_poses[3].translation().float_ptr());
+		SimdTranspose(tx, ty, tz, tw);
+
+		// rotation matrix, as Matrix44::Rotation
+		const SimdVector two = SimdSplat(2.0f);
+		const SimdVector sqx = SimdMul(qx, qx);
+		const SimdVector sqy = SimdMul(qy, qy);
+		const SimdVector sqz = SimdMul(qz, qz);
+		const SimdVector sqw = SimdMul(qw, qw);
+		const SimdVector xy = SimdMul(qx, qy);
+		const SimdVector zw = SimdMul(qz, qw);
+		const SimdVector xz = SimdMul(qx, qz);
+		const SimdVector yw = SimdMul(qy, qw);
+		const SimdVector yz = SimdMul(qy, qz);
+		const SimdVector xw = SimdMul(qx, qw);
+
+		// rows of the rotation matrix scaled by the scale of each axis
+		SimdVector m00 = SimdMul(sx, SimdAdd(SimdSub(SimdSub(sqx, sqy), sqz), sqw));
+		SimdVector m01 = SimdMul(sx, SimdMul(two, SimdAdd(xy, zw)));
+		SimdVector m02 = SimdMul(sx, SimdMul(two, SimdSub(xz, yw)));
+		SimdVector m10 = SimdMul(sy, SimdMul(two, SimdSub(xy, zw)));
+		SimdVector m11 = SimdMul(sy, SimdAdd(SimdSub(SimdSub(sqy, sqx), sqz), sqw));
+		SimdVector m12 = SimdMul(sy, SimdMul(two, SimdAdd(yz, xw)));
+		SimdVector m20 = SimdMul(sz, SimdMul(two, SimdAdd(xz, yw)));
+		SimdVector m21 = SimdMul(sz, SimdMul(two, SimdSub(yz, xw)));
+		SimdVector m22 = SimdMul(sz, SimdAdd(SimdSub(sqz, SimdAdd(sqx, sqy)), sqw));
+		SimdVector m03 = SimdZero();
+		SimdVector m13 = SimdZero();
+		SimdVector m23 = SimdZero();
+		SimdVector m33 = SimdSplat(1.0f);
+
+		// transpose back to a row of each matrix
+		SimdTranspose(m00, m01, m02, m03);
+		SimdTranspose(m10, m11, m12, m13);
+		SimdTranspose(m20, m21, m22, m23);
+		SimdTranspose(tx, ty, tz, m33);
+
+		float* matrix = (float*)matrices[0].float_ptr();
+		SimdStore(matrix, m00); SimdStore(matrix+4, m10); SimdStore(matrix+8, m20); SimdStore(matrix+12, tx);
+		matrix = (float*)matrices[1].float_ptr();
+		SimdStore(matrix, m01); SimdStore(matrix+4, m11); SimdStore(matrix+8, m21); SimdStore(matrix+12, ty);
+		matrix = (float*)matrices[2].float_ptr();
+		SimdStore(matrix, m02); SimdStore(matrix+4, m12); SimdStore(matrix+8, m22); SimdStore(matrix+12, tz);
+		matrix = (float*)matrices[3].float_ptr();
+		SimdStore(matrix, m03); SimdStore(matrix+4, m13); SimdStore(matrix+8, m23); SimdStore(matrix+12, m33);
+	}
+
 	void SkeletonPose::CalculateGlobalPose(const gef::Matrix44 * const pose_transform)
 	{
 		if(skeleton_)
 		{
 			const std::vector<Joint>& joints = skeleton_->joints();
-			for(UInt32 jointNum=0; jointNum<joints.size(); jointNum++)
+			const Int32 joint_count = (Int32)joints.size();
+			if((Int32)global_pose_.size() != joint_count)
+				global_pose_.resize(joint_count);
+			if(joint_count == 0)
+				return;
+
+			// convert the local poses to matrices four joints at a time, straight in to the global pose
+			Int32 joint_num = 0;
+			for(; joint_num + 4 <= joint_count; joint_num += 4)
+				CalculateLocalMatrices4(&global_pose_[joint_num], &local_pose_[joint_num]);
+
+			if(joint_num < joint_count)
 			{
-				const Joint& joint = joints[jointNum];
-				Matrix44 local_pose_matrix = local_pose()[jointNum].GetMatrix();
-				Matrix44 global_pose_matrix;
-				if(joint.parent == -1)
-				{
-					global_pose_matrix = local_pose_matrix;
-					if(pose_transform)
-						global_pose_matrix = global_pose_matrix * (*pose_transform);
-				}
-				else
-					global_pose_matrix = local_pose_matrix * global_pose()[joint.parent];
+				JointPose joint_poses[4];
+				Matrix44 local_matrices[4];
+				for(Int32 remaining_num = 0; joint_num + remaining_num < joint_count; ++remaining_num)
+					joint_poses[remaining_num] = local_pose_[joint_num + remaining_num];
+				CalculateLocalMatrices4(local_matrices, joint_poses);
+				for(Int32 remaining_num = 0; joint_num + remaining_num < joint_count; ++remaining_num)
+					global_pose_[joint_num + remaining_num] = local_matrices[remaining_num];
+			}
+
+			// then concatenate them with their parents, which the skeleton has before their children.
+			// consecutive joints with the same parent, e.g. fingers, are concatenated together
+			for(joint_num = 0; joint_num < joint_count;)
+			{
+				const Int32 parent = joints[joint_num].parent;
+				Int32 sibling_count = 1;
+				while(joint_num + sibling_count < joint_count && joints[joint_num + sibling_count].parent == parent)
+					++sibling_count;
 
+				if(parent != -1)
+					Matrix44::MultiplyArray(&global_pose_[joint_num], &global_pose_[joint_num], global_pose_[parent], sibling_count);
+				else if(pose_transform)
+					Matrix44::MultiplyArray(&global_pose_[joint_num], &global_pose_[joint_num], *pose_transform, sibling_count);
 
-				if(global_pose_.size() > jointNum )
-					global_pose_[jointNum] = global_pose_matrix;
-				else
-					global_pose_.push_back(global_pose_matrix);
+				joint_num += sibling_count;
 			}
 		}
 	}
@@ -83,7 +299,7 @@ namespace gef
 				else
 				{
 					Matrix44 inv_parent_matrix;
-					inv_parent_matrix.Inverse(global_pose_matrices[joint.parent]);
+					inv_parent_matrix.AffineInverseScaled(global_pose_matrices[joint.parent]);
 					local_pose_matrix = global_pose_matrix * inv_parent_matrix;
 				}
 
@@ -107,7 +323,7 @@ namespace gef
 				const Joint& joint = skeleton->joints()[jointNum];
 				if(joint.parent == -1)
 				{
-					local_matrix.Inverse(joint.inv_bind_pose);
+					local_matrix.AffineInverseScaled(joint.inv_bind_pose);
 					global_bind_matrix = local_matrix;
 				}
 				else
@@ -115,7 +331,7 @@ namespace gef
 					const Joint& parent_joint = skeleton->joints()[joint.parent];
 					Matrix44 invParentMatrix = parent_joint.inv_bind_pose;
 
-					global_bind_matrix.Inverse(joint.inv_bind_pose);
+					global_bind_matrix.AffineInverseScaled(joint.inv_bind_pose);
 					local_matrix = global_bind_matrix*invParentMatrix;
 				}
 
@@ -132,49 +348,32 @@ namespace gef
 
 	void SkeletonPose::SetPoseFromAnim(const Animation& anim, const SkeletonPose& bind_pose, float time, const bool updateGlobalPose)
 	{
-		Int32 joint_index=0;
-		for(std::vector<JointPose>::iterator joint_iter = local_pose_.begin(); joint_iter != local_pose_.end(); ++joint_iter, ++joint_index)
-		{
-			const AnimNode* anim_node = anim.FindNode(skeleton_->joints()[joint_index].name_id);
-			JointPose& joint_pose = local_pose_[joint_index];
+		if(!local_pose_.empty())
+			SampleLocalPose(anim, bind_pose, time, &local_pose_[0], NULL);
 
-//			if(joint_index != 1)
-//				anim_node = NULL;
-			if(anim_node)
-			{
-				if(anim_node->type() == AnimNode::kTransform) // this should always be true since the find uses the joint transform name
-				{
-					const TransformAnimNode* transform_node = static_cast<const TransformAnimNode*>(anim_node);
-
-					// scale
-					if(transform_node->scale_keys().size() > 0.f)
-						joint_pose.set_scale(transform_node->GetScale(time));
-					else
-						joint_pose.set_scale(bind_pose.local_pose()[joint_index].scale());
-					joint_pose.set_scale(gef::Vector4(1.f, 1.f, 1.f));
-
-					// rotation
-					if(transform_node->rotation_keys().size() > 0.f)
-						joint_pose.set_rotation(transform_node->GetRotation(time));
-					else
-						joint_pose.set_rotation(bind_pose.local_pose()[joint_index].rotation());
-
-					// translation
-					if(transform_node->translation_keys().size() > 0.f)
-						joint_pose.set_translation(transform_node->GetTranslation(time));
-					else
-						joint_pose.set_translation(bind_pose.local_pose()[joint_index].translation());
-				}
-			}
-			else
-			{
-				joint_pose = bind_pose.local_pose()[joint_index];
-			}
+		if(updateGlobalPose)
+			CalculateGlobalPose();
+	}
+
+	void SkeletonPose::SetPoseFromAnim(const Animation& anim, const SkeletonPose& bind_pose, const float time, AnimationSamplingContext& context, const bool update_global_pose)
+	{
+		if(!local_pose_.empty())
+			SampleLocalPose(anim, bind_pose, time, &local_pose_[0], &context);
+
+		if(update_global_pose)
+			CalculateGlobalPose();
+	}
 
-			// check to see if there is a pose transform
-			// if so use it to transform any root joints
-//			if(pose_transform && joint_index == 1)
-//				joint_pose.Set(joint_pose.GetMatrix() * *pose_transform);
+	void SkeletonPose::SampleLocalPose(const Animation& anim, const SkeletonPose& bind_pose, const float time, JointPose* local_pose, AnimationSamplingContext* context)
+	{
+		const Int32 joint_count = (Int32)bind_pose.local_pose().size();
+		if(context && context->track_count() != joint_count)
+			context->Init(joint_count);
+
+		for(Int32 joint_index = 0; joint_index < joint_count; ++joint_index)
+		{
+			JointPose& joint_pose = local_pose[joint_index];
+			SampleJointPose(joint_pose, &anim, bind_pose, time, joint_index, context ? &context->cursor(joint_index) : NULL);
 
 #ifdef REMOVE_BIND_POSE
 			gef::Matrix44 inv_local_joint_orient;
@@ -182,12 +381,74 @@ namespace gef
 			inv_local_joint_orient.SetTranslation(gef::Vector4(0.f, 0.f, 0.f));
 			joint_pose.Set(inv_local_joint_orient * joint_pose.GetMatrix());
 #endif
-		
-		
-//			break;
 		}
+	}
 
-		if(updateGlobalPose)
+	void SkeletonPose::SetPoseFromAnim(const Animation& anim, const SkeletonPose& bind_pose, const float time, const BoneMask& mask, AnimationSamplingContext* context, const bool update_global_pose)
+	{
+		const Int32 joint_count = (Int32)local_pose_.size();
+		if(mask.joint_count() != joint_count)
+			return;
+		if(context && context->track_count() != joint_count)
+			context->Init(joint_count);
+
+		for(std::vector<Int32>::const_iterator joint_iter = mask.joint_indices().begin(); joint_iter != mask.joint_indices().end(); ++joint_iter)
+		{
+			const Int32 joint_index = *joint_iter;
+			const float weight = mask.joint_weight(joint_index);
+
+			JointPose joint_pose;
+			SampleJointPose(joint_pose, &anim, bind_pose, time, joint_index, context ? &context->cursor(joint_index) : NULL);
+
+			if(weight >= 1.0f)
+				local_pose_[joint_index] = joint_pose;
+			else
+			{
+				const JointPose current_pose = local_pose_[joint_index];
+				local_pose_[joint_index].Linear2TransformBlend(current_pose, joint_pose, weight);
+			}
+		}
+
+		if(update_global_pose)
+			CalculateGlobalPose();
+	}
+
+	void SkeletonPose::AddPoseFromAnim(const Animation& anim, const SkeletonPose& reference_pose, const SkeletonPose& bind_pose, const float time, const float weight,
+		const BoneMask* mask, AnimationSamplingContext* context, const bool update_global_pose)
+	{
+		const Int32 joint_count = (Int32)local_pose_.size();
+		if((mask && mask->joint_count() != joint_count) || (Int32)reference_pose.local_pose().size() != joint_count)
+			return;
+		if(context && context->track_count() != joint_count)
+			context->Init(joint_count);
+
+		if(weight > 0.0f)
+		{
+			const Int32 mask_joint_count = mask ? (Int32)mask->joint_indices().size() : joint_count;
+			for(Int32 mask_joint_num = 0; mask_joint_num < mask_joint_count; ++mask_joint_num)
+			{
+				const Int32 joint_index = mask ? mask->joint_indices()[mask_joint_num] : mask_joint_num;
+				const float joint_weight = mask ? weight*mask->joint_weight(joint_index) : weight;
+
+				JointPose additive_pose;
+				SampleJointPose(additive_pose, &anim, bind_pose, time, joint_index, context ? &context->cursor(joint_index) : NULL);
+				AddJointPose(local_pose_[joint_index], additive_pose, reference_pose.local_pose()[joint_index], joint_weight);
+			}
+		}
+
+		if(update_global_pose)
+			CalculateGlobalPose();
+	}
+
+	void SkeletonPose::SetPoseFromAnim(const BakedAnimation& anim, const float time, AnimationSamplingContext* context, const bool update_global_pose)
+	{
+		// the animation must have been baked for this skeleton
+		if(anim.skeleton() != skeleton_ || local_pose_.empty())
+			return;
+
+		anim.SampleLocalPose(time, &local_pose_[0], context);
+
+		if(update_global_pose)
 			CalculateGlobalPose();
 	}
 
@@ -213,46 +474,11 @@ namespace gef
 		global_pose_.clear();
 	}
 
-	gef::Matrix44 SkeletonPose::GetGlobalJointTransformFromAnim(const class Animation* anim, const SkeletonPose& bind_pose, float time, const Int32 joint_index)
+	// the local transform of a joint, as used in the global transform calculations
+	static const gef::Matrix44 GetLocalJointTransform(const Animation* anim, const SkeletonPose& bind_pose, const float time, const Int32 joint_index, TransformAnimNodeCursor* cursor)
 	{
-		const gef::Skeleton* skeleton = bind_pose.skeleton();
-
-		// calculate the transform for this joint
-		const AnimNode* anim_node = NULL;
-		
-		if (anim)
-			anim_node = anim->FindNode(skeleton->joints()[joint_index].name_id);
 		JointPose joint_pose;
-		if(anim_node)
-		{
-			if(anim_node->type() == AnimNode::kTransform) // this should always be true since the find uses the joint transform name
-			{
-				const TransformAnimNode* transform_node = static_cast<const TransformAnimNode*>(anim_node);
-
-				// scale
-				if(transform_node->scale_keys().size() > 0.f)
-					joint_pose.set_scale(transform_node->GetScale(time));
-				else
-					joint_pose.set_scale(bind_pose.local_pose()[joint_index].scale());
-				joint_pose.set_scale(gef::Vector4(1.f, 1.f, 1.f));
-
-				// rotation
-				if(transform_node->rotation_keys().size() > 0.f)
-					joint_pose.set_rotation(transform_node->GetRotation(time));
-				else
-					joint_pose.set_rotation(bind_pose.local_pose()[joint_index].rotation());
-
-				// translation
-				if(transform_node->translation_keys().size() > 0.f)
-					joint_pose.set_translation(transform_node->GetTranslation(time));
-				else
-					joint_pose.set_translation(bind_pose.local_pose()[joint_index].translation());
-			}
-		}
-		else
-		{
-			joint_pose = bind_pose.local_pose()[joint_index];
-		}
+		SampleJointPose(joint_pose, anim, bind_pose, time, joint_index, cursor);
 
 #ifdef REMOVE_BIND_POSE
 		gef::Matrix44 inv_local_joint_orient;
@@ -262,53 +488,99 @@ namespace gef
 		joint_pose.Set(inv_local_joint_orient * joint_pose.GetMatrix());
 #endif
 
+		return joint_pose.GetMatrix();
+	}
+
+	gef::Matrix44 SkeletonPose::GetGlobalJointTransformFromAnim(const class Animation* anim, const SkeletonPose& bind_pose, float time, const Int32 joint_index)
+	{
+		const gef::Skeleton* skeleton = bind_pose.skeleton();
+
 		// multiply the joint transform by all the parent joint transforms
-		Int32 parent = skeleton->joint(joint_index).parent;
-		if(parent == -1)
-			return joint_pose.GetMatrix();
-		else
-			return joint_pose.GetMatrix() * GetGlobalJointTransformFromAnim(anim, bind_pose, time, parent);
+		gef::Matrix44 global_transform = GetLocalJointTransform(anim, bind_pose, time, joint_index, NULL);
+		for(Int32 parent = skeleton->joint(joint_index).parent; parent != -1; parent = skeleton->joint(parent).parent)
+			global_transform = global_transform * GetLocalJointTransform(anim, bind_pose, time, parent, NULL);
+
+		return global_transform;
 	}
 
+	JointTransformCache::JointTransformCache() :
+		bind_pose_(NULL),
+		anim_(NULL),
+		time_(0.0f),
+		stamp_(1)
+	{
+	}
 
-	gef::Matrix44 SkeletonPose::GetJointTransformFromAnim(const class Animation& anim, const SkeletonPose& bind_pose, float time, const Int32 joint_index)
+	void JointTransformCache::Init(const SkeletonPose& bind_pose)
 	{
-		const gef::Skeleton* skeleton = bind_pose.skeleton();
+		const Int32 joint_count = bind_pose.skeleton() ? bind_pose.skeleton()->joint_count() : 0;
+
+		bind_pose_ = &bind_pose;
+		global_transforms_.resize(joint_count);
+		joint_stamps_.assign(joint_count, 0);
+		joint_chain_.resize(joint_count);
+		context_.Init(joint_count);
+		anim_ = NULL;
+		time_ = 0.0f;
+		stamp_ = 1;
+	}
 
-		// calculate the transform for this joint
-		const AnimNode* anim_node = anim.FindNode(skeleton->joints()[joint_index].name_id);
-		JointPose joint_pose;
-		if(anim_node)
+	void JointTransformCache::Invalidate()
+	{
+		// the stamps of cached joints never match after this, so nothing needs to be cleared unless the stamp wraps around
+		++stamp_;
+		if(stamp_ == 0)
 		{
-			if(anim_node->type() == AnimNode::kTransform) // this should always be true since the find uses the joint transform name
-			{
-				const TransformAnimNode* transform_node = static_cast<const TransformAnimNode*>(anim_node);
-
-				// scale
-				if(transform_node->scale_keys().size() > 0.f)
-					joint_pose.set_scale(transform_node->GetScale(time));
-				else
-					joint_pose.set_scale(bind_pose.local_pose()[joint_index].scale());
-				joint_pose.set_scale(gef::Vector4(1.f, 1.f, 1.f));
+			joint_stamps_.assign(joint_stamps_.size(), 0);
+			stamp_ = 1;
+		}
+	}
 
-				// rotation
-				if(transform_node->rotation_keys().size() > 0.f)
-					joint_pose.set_rotation(transform_node->GetRotation(time));
-				else
-					joint_pose.set_rotation(bind_pose.local_pose()[joint_index].rotation());
+	const Matrix44& JointTransformCache::GetGlobalJointTransform(const Animation* anim, const float time, const Int32 joint_index)
+	{
+		if(anim != anim_ || time != time_)
+		{
+			if(anim != anim_)
+				context_.Reset();
 
-				// translation
-				if(transform_node->translation_keys().size() > 0.f)
-					joint_pose.set_translation(transform_node->GetTranslation(time));
-				else
-					joint_pose.set_translation(bind_pose.local_pose()[joint_index].translation());
-			}
+			anim_ = anim;
+			time_ = time;
+			Invalidate();
 		}
-		else
+
+		if(joint_stamps_[joint_index] == stamp_)
+			return global_transforms_[joint_index];
+
+		// find the joints that haven't been sampled yet, stopping at the first ancestor that has
+		const Skeleton* skeleton = bind_pose_->skeleton();
+		Int32 chain_length = 0;
+		for(Int32 chain_joint = joint_index; chain_joint != -1 && joint_stamps_[chain_joint] != stamp_; chain_joint = skeleton->joint(chain_joint).parent)
+			joint_chain_[chain_length++] = chain_joint;
+
+		// then calculate them from the top of the chain down
+		for(Int32 chain_num = chain_length - 1; chain_num >= 0; --chain_num)
 		{
-			joint_pose = bind_pose.local_pose()[joint_index];
+			const Int32 chain_joint = joint_chain_[chain_num];
+			const Int32 parent = skeleton->joint(chain_joint).parent;
+
+			const Matrix44 local_transform = GetLocalJointTransform(anim_, *bind_pose_, time_, chain_joint, &context_.cursor(chain_joint));
+			if(parent == -1)
+				global_transforms_[chain_joint] = local_transform;
+			else
+				global_transforms_[chain_joint] = local_transform * global_transforms_[parent];
+
+			joint_stamps_[chain_joint] = stamp_;
 		}
 
+		return global_transforms_[joint_index];
+	}
+
+	gef::Matrix44 SkeletonPose::GetJointTransformFromAnim(const class Animation& anim, const SkeletonPose& bind_pose, float time, const Int32 joint_index)
+	{
+		// calculate the transform for this joint
+		JointPose joint_pose;
+		SampleJointPose(joint_pose, &anim, bind_pose, time, joint_index, NULL);
+
 		return joint_pose.GetMatrix();
 	}
 
@@ -321,6 +593,9 @@ namespace gef
 		joints_.resize(num_joints);
 		stream.read((char*)&joints_.front(), sizeof(Joint)*num_joints);
 
+		// files are written with the joints sorted, see SortJoints
+		assert(HasParentsBeforeChildren());
+
 		return true;
 	}
 
@@ -5,6 +5,7 @@
 #include <system/string_id.h>
 #include <maths/matrix44.h>
 #include <animation/joint.h>
+#include <animation/animation.h>
 #include <vector>
 
 #include <ostream>
@@ -13,6 +14,8 @@
 namespace gef
 {
 	struct Joint;
+	class BakedAnimation;
+	class BoneMask;
 
 	class Skeleton
 	{
@@ -21,6 +24,15 @@ namespace gef
 		Int32 FindJointIndex(const StringId joint_name) const;
 		const Joint* FindJoint(const StringId joint_name) const;
 
+		/// @brief Checks that every joint comes after its parent, which SkeletonPose::CalculateGlobalPose relies on.
+		bool HasParentsBeforeChildren() const;
+
+		/// @brief Reorders the joints so every joint comes after its parent. Joints that are already in order aren't moved.
+		/// @param[out] new_joint_indices	If not NULL, receives the new index of each joint, e.g. for remapping skinning indices.
+		/// @return true if any joints were moved.
+		/// @note Must be done before any poses are created for the skeleton.
+		bool SortJoints(std::vector<Int32>* new_joint_indices = NULL);
+
 		bool Read(std::istream& stream);
 		bool Write(std::ostream& stream) const;
 
@@ -47,6 +59,51 @@ namespace gef
 		void CalculateGlobalPose(const gef::Matrix44 * const pose_transform = NULL);
 		void CalculateLocalPose(const std::vector<Matrix44>& global_pose);
 		void SetPoseFromAnim(const class Animation& _anim, const SkeletonPose& _bindPose, const float _time, const bool _updateGlobalPose = true);
+
+		/// @brief Sets the pose from an animation, starting the search for each key from the keys used by the previous call.
+		/// @param[in] anim					The animation.
+		/// @param[in] bind_pose			The bind pose, used for any joints that aren't animated.
+		/// @param[in] time					The time to sample the animation at.
+		/// @param[in,out] context			The sampling state for the instance playing the animation. Initialised if it doesn't match the skeleton.
+		/// @param[in] update_global_pose	Whether to calculate the global pose as well.
+		void SetPoseFromAnim(const class Animation& anim, const SkeletonPose& bind_pose, const float time, AnimationSamplingContext& context, const bool update_global_pose = true);
+
+		/// @brief Sets the pose from an animation that has been baked for this pose's skeleton.
+		/// @param[in] anim					The baked animation.
+		/// @param[in] time					The time to sample the animation at.
+		/// @param[in,out] context			If not NULL, the sampling state for the instance playing the animation.
+		/// @param[in] update_global_pose	Whether to calculate the global pose as well.
+		void SetPoseFromAnim(const BakedAnimation& anim, const float time, AnimationSamplingContext* context = NULL, const bool update_global_pose = true);
+
+		/// @brief Samples the local pose of every joint in to an array, e.g. to blend it with other poses.
+		/// @param[in] anim				The animation.
+		/// @param[in] bind_pose		The bind pose, which provides the skeleton and the pose of any joints that aren't animated.
+		/// @param[in] time				The time to sample the animation at.
+		/// @param[out] local_pose		Receives a pose for each joint in the skeleton.
+		/// @param[in,out] context		If not NULL, the sampling state for the instance playing the animation. Initialised if it doesn't match the skeleton.
+		static void SampleLocalPose(const class Animation& anim, const SkeletonPose& bind_pose, const float time, JointPose* local_pose, AnimationSamplingContext* context = NULL);
+
+		/// @brief Samples an animation on to the joints in a mask, blending from the current pose by each joint's weight.
+		/// Joints that aren't in the mask are neither sampled nor changed.
+		/// @param[in] anim					The animation.
+		/// @param[in] bind_pose			The bind pose, used for any joints that aren't animated.
+		/// @param[in] time					The time to sample the animation at.
+		/// @param[in] mask					The joints to sample and their weights.
+		/// @param[in,out] context			If not NULL, the sampling state for the instance playing the animation. Initialised if it doesn't match the skeleton.
+		/// @param[in] update_global_pose	Whether to calculate the global pose as well.
+		void SetPoseFromAnim(const class Animation& anim, const SkeletonPose& bind_pose, const float time, const BoneMask& mask, AnimationSamplingContext* context = NULL, const bool update_global_pose = true);
+
+		/// @brief Adds the difference between an additive animation and a reference pose on to the current pose.
+		/// @param[in] anim					The additive animation.
+		/// @param[in] reference_pose		The pose the additive animation is relative to, e.g. its first frame.
+		/// @param[in] bind_pose			The bind pose, used for any joints that aren't animated.
+		/// @param[in] time					The time to sample the animation at.
+		/// @param[in] weight				How much of the difference to add, from zero to one.
+		/// @param[in] mask					If not NULL, only the joints in the mask are sampled and the weight is scaled by each joint's weight.
+		/// @param[in,out] context			If not NULL, the sampling state for the instance playing the animation. Initialised if it doesn't match the skeleton.
+		/// @param[in] update_global_pose	Whether to calculate the global pose as well.
+		void AddPoseFromAnim(const class Animation& anim, const SkeletonPose& reference_pose, const SkeletonPose& bind_pose, const float time, const float weight,
+			const BoneMask* mask = NULL, AnimationSamplingContext* context = NULL, const bool update_global_pose = true);
 	//	void SetLocalJointPoseFromAnim(JointPose& _jointPose, const UInt32 _jointNum, const JointPose& _jointBindPose, const class Anim& _anim, const float _time);
 		void Linear2PoseBlend(const SkeletonPose& _startPose, const SkeletonPose& _endPose, const float _time);
 
@@ -69,5 +126,45 @@ namespace gef
 		std::vector<Matrix44> global_pose_;	// global joint poses
 		const Skeleton* skeleton_;
 	};
+
+	/**
+	Global joint transforms sampled from an animation, for querying a few joints without calculating the whole pose.
+	Each joint and its ancestors are only sampled once for each animation and time, so querying many joints in
+	the same frame, e.g. for attachment points and hit boxes, costs no more than sampling every joint once.
+	*/
+	class JointTransformCache
+	{
+	public:
+		JointTransformCache();
+
+		/// @brief Allocates the cache for the skeleton of a bind pose.
+		/// @param[in] bind_pose	The bind pose, used for any joints that aren't animated. Must outlive the cache.
+		void Init(const SkeletonPose& bind_pose);
+
+		/// @brief Gets the global transform of a joint, sampling any joints in its parent chain that haven't already been sampled.
+		/// @param[in] anim			The animation. The cached transforms are discarded if it differs from the previous query.
+		/// @param[in] time			The time to sample the animation at. The cached transforms are discarded if it differs from the previous query.
+		/// @param[in] joint_index	The joint.
+		/// @return The same transform as SkeletonPose::GetGlobalJointTransformFromAnim.
+		const Matrix44& GetGlobalJointTransform(const Animation* anim, const float time, const Int32 joint_index);
+
+		/// @brief Discards the cached transforms, e.g. if the animation has been changed.
+		void Invalidate();
+
+	private:
+		std::vector<Matrix44> global_transforms_;
+
+		/// The value of stamp_ when each joint's transform was calculated. Cached transforms are discarded by changing stamp_.
+		std::vector<UInt32> joint_stamps_;
+
+		/// Storage for the joints that need to be sampled, from the queried joint up to the first cached ancestor.
+		std::vector<Int32> joint_chain_;
+
+		AnimationSamplingContext context_;
+		const SkeletonPose* bind_pose_;
+		const Animation* anim_;
+		float time_;
+		UInt32 stamp_;
+	};
 }
 #endif // _SKELETON_H
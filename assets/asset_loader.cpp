@@ -0,0 +1,334 @@
+#include <assets/asset_loader.h>
+#include <graphics/scene.h>
+#include <graphics/texture.h>
+#include <graphics/image_data.h>
+#include <graphics/mesh.h>
+#include <system/platform.h>
+#include <system/string_id.h>
+#include <chrono>
+
+namespace gef
+{
+	AssetRequest::AssetRequest() :
+		status_(kNotLoaded),
+		load_succeeded_(false),
+		callback_(NULL),
+		user_data_(NULL)
+	{
+	}
+
+	AssetRequest::~AssetRequest()
+	{
+	}
+
+	AssetRequest::CreateResult AssetRequest::Create(Platform& /*platform*/)
+	{
+		return kCreateFinished;
+	}
+
+	TextureRequest::TextureRequest(const char* filename) :
+		filename_(filename),
+		image_data_(NULL),
+		texture_(NULL)
+	{
+	}
+
+	TextureRequest::~TextureRequest()
+	{
+		delete image_data_;
+		delete texture_;
+	}
+
+	Texture* TextureRequest::ReleaseTexture()
+	{
+		Texture* texture = texture_;
+		texture_ = NULL;
+		return texture;
+	}
+
+	bool TextureRequest::Load(const Platform& /*platform*/)
+	{
+		delete image_data_;
+		image_data_ = new ImageData(filename_.c_str());
+		return image_data_->image() != NULL;
+	}
+
+	AssetRequest::CreateResult TextureRequest::Create(Platform& platform)
+	{
+		texture_ = Texture::Create(platform, *image_data_);
+
+		// the image isn't needed once the texture has been created from it
+		delete image_data_;
+		image_data_ = NULL;
+
+		return texture_ ? kCreateFinished : kCreateFailed;
+	}
+
+	SceneRequest::SceneRequest(const char* filename) :
+		filename_(filename),
+		scene_(NULL),
+		create_objects_(true),
+		max_bone_palette_size_(0),
+		next_texture_(0),
+		materials_created_(false)
+	{
+	}
+
+	SceneRequest::~SceneRequest()
+	{
+		for (std::vector<ImageData*>::iterator image_iter = images_.begin(); image_iter != images_.end(); ++image_iter)
+			delete *image_iter;
+
+		delete scene_;
+	}
+
+	Scene* SceneRequest::ReleaseScene()
+	{
+		Scene* scene = scene_;
+		scene_ = NULL;
+		return scene;
+	}
+
+	bool SceneRequest::Load(const Platform& platform)
+	{
+		// anything left from a previous load is thrown away
+		for (std::vector<ImageData*>::iterator image_iter = images_.begin(); image_iter != images_.end(); ++image_iter)
+			delete *image_iter;
+		images_.clear();
+		texture_names_.clear();
+		next_texture_ = 0;
+		materials_created_ = false;
+
+		delete scene_;
+		scene_ = new Scene();
+		if (!scene_->ReadSceneFromFile(platform, filename_.c_str()))
+			return false;
+
+		if (max_bone_palette_size_ > 0)
+		{
+			for (std::list<MeshData>::iterator mesh_iter = scene_->mesh_data.begin(); mesh_iter != scene_->mesh_data.end(); ++mesh_iter)
+				mesh_iter->SplitBonePalettes(max_bone_palette_size_);
+		}
+
+		if (create_objects_)
+		{
+			// decode each texture once, however many materials use it. The loader's workers already load requests in parallel,
+			// so the images are decoded on this thread
+			scene_->GetNewTextureNames(texture_names_);
+			Scene::DecodeImages(texture_names_, images_, NULL);
+
+			next_mesh_ = scene_->mesh_data.begin();
+		}
+
+		return true;
+	}
+
+	AssetRequest::CreateResult SceneRequest::Create(Platform& platform)
+	{
+		if (!create_objects_)
+			return kCreateFinished;
+
+		// one texture per step
+		if (next_texture_ < texture_names_.size())
+		{
+			const std::string& texture_name = texture_names_[next_texture_];
+			ImageData* image_data = images_[next_texture_];
+
+			// textures that couldn't be decoded are added as NULL, so CreateMaterials doesn't try to decode them again
+			Texture* texture = image_data ? Texture::Create(platform, *image_data) : NULL;
+			if (texture)
+				scene_->textures.push_back(texture);
+			scene_->textures_map[GetStringId(texture_name)] = texture;
+			scene_->string_id_table.Add(texture_name);
+
+			delete image_data;
+			images_[next_texture_] = NULL;
+			++next_texture_;
+			return kCreateContinue;
+		}
+
+		// every texture is in textures_map, so creating the materials doesn't decode anything
+		if (!materials_created_)
+		{
+			scene_->CreateMaterials(platform);
+			materials_created_ = true;
+			return kCreateContinue;
+		}
+
+		// one mesh per step
+		if (next_mesh_ != scene_->mesh_data.end())
+		{
+			scene_->meshes.push_back(scene_->CreateMesh(platform, *next_mesh_));
+			++next_mesh_;
+			return next_mesh_ != scene_->mesh_data.end() ? kCreateContinue : kCreateFinished;
+		}
+
+		return kCreateFinished;
+	}
+
+	AssetLoader::AssetLoader(Platform& platform) :
+		platform_(platform),
+		quit_(false),
+		pending_count_(0)
+	{
+	}
+
+	AssetLoader::~AssetLoader()
+	{
+		CleanUp();
+	}
+
+	void AssetLoader::Init(const Int32 worker_count)
+	{
+		CleanUp();
+
+		quit_ = false;
+		workers_.reserve(worker_count);
+		for (Int32 worker_num = 0; worker_num < worker_count; ++worker_num)
+			workers_.push_back(std::thread(&AssetLoader::WorkerMain, this));
+	}
+
+	void AssetLoader::CleanUp()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			quit_ = true;
+		}
+		wake_.notify_all();
+
+		for (std::vector<std::thread>::iterator worker_iter = workers_.begin(); worker_iter != workers_.end(); ++worker_iter)
+			worker_iter->join();
+
+		workers_.clear();
+
+		// the workers have stopped, so the queues can be used without locking
+		while (!loaded_requests_.empty())
+		{
+			AssetRequest* request = loaded_requests_.front();
+			loaded_requests_.pop_front();
+			FinishRequest(request, AssetRequest::kCancelled);
+		}
+
+		while (!queued_requests_.empty())
+		{
+			AssetRequest* request = queued_requests_.front();
+			queued_requests_.pop_front();
+			FinishRequest(request, AssetRequest::kCancelled);
+		}
+	}
+
+	bool AssetLoader::Load(AssetRequest* request, AssetRequest::Callback callback, void* user_data)
+	{
+		if (request->status_ == AssetRequest::kPending)
+			return false;
+
+		request->status_ = AssetRequest::kPending;
+		request->load_succeeded_ = false;
+		request->callback_ = callback;
+		request->user_data_ = user_data;
+		++pending_count_;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			queued_requests_.push_back(request);
+		}
+		wake_.notify_one();
+
+		return true;
+	}
+
+	void AssetLoader::Update(const float time_budget)
+	{
+		const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+		const std::chrono::duration<float> budget(time_budget);
+
+		AssetRequest* request = NULL;
+		for (;;)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+
+				request = loaded_requests_.empty() ? NULL : loaded_requests_.front();
+			}
+
+			// without worker threads a queued request is loaded here once the loaded ones are finished
+			if (!request && workers_.empty())
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					if (!queued_requests_.empty())
+					{
+						request = queued_requests_.front();
+						queued_requests_.pop_front();
+					}
+				}
+
+				if (request)
+				{
+					request->load_succeeded_ = request->Load(platform_);
+
+					std::lock_guard<std::mutex> lock(mutex_);
+					loaded_requests_.push_back(request);
+				}
+			}
+
+			if (!request)
+				break;
+
+			// a request stays at the front of the queue until it has been created, so it's created over as many updates as it needs
+			AssetRequest::CreateResult create_result = AssetRequest::kCreateFailed;
+			if (request->load_succeeded_)
+				create_result = request->Create(platform_);
+
+			if (create_result != AssetRequest::kCreateContinue)
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					loaded_requests_.pop_front();
+				}
+				FinishRequest(request, create_result == AssetRequest::kCreateFinished ? AssetRequest::kLoaded : AssetRequest::kFailed);
+			}
+
+			if (std::chrono::steady_clock::now() - start_time >= budget)
+				break;
+		}
+	}
+
+	void AssetLoader::FinishRequest(AssetRequest* request, const AssetRequest::Status status)
+	{
+		--pending_count_;
+		request->status_ = status;
+
+		// the callback is last, as it may delete the request
+		if (request->callback_)
+			request->callback_(*request, request->user_data_);
+	}
+
+	void AssetLoader::WorkerMain()
+	{
+		for (;;)
+		{
+			AssetRequest* request = NULL;
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				while (!quit_ && queued_requests_.empty())
+					wake_.wait(lock);
+
+				if (quit_)
+					return;
+
+				request = queued_requests_.front();
+				queued_requests_.pop_front();
+			}
+
+			// the request belongs to this thread until it's added to the loaded queue
+			const bool load_succeeded = request->Load(platform_);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				request->load_succeeded_ = load_succeeded;
+				loaded_requests_.push_back(request);
+			}
+		}
+	}
+}
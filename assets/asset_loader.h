@@ -0,0 +1,202 @@
+#ifndef _GEF_ASSET_LOADER_H
+#define _GEF_ASSET_LOADER_H
+
+#include <gef.h>
+#include <graphics/mesh_data.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace gef
+{
+	// forward declarations
+	class Platform;
+	class Texture;
+	class ImageData;
+	class Scene;
+
+	/**
+	An asset to be loaded by an AssetLoader, and the handle to it while it loads.
+	Loading is in two parts. Load is run on a worker thread and does the file reading and decoding.
+	Create is run on the thread that calls AssetLoader::Update and creates anything that needs the renderer, e.g. textures and vertex buffers.
+	Other kinds of asset can be loaded by deriving from this class.
+	*/
+	class AssetRequest
+	{
+	public:
+		enum Status
+		{
+			kNotLoaded = 0,
+			kPending,
+			kLoaded,
+			kFailed,
+			kCancelled
+		};
+
+		/// Called by the AssetLoader when a request stops being pending. The request can be deleted by the callback.
+		typedef void (*Callback)(AssetRequest& request, void* user_data);
+
+		AssetRequest();
+		virtual ~AssetRequest();
+
+		/// @brief Get the status. It only changes during AssetLoader::Update and AssetLoader::CleanUp, so it can be
+		/// checked each frame instead of using a callback.
+		inline Status status() const { return status_; }
+
+	protected:
+		enum CreateResult
+		{
+			kCreateFinished = 0,
+			kCreateContinue,
+			kCreateFailed
+		};
+
+		/// @brief Reads and decodes the asset. Called on a worker thread, or by AssetLoader::Update if there are no worker threads.
+		/// @param[in] platform		Only for reading files. Nothing that renders may be used.
+		/// @return false if the asset couldn't be loaded.
+		virtual bool Load(const Platform& platform) = 0;
+
+		/// @brief Creates the part of the asset that needs the renderer. Called by AssetLoader::Update after Load has succeeded.
+		/// Work can be split in to small steps by returning kCreateContinue, so each Update only does as many steps as fit in its time budget.
+		/// @return kCreateContinue to be called again, kCreateFinished when done or kCreateFailed.
+		virtual CreateResult Create(Platform& platform);
+
+	private:
+		AssetRequest(const AssetRequest&);
+		AssetRequest& operator=(const AssetRequest&);
+
+		friend class AssetLoader;
+
+		Status status_;
+		bool load_succeeded_;
+		Callback callback_;
+		void* user_data_;
+	};
+
+	/**
+	Loads a texture from a PNG file. The image is decoded on a worker thread and the texture is created by AssetLoader::Update.
+	*/
+	class TextureRequest : public AssetRequest
+	{
+	public:
+		TextureRequest(const char* filename);
+		~TextureRequest();
+
+		/// @brief Gives the loaded texture to the caller, who must delete it. Otherwise it's deleted with the request.
+		Texture* ReleaseTexture();
+
+		inline Texture* texture() const { return texture_; }
+		inline const std::string& filename() const { return filename_; }
+
+	protected:
+		bool Load(const Platform& platform);
+		CreateResult Create(Platform& platform);
+
+	private:
+		std::string filename_;
+		ImageData* image_data_;
+		Texture* texture_;
+	};
+
+	/**
+	Loads a scene from a .scn file. The file is read, the meshes are optionally split for bone palettes and the material
+	textures are decoded on a worker thread. AssetLoader::Update then creates one texture or mesh each step, and the materials.
+	*/
+	class SceneRequest : public AssetRequest
+	{
+	public:
+		SceneRequest(const char* filename);
+		~SceneRequest();
+
+		/// @brief Sets whether the textures, materials and meshes are created, or only the scene data is read. They're created by default.
+		inline void set_create_objects(const bool create_objects) { create_objects_ = create_objects; }
+
+		/// @brief Runs MeshData::SplitBonePalettes on each skinned mesh while loading. Zero, the default, leaves the meshes as they are.
+		inline void set_max_bone_palette_size(const Int32 max_bone_palette_size) { max_bone_palette_size_ = max_bone_palette_size; }
+
+		/// @brief Gives the loaded scene to the caller, who must delete it. Otherwise it's deleted with the request.
+		Scene* ReleaseScene();
+
+		inline Scene* scene() const { return scene_; }
+		inline const std::string& filename() const { return filename_; }
+
+	protected:
+		bool Load(const Platform& platform);
+		CreateResult Create(Platform& platform);
+
+	private:
+		std::string filename_;
+		Scene* scene_;
+		bool create_objects_;
+		Int32 max_bone_palette_size_;
+
+		/// The distinct material textures, in the order they're first used, and their decoded images.
+		/// An image is NULL if it couldn't be decoded or its texture has been created.
+		std::vector<std::string> texture_names_;
+		std::vector<ImageData*> images_;
+		size_t next_texture_;
+		bool materials_created_;
+		std::list<MeshData>::const_iterator next_mesh_;
+	};
+
+	/**
+	Loads assets without blocking the thread that renders. Requests are loaded by a pool of worker threads, then
+	finished by Update, which is given a time budget so loading doesn't cause a long frame.
+	*/
+	class AssetLoader
+	{
+	public:
+		AssetLoader(Platform& platform);
+		~AssetLoader();
+
+		/// @brief Starts the worker threads.
+		/// @param[in] worker_count		The number of worker threads. Zero loads each request during Update instead.
+		/// @note Anything from a previous Init is cleaned up first.
+		void Init(const Int32 worker_count);
+
+		/// @brief Stops the worker threads, waiting for any request being loaded. Requests that haven't finished are cancelled.
+		void CleanUp();
+
+		/// @brief Queues a request to be loaded. The request must not be deleted while it's pending.
+		/// @param[in] request		The request.
+		/// @param[in] callback		If not NULL, called by Update or CleanUp when the request stops being pending.
+		/// @param[in] user_data	Passed to the callback.
+		/// @return false if the request is already pending.
+		bool Load(AssetRequest* request, AssetRequest::Callback callback = NULL, void* user_data = NULL);
+
+		/// @brief Creates the renderer objects of loaded requests and calls their callbacks. Call once a frame.
+		/// At least one step is done each call, then steps are done until the time budget is used up.
+		/// @param[in] time_budget		The time that can be spent, in seconds.
+		void Update(const float time_budget);
+
+		/// @brief Get the number of requests that are pending.
+		inline Int32 pending_count() const { return pending_count_; }
+		inline Int32 worker_count() const { return (Int32)workers_.size(); }
+
+	private:
+		AssetLoader(const AssetLoader&);
+		AssetLoader& operator=(const AssetLoader&);
+
+		void WorkerMain();
+		void FinishRequest(AssetRequest* request, const AssetRequest::Status status);
+
+		Platform& platform_;
+		std::vector<std::thread> workers_;
+
+		/// Protects the members below. wake_ is signalled when a request is queued or quit_ is set.
+		std::mutex mutex_;
+		std::condition_variable wake_;
+		std::deque<AssetRequest*> queued_requests_;
+		std::deque<AssetRequest*> loaded_requests_;
+		bool quit_;
+
+		/// Only used by the thread calling Load and Update.
+		Int32 pending_count_;
+	};
+}
+
+#endif // _GEF_ASSET_LOADER_H
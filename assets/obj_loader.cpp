@@ -12,6 +12,7 @@
 #include <system/file.h>
 #include <system/memory_stream_buffer.h>
 #include <graphics/material.h>
+#include <graphics/resource_cache.h>
 
 #include <cstdio>
 #include <cstring>
@@ -21,6 +22,10 @@
 namespace gef
 {
 
+OBJLoader::OBJLoader(ResourceCache* resource_cache) :
+	resource_cache_(resource_cache)
+{
+}
 
 bool OBJLoader::Load(const char* filename, Platform& platform, Model& model)
 {
@@ -37,43 +42,26 @@ bool OBJLoader::Load(const char* filename, Platform& platform, Model& model)
 	std::map<std::string, Int32> materials;
 
 	std::string obj_filename(filename);
-	void* obj_file_data = NULL;
+	const void* obj_file_data = NULL;
 	Int32 file_size = 0;
 	gef::File* file = gef::File::Create();
 
+	// the file is read through a mapping of its contents rather than a copy of them
 	success = file->Open(obj_filename.c_str());
 	if(success)
 	{
-		success = file->GetSize(file_size);
-		if(success)
-		{
-			obj_file_data = malloc(file_size);
-			success = obj_file_data != NULL;
-			if(success)
-			{
-				Int32 bytes_read;
-				success = file->Read(obj_file_data, file_size, bytes_read);
-				if(success)
-					success = bytes_read == file_size;
-
-				file->Close();
-				delete file;
-				file = NULL;
-			}
-		}
+		success = file->Map(&obj_file_data, file_size);
+		if(!success)
+			file->Close();
 	}
 
 	if(!success)
 	{
-		free(obj_file_data);
-		obj_file_data = NULL;
-
-		file->Close();
 		delete file;
 		file = NULL;
 		return false;
 	}
-	gef::MemoryStreamBuffer buffer((char*)obj_file_data, file_size);
+	gef::MemoryStreamBuffer buffer(obj_file_data, file_size);
 	std::istream stream(&buffer);
 
 	{
@@ -161,8 +149,11 @@ bool OBJLoader::Load(const char* filename, Platform& platform, Model& model)
 			}
 		}
 
-		// don't need the font file data any more
-		free(obj_file_data);
+		// don't need the obj file data any more
+		file->Unmap();
+		file->Close();
+		delete file;
+		file = NULL;
 		obj_file_data = NULL;
 
 		// finished reading the file
@@ -212,6 +203,7 @@ bool OBJLoader::Load(const char* filename, Platform& platform, Model& model)
 		Mesh* mesh = new Mesh(platform);
 		model.set_mesh(mesh);
 		model.set_textures(textures);
+		model.set_resource_cache(resource_cache_);
 
 		// set bounds
 		gef::Aabb aabb(pos_min, pos_max);
@@ -283,37 +275,24 @@ bool OBJLoader::LoadMaterials(Platform& platform, const char* filename, std::map
 
 
 	std::string mtl_filename(filename);
-	void* mtl_file_data = NULL;
+	const void* mtl_file_data = NULL;
 	Int32 file_size = 0;
 	gef::File* file = gef::File::Create();
 	success = file->Open(mtl_filename.c_str());
 	if(success)
 	{
-		success = file->GetSize(file_size);
-		if(success)
-		{
-			mtl_file_data = malloc(file_size);
-			success = mtl_file_data != NULL;
-			if(success)
-			{
-				Int32 bytes_read;
-				success = file->Read(mtl_file_data, file_size, bytes_read);
-				if(success)
-					success = bytes_read == file_size;
-			}
-		}
+		success = file->Map(&mtl_file_data, file_size);
+		if(!success)
+			file->Close();
 	}
 
 	if(!success)
 	{
-		free(mtl_file_data);
-		mtl_file_data = NULL;
-
 		delete file;
 		file = NULL;
 		return false;
 	}
-	gef::MemoryStreamBuffer buffer((char*)mtl_file_data, file_size);
+	gef::MemoryStreamBuffer buffer(mtl_file_data, file_size);
 	std::istream stream(&buffer);
 
 
@@ -338,15 +317,26 @@ bool OBJLoader::LoadMaterials(Platform& platform, const char* filename, std::map
 			}
 		}
 
-		free(mtl_file_data);
+		file->Unmap();
+		file->Close();
+		delete file;
+		file = NULL;
 		mtl_file_data = NULL;
 
 		for(std::map<std::string, std::string>::iterator iter = material_name_mappings.begin(); iter != material_name_mappings.end(); ++iter)
 		{
 			if(iter->second.compare("") != 0)
 			{
-				gef::ImageData image_data{ iter->second.c_str() };
-				Texture* texture = gef::Texture::Create(platform, image_data);
+				Texture* texture = NULL;
+				if(resource_cache_)
+				{
+					texture = resource_cache_->LoadTexture(platform, iter->second.c_str());
+				}
+				else
+				{
+					gef::ImageData image_data{ iter->second.c_str() };
+					texture = gef::Texture::Create(platform, image_data);
+				}
 				textures.push_back(texture);
 				materials[iter->first] = (Int32)textures.size()-1;
 			}
@@ -11,13 +11,19 @@ namespace gef
 	class Platform;
 	class Model;
 	class Texture;
+	class ResourceCache;
 
 	class OBJLoader
 	{
 	public:
+		/// @param[in] resource_cache	If not NULL, textures are borrowed from this cache so models that use the same ones share them.
+		OBJLoader(ResourceCache* resource_cache = NULL);
+
 		bool Load(const char* filename, Platform& platform, Model& model);
 	private:
 		bool LoadMaterials(Platform& platform, const char* filename, std::map<std::string, Int32>& materials, std::vector<Texture*>& textures);
+
+		ResourceCache* resource_cache_;
 	};
 }
 
@@ -51,101 +51,110 @@ namespace gef
         bool success = png_file->Open(filename);
         if(success)
         {
-            // read entire file
-            UInt8* buffer = NULL;
+            // map entire file, libpng reads from the mapping
+            const void* buffer = NULL;
             Int32 file_size;
-            success = png_file->GetSize(file_size);
+            success = png_file->Map(&buffer, file_size);
             if(success)
             {
-                buffer = new UInt8[file_size];
-                Int32 bytes_read;
-                success = png_file->Read(buffer, file_size, bytes_read);
+                png_structp png_ptr;
+                png_infop info_ptr;
+                UInt32 sig_read = 0;
+                png_uint_32 width = 0;
+                png_uint_32 height = 0;
+                int bitDepth = 0;
+                int colorType = -1;
+
+
+                /* Create and initialize the png_struct
+                 * with the desired error handler
+                 * functions.  If you want to use the
+                 * default stderr and longjump method,
+                 * you can supply NULL for the last
+                 * three parameters.  We also supply the
+                 * the compiler header file version, so
+                 * that we know if the application
+                 * was compiled with a compatible version
+                 * of the library.  REQUIRED
+                 */
+                png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,	NULL, NULL, NULL);
+
+                if(png_ptr == NULL)
+                {
+                    success = false;
+                    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+                }
 
                 if(success)
-                    success = png_file->Close();
+                {
+                    /* Allocate/initialize the memory
+                     * for image information.  REQUIRED. */
+                    info_ptr = png_create_info_struct(png_ptr);
+                    if (info_ptr == NULL)
+                    {
+                        success = false;
+                        png_destroy_read_struct(&png_ptr, NULL, NULL);
+                    }
+                }
 
                 if(success)
                 {
-                    png_structp png_ptr;
-                    png_infop info_ptr;
-                    UInt32 sig_read = 0;
-                    png_uint_32 width = 0;
-                    png_uint_32 height = 0;
-                    int bitDepth = 0;
-                    int colorType = -1;
-
-
-                    /* Create and initialize the png_struct
-                     * with the desired error handler
-                     * functions.  If you want to use the
-                     * default stderr and longjump method,
-                     * you can supply NULL for the last
-                     * three parameters.  We also supply the
-                     * the compiler header file version, so
-                     * that we know if the application
-                     * was compiled with a compatible version
-                     * of the library.  REQUIRED
+                    /* Set error handling if you are
+                     * using the setjmp/longjmp method
+                     * (this is the normal method of
+                     * doing things with libpng).
+                     * REQUIRED unless you  set up
+                     * your own error handlers in
+                     * the png_create_read_struct()
+                     * earlier.
                      */
-                    png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,	NULL, NULL, NULL);
-
-                    if(png_ptr == NULL)
+                    if (setjmp(png_jmpbuf(png_ptr)))
                     {
                         success = false;
+
+                        /* Free all of the memory associated
+                         * with the png_ptr and info_ptr */
                         png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-                        delete[] buffer;
-                        buffer = NULL;
                     }
+                }
 
-                    if(success)
-                    {
-                        /* Allocate/initialize the memory
-                         * for image information.  REQUIRED. */
-                        info_ptr = png_create_info_struct(png_ptr);
-                        if (info_ptr == NULL)
-                        {
-                            success = false;
-                            delete[] buffer;
-                            buffer = NULL;
-                            png_destroy_read_struct(&png_ptr, NULL, NULL);
-                        }
-                    }
+                if(success)
+                {
+						PNGData data;
+						data.p = (png_bytep)buffer;
+						data.len = file_size;
 
-                    if(success)
-                    {
-                        /* Set error handling if you are
-                         * using the setjmp/longjmp method
-                         * (this is the normal method of
-                         * doing things with libpng).
-                         * REQUIRED unless you  set up
-                         * your own error handlers in
-                         * the png_create_read_struct()
-                         * earlier.
-                         */
-                        if (setjmp(png_jmpbuf(png_ptr)))
-                        {
-                            success = false;
-                            delete[] buffer;
-                            buffer = NULL;
+                    png_set_read_fn(png_ptr, &data, ReadDataFromInputStream);
 
-                            /* Free all of the memory associated
-                             * with the png_ptr and info_ptr */
-                            png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-                        }
-                    }
+                    /* If we have already
+                     * read some of the signature */
+                    png_set_sig_bytes(png_ptr, sig_read);
 
-                    if(success)
-                    {
-						PNGData data;
-						data.p = buffer;
-						data.len = file_size;
+                    png_read_info(png_ptr, info_ptr);
 
-                        png_set_read_fn(png_ptr, &data, ReadDataFromInputStream);
+                    png_uint_32 retval = png_get_IHDR(png_ptr, info_ptr,
+                            &width,
+                            &height,
+                            &bitDepth,
+                            &colorType,
+                            NULL, NULL, NULL);
 
-                        /* If we have already
-                         * read some of the signature */
-                        png_set_sig_bytes(png_ptr, sig_read);
+                    if(retval != 1)
+                    {
+                        success = false;
+
+                        /* Free all of the memory associated
+                         * with the png_ptr and info_ptr */
+                        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+                    }
+                }
 
-                        png_read_info(png_ptr, info_ptr);
+                if(success)
+                {
+                    if(colorType == PNG_COLOR_TYPE_RGB)
+                    {
+                        png_set_add_alpha(png_ptr, 0xff, PNG_FILLER_AFTER);
+                        png_read_update_info(png_ptr, info_ptr);
 
                         png_uint_32 retval = png_get_IHDR(png_ptr, info_ptr,
                                 &width,
@@ -157,47 +166,19 @@ namespace gef
                         if(retval != 1)
                         {
                             success = false;
-                            delete[] buffer;
-                            buffer = NULL;
 
                             /* Free all of the memory associated
                              * with the png_ptr and info_ptr */
                             png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
                         }
-                    }
 
-                    if(success)
-                    {
-                        if(colorType == PNG_COLOR_TYPE_RGB)
-                        {
-                            png_set_add_alpha(png_ptr, 0xff, PNG_FILLER_AFTER);
-                            png_read_update_info(png_ptr, info_ptr);
-
-                            png_uint_32 retval = png_get_IHDR(png_ptr, info_ptr,
-                                    &width,
-                                    &height,
-                                    &bitDepth,
-                                    &colorType,
-                                    NULL, NULL, NULL);
-
-                            if(retval != 1)
-                            {
-                                success = false;
-                                delete[] buffer;
-                                buffer = NULL;
-
-                                /* Free all of the memory associated
-                                 * with the png_ptr and info_ptr */
-                                png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-                            }
-
-                        }
                     }
+                }
 
-                    if(success)
-                    {
-                        image_data.set_width(width);
-                        image_data.set_height(height);
+                if(success)
+                {
+                    image_data.set_width(width);
+                    image_data.set_height(height);
 
 						if (colorType == PNG_COLOR_TYPE_RGB_ALPHA)
 						{
@@ -207,30 +188,33 @@ namespace gef
 						}
 
 
-                        switch(colorType)
-                        {
-                            case PNG_COLOR_TYPE_RGB:
-                                //      ParseRGB(outImage, png_ptr, info_ptr);
-                                break;
+                    switch(colorType)
+                    {
+                        case PNG_COLOR_TYPE_RGB:
+                            //      ParseRGB(outImage, png_ptr, info_ptr);
+                            break;
 
-                            case PNG_COLOR_TYPE_RGB_ALPHA:
-                                //outHasAlpha = true;
-                                ParseRGBA(image_data.image(), png_ptr, info_ptr, width, height);
-                                break;
+                        case PNG_COLOR_TYPE_RGB_ALPHA:
+                            //outHasAlpha = true;
+                            ParseRGBA(image_data.image(), png_ptr, info_ptr, width, height);
+                            break;
 
-                        }
+                    }
 
 						/* Free all of the memory associated
 						* with the png_ptr and info_ptr */
 						png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-                    }
                 }
 
                 // done
-                delete[] buffer;
+                png_file->Unmap();
                 buffer = NULL;
             }
+
+            png_file->Close();
         }
+
+        delete png_file;
     }
 
     void PNGLoader::ParseRGBA(UInt8* out_image_buffer, void* the_png_ptr,
@@ -0,0 +1,250 @@
+#include <graphics/cpu_skinning.h>
+#include <maths/matrix44.h>
+#include <maths/dual_quaternion.h>
+#include <maths/vector4.h>
+#include <maths/simd.h>
+#include <cfloat>
+#include <cmath>
+
+namespace gef
+{
+	// the cross product of the x, y and z components, with w set to zero
+	static inline SimdVector Cross(const SimdVector a, const SimdVector b)
+	{
+		const SimdVector result = SimdSub(SimdMul(SimdSwizzle<1, 2, 0, 3>(a), SimdSwizzle<2, 0, 1, 3>(b)), SimdMul(SimdSwizzle<2, 0, 1, 3>(a), SimdSwizzle<1, 2, 0, 3>(b)));
+		return SimdZeroW(result);
+	}
+
+	static void StoreBounds(const SimdVector min_position, const SimdVector max_position, const Int32 vertex_count, Aabb* bounds)
+	{
+		if (vertex_count > 0)
+		{
+			float min_values[4], max_values[4];
+			SimdStore(min_values, min_position);
+			SimdStore(max_values, max_position);
+			*bounds = Aabb(Vector4(min_values[0], min_values[1], min_values[2]), Vector4(max_values[0], max_values[1], max_values[2]));
+		}
+		else
+		{
+			*bounds = Aabb();
+		}
+	}
+
+	CpuSkinning::CpuSkinning() :
+		vertices_(NULL),
+		vertex_count_(0),
+		positions_(NULL),
+		normals_(NULL),
+		bone_matrices_(NULL),
+		bone_dual_quaternions_(NULL),
+		calculate_bounds_(false)
+	{
+	}
+
+	CpuSkinning::~CpuSkinning()
+	{
+		CleanUp();
+	}
+
+	void CpuSkinning::Init(const Int32 worker_count)
+	{
+		worker_pool_.Init(worker_count);
+	}
+
+	void CpuSkinning::CleanUp()
+	{
+		worker_pool_.CleanUp();
+	}
+
+	void CpuSkinning::Skin(const Mesh::SkinnedVertex* vertices, const Int32 vertex_count, const Matrix44* bone_matrices,
+		Vector4* positions, Vector4* normals, Aabb* bounds)
+	{
+		// small meshes aren't worth waking the workers for
+		if (worker_pool_.worker_count() == 0 || vertex_count <= kChunkVertexCount)
+			SkinVertices(vertices, vertex_count, bone_matrices, positions, normals, bounds);
+		else
+			SkinChunks(vertices, vertex_count, bone_matrices, NULL, positions, normals, bounds);
+	}
+
+	void CpuSkinning::Skin(const Mesh::SkinnedVertex* vertices, const Int32 vertex_count, const DualQuaternion* bone_dual_quaternions,
+		Vector4* positions, Vector4* normals, Aabb* bounds)
+	{
+		if (worker_pool_.worker_count() == 0 || vertex_count <= kChunkVertexCount)
+			SkinVertices(vertices, vertex_count, bone_dual_quaternions, positions, normals, bounds);
+		else
+			SkinChunks(vertices, vertex_count, NULL, bone_dual_quaternions, positions, normals, bounds);
+	}
+
+	void CpuSkinning::SkinChunks(const Mesh::SkinnedVertex* vertices, const Int32 vertex_count, const Matrix44* bone_matrices, const DualQuaternion* bone_dual_quaternions,
+		Vector4* positions, Vector4* normals, Aabb* bounds)
+	{
+		vertices_ = vertices;
+		vertex_count_ = vertex_count;
+		bone_matrices_ = bone_matrices;
+		bone_dual_quaternions_ = bone_dual_quaternions;
+		positions_ = positions;
+		normals_ = normals;
+		calculate_bounds_ = bounds != NULL;
+		bounds_ = Aabb();
+
+		worker_pool_.Run((vertex_count + kChunkVertexCount - 1) / kChunkVertexCount, SkinChunk, this);
+
+		if (bounds)
+			*bounds = bounds_;
+	}
+
+	void CpuSkinning::SkinVertices(const Mesh::SkinnedVertex* vertices, const Int32 vertex_count, const Matrix44* bone_matrices,
+		Vector4* positions, Vector4* normals, Aabb* bounds)
+	{
+		const SimdVector one = SimdSplat(1.0f);
+		SimdVector min_position = SimdSplat(FLT_MAX);
+		SimdVector max_position = SimdSplat(-FLT_MAX);
+
+		for (Int32 vertex_num = 0; vertex_num < vertex_count; ++vertex_num)
+		{
+			const Mesh::SkinnedVertex& vertex = vertices[vertex_num];
+
+			// blend the bone matrices by the weights, then transform the vertex once by the result
+			SimdVector r0 = SimdZero();
+			SimdVector r1 = SimdZero();
+			SimdVector r2 = SimdZero();
+			SimdVector r3 = SimdZero();
+			for (Int32 influence_num = 0; influence_num < 4; ++influence_num)
+			{
+				const float weight = vertex.bone_weights[influence_num];
+				if (weight <= 0.0f)
+					continue;
+
+				const float* bone_matrix = bone_matrices[vertex.bone_indices[influence_num]].float_ptr();
+				const SimdVector w = SimdSplat(weight);
+				r0 = SimdMulAdd(w, SimdLoad(bone_matrix), r0);
+				r1 = SimdMulAdd(w, SimdLoad(bone_matrix+4), r1);
+				r2 = SimdMulAdd(w, SimdLoad(bone_matrix+8), r2);
+				r3 = SimdMulAdd(w, SimdLoad(bone_matrix+12), r3);
+			}
+
+			// the weights are normalised when the mesh is built, so w would already be close to one
+			const SimdVector position = SimdSelectXYZ(SimdTransform(SimdSet(vertex.px, vertex.py, vertex.pz, 1.0f), r0, r1, r2, r3), one);
+			SimdStore((float*)positions[vertex_num].float_ptr(), position);
+
+			if (bounds)
+			{
+				min_position = SimdMin(min_position, position);
+				max_position = SimdMax(max_position, position);
+			}
+
+			if (normals)
+			{
+				// the bone matrices only rotate and uniformly scale, so the normal can be transformed without the inverse transpose
+				SimdVector normal = SimdMul(SimdSplat(vertex.nx), r0);
+				normal = SimdMulAdd(SimdSplat(vertex.ny), r1, normal);
+				normal = SimdZeroW(SimdMulAdd(SimdSplat(vertex.nz), r2, normal));
+
+				const SimdVector squared = SimdMul(normal, normal);
+				const float length = std::sqrt(SimdGetX(SimdAdd(SimdAdd(squared, SimdSplatY(squared)), SimdSplatZ(squared))));
+				if (length > 0.0f)
+					normal = SimdMul(normal, SimdSplat(1.0f / length));
+				SimdStore((float*)normals[vertex_num].float_ptr(), normal);
+			}
+		}
+
+		if (bounds)
+			StoreBounds(min_position, max_position, vertex_count, bounds);
+	}
+
+	void CpuSkinning::SkinVertices(const Mesh::SkinnedVertex* vertices, const Int32 vertex_count, const DualQuaternion* bone_dual_quaternions,
+		Vector4* positions, Vector4* normals, Aabb* bounds)
+	{
+		const SimdVector one = SimdSplat(1.0f);
+		const SimdVector two = SimdSplat(2.0f);
+		SimdVector min_position = SimdSplat(FLT_MAX);
+		SimdVector max_position = SimdSplat(-FLT_MAX);
+
+		for (Int32 vertex_num = 0; vertex_num < vertex_count; ++vertex_num)
+		{
+			const Mesh::SkinnedVertex& vertex = vertices[vertex_num];
+
+			// blend the dual quaternions by the weights, flipping any that are on the opposite side of the
+			// first one so the blend takes the shortest path between the rotations
+			SimdVector real = SimdZero();
+			SimdVector dual = SimdZero();
+			const Quaternion* first_rotation = NULL;
+			for (Int32 influence_num = 0; influence_num < 4; ++influence_num)
+			{
+				float weight = vertex.bone_weights[influence_num];
+				if (weight <= 0.0f)
+					continue;
+
+				const DualQuaternion& bone = bone_dual_quaternions[vertex.bone_indices[influence_num]];
+				if (!first_rotation)
+					first_rotation = &bone.real;
+				else if (bone.real.x*first_rotation->x + bone.real.y*first_rotation->y + bone.real.z*first_rotation->z + bone.real.w*first_rotation->w < 0.0f)
+					weight = -weight;
+
+				const SimdVector w = SimdSplat(weight);
+				real = SimdMulAdd(w, SimdLoad(&bone.real.x), real);
+				dual = SimdMulAdd(w, SimdLoad(&bone.dual.x), dual);
+			}
+
+			// normalise the blend
+			const SimdVector squared = SimdMul(real, real);
+			const float length = std::sqrt(SimdGetX(SimdAdd(SimdAdd(SimdAdd(squared, SimdSplatY(squared)), SimdSplatZ(squared)), SimdSplatW(squared))));
+			if (length > 0.0f)
+			{
+				const SimdVector inv_length = SimdSplat(1.0f / length);
+				real = SimdMul(real, inv_length);
+				dual = SimdMul(dual, inv_length);
+			}
+
+			const SimdVector real_xyz = SimdZeroW(real);
+			const SimdVector real_w = SimdSplatW(real);
+
+			// translation = 2 * (real.w*dual.xyz - dual.w*real.xyz + real.xyz x dual.xyz)
+			const SimdVector translation = SimdMul(two, SimdAdd(SimdSub(SimdMul(real_w, SimdZeroW(dual)), SimdMul(SimdSplatW(dual), real_xyz)), Cross(real_xyz, dual)));
+
+			// rotated v = v + 2 * real.xyz x (real.xyz x v + real.w*v)
+			const SimdVector position = SimdSet(vertex.px, vertex.py, vertex.pz, 0.0f);
+			SimdVector skinned_position = SimdMulAdd(two, Cross(real_xyz, SimdMulAdd(real_w, position, Cross(real_xyz, position))), position);
+			skinned_position = SimdSelectXYZ(SimdAdd(skinned_position, translation), one);
+			SimdStore((float*)positions[vertex_num].float_ptr(), skinned_position);
+
+			if (bounds)
+			{
+				min_position = SimdMin(min_position, skinned_position);
+				max_position = SimdMax(max_position, skinned_position);
+			}
+
+			if (normals)
+			{
+				const SimdVector normal = SimdSet(vertex.nx, vertex.ny, vertex.nz, 0.0f);
+				SimdStore((float*)normals[vertex_num].float_ptr(), SimdMulAdd(two, Cross(real_xyz, SimdMulAdd(real_w, normal, Cross(real_xyz, normal))), normal));
+			}
+		}
+
+		if (bounds)
+			StoreBounds(min_position, max_position, vertex_count, bounds);
+	}
+
+	void CpuSkinning::SkinChunk(void* skinning, const Int32 chunk_index)
+	{
+		CpuSkinning& cpu_skinning = *static_cast<CpuSkinning*>(skinning);
+		const Int32 start_vertex = chunk_index*kChunkVertexCount;
+		const Int32 chunk_vertex_count = cpu_skinning.vertex_count_ - start_vertex < kChunkVertexCount ? cpu_skinning.vertex_count_ - start_vertex : kChunkVertexCount;
+
+		Aabb chunk_bounds;
+		Vector4* chunk_normals = cpu_skinning.normals_ ? cpu_skinning.normals_+start_vertex : NULL;
+		Aabb* chunk_bounds_ptr = cpu_skinning.calculate_bounds_ ? &chunk_bounds : NULL;
+		if (cpu_skinning.bone_dual_quaternions_)
+			SkinVertices(cpu_skinning.vertices_+start_vertex, chunk_vertex_count, cpu_skinning.bone_dual_quaternions_, cpu_skinning.positions_+start_vertex, chunk_normals, chunk_bounds_ptr);
+		else
+			SkinVertices(cpu_skinning.vertices_+start_vertex, chunk_vertex_count, cpu_skinning.bone_matrices_, cpu_skinning.positions_+start_vertex, chunk_normals, chunk_bounds_ptr);
+
+		// a chunk is large enough that merging its bounds under the lock costs little
+		if (cpu_skinning.calculate_bounds_)
+		{
+			std::lock_guard<std::mutex> lock(cpu_skinning.bounds_mutex_);
+			cpu_skinning.bounds_.Update(chunk_bounds.min_vtx());
+			cpu_skinning.bounds_.Update(chunk_bounds.max_vtx());
+		}
+	}
+}
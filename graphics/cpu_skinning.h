@@ -0,0 +1,99 @@
+#ifndef _GEF_CPU_SKINNING_H
+#define _GEF_CPU_SKINNING_H
+
+#include <gef.h>
+#include <graphics/mesh.h>
+#include <maths/aabb.h>
+#include <system/worker_pool.h>
+#include <mutex>
+
+namespace gef
+{
+	// forward declarations
+	class Matrix44;
+	class DualQuaternion;
+	class Vector4;
+
+	/**
+	Skinning on the CPU, for when the skinned vertices are needed outside of the skinning shader,
+	e.g. for physics hit meshes, software rendering or bounds on a server that has no GPU.
+	The vertices are the same Mesh::SkinnedVertex data the mesh is created from. With the bone matrices calculated by
+	SkinnedMeshInstance::UpdateBoneMatrices the vertices are linear blend skinned, so the results match what the
+	skinning shader draws. With the bone dual quaternions from SkinnedMeshInstance::UpdateBoneDualQuaternions they
+	are dual quaternion skinned instead, which keeps the volume of joints that twist.
+	Large meshes are split in to chunks of vertices that are shared between worker threads and the calling thread.
+	The vertices of a mesh split by MeshData::SplitBonePalettes index their primitive's bone palette rather than the skeleton,
+	so they must be skinned with the bone matrices gathered from that palette.
+	*/
+	class CpuSkinning
+	{
+	public:
+		CpuSkinning();
+		~CpuSkinning();
+
+		/// @brief Starts the worker threads.
+		/// @param[in] worker_count		The number of worker threads. Zero skins every vertex on the thread that calls Skin.
+		/// @note Anything from a previous Init is cleaned up first.
+		void Init(const Int32 worker_count);
+
+		/// @brief Stops the worker threads.
+		void CleanUp();
+
+		/// @brief Skins vertices, sharing them between the worker threads and the calling thread.
+		/// @param[in] vertices			The vertices to skin.
+		/// @param[in] vertex_count		The number of vertices.
+		/// @param[in] bone_matrices	The bone matrices. Every bone index with a weight greater than zero must be in the array.
+		/// @param[out] positions		Receives the skinned position of each vertex, with w set to one.
+		/// @param[out] normals			If not NULL, receives the skinned normal of each vertex, normalised with w set to zero.
+		/// @param[out] bounds			If not NULL, receives the bounds of the skinned positions.
+		/// @note Must not be called by more than one thread at once.
+		void Skin(const Mesh::SkinnedVertex* vertices, const Int32 vertex_count, const Matrix44* bone_matrices,
+			Vector4* positions, Vector4* normals = NULL, Aabb* bounds = NULL);
+
+		/// @brief Skins vertices with dual quaternions, sharing them between the worker threads and the calling thread.
+		/// @param[in] bone_dual_quaternions	The bone dual quaternions. Every bone index with a weight greater than zero must be in the array.
+		/// @note The other parameters are the same as the Matrix44 version. Normals are only rotated, so they stay normalised.
+		void Skin(const Mesh::SkinnedVertex* vertices, const Int32 vertex_count, const DualQuaternion* bone_dual_quaternions,
+			Vector4* positions, Vector4* normals = NULL, Aabb* bounds = NULL);
+
+		/// @brief Skins vertices on the calling thread. Parameters are the same as Skin.
+		static void SkinVertices(const Mesh::SkinnedVertex* vertices, const Int32 vertex_count, const Matrix44* bone_matrices,
+			Vector4* positions, Vector4* normals = NULL, Aabb* bounds = NULL);
+
+		/// @brief Skins vertices with dual quaternions on the calling thread. Parameters are the same as Skin.
+		static void SkinVertices(const Mesh::SkinnedVertex* vertices, const Int32 vertex_count, const DualQuaternion* bone_dual_quaternions,
+			Vector4* positions, Vector4* normals = NULL, Aabb* bounds = NULL);
+
+		inline Int32 worker_count() const { return worker_pool_.worker_count(); }
+
+		/// The number of vertices taken by a thread at a time.
+		static const Int32 kChunkVertexCount = 1024;
+
+	private:
+		CpuSkinning(const CpuSkinning&);
+		CpuSkinning& operator=(const CpuSkinning&);
+
+		void SkinChunks(const Mesh::SkinnedVertex* vertices, const Int32 vertex_count, const Matrix44* bone_matrices, const DualQuaternion* bone_dual_quaternions,
+			Vector4* positions, Vector4* normals, Aabb* bounds);
+		static void SkinChunk(void* skinning, const Int32 chunk_index);
+
+		WorkerPool worker_pool_;
+
+		/// The arguments of the Skin call being run.
+		const Mesh::SkinnedVertex* vertices_;
+		Int32 vertex_count_;
+		Vector4* positions_;
+		Vector4* normals_;
+
+		/// Only one of the palettes is used, the other is NULL.
+		const Matrix44* bone_matrices_;
+		const DualQuaternion* bone_dual_quaternions_;
+
+		/// The bounds of the chunks skinned so far, merged by each chunk as it finishes. bounds_mutex_ protects them.
+		std::mutex bounds_mutex_;
+		Aabb bounds_;
+		bool calculate_bounds_;
+	};
+}
+
+#endif // _GEF_CPU_SKINNING_H
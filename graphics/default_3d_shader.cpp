@@ -154,11 +154,6 @@ namespace gef
 		// calculate world view projection matrix
 		gef::Matrix44 wvp = mesh_instance.transform() * view_projection_matrix_;
 
-		// calculate the transpose of inverse world matrix to transform normals in shader
-		Matrix44 inv_world;
-		inv_world.Inverse(mesh_instance.transform());
-		//inv_world_transpose_matrix.Transpose(inv_world);
-
 		// take transpose of matrices for the shaders
 		gef::Matrix44 wvpT, worldT;
 
@@ -177,11 +172,6 @@ namespace gef
 		// calculate world view projection matrix
 		gef::Matrix44 wvp = transform * view_projection_matrix_;
 
-		// calculate the transpose of inverse world matrix to transform normals in shader
-		Matrix44 inv_world;
-		inv_world.Inverse(transform);
-		//inv_world_transpose_matrix.Transpose(inv_world);
-
 		// take transpose of matrices for the shaders
 		gef::Matrix44 wvpT, worldT;
 
@@ -33,6 +33,8 @@ namespace gef
 	,light_colour_variable_index_(-1)
 	,texture_sampler_index_(-1)
 	,bone_matrices_variable_index_(-1)
+	,bone_matrices_(NULL)
+	,bone_palette_set_(false)
 	{
 		// load vertex shader source in from a file
 		char* vs_shader_source = NULL;
@@ -55,7 +57,7 @@ namespace gef
 		world_matrix_variable_index_ = device_interface_->AddVertexShaderVariable("world", ShaderInterface::kMatrix44);
 //		invworld_matrix_variable_index_ = device_interface_->AddVertexShaderVariable("invworld", ShaderInterface::kMatrix44);
 		light_position_variable_index_ = device_interface_->AddVertexShaderVariable("light_position", ShaderInterface::kVector4, 4);
-		bone_matrices_variable_index_ = device_interface_->AddVertexShaderVariable("bone_matrices", ShaderInterface::kMatrix44, 128);
+		bone_matrices_variable_index_ = device_interface_->AddVertexShaderVariable("bone_matrices", ShaderInterface::kMatrix44, MAX_NUM_BONE_MATRICES);
 
 		// pixel shader variables
 		// TODO - probable need to keep these separate for D3D11
@@ -103,10 +105,13 @@ namespace gef
 		, world_matrix_variable_index_(-1)
 //		, invworld_matrix_variable_index_(-1)
 		, light_position_variable_index_(-1)
+		, bone_matrices_variable_index_(-1)
 		, material_colour_variable_index_(-1)
 		, ambient_light_colour_variable_index_(-1)
 		, light_colour_variable_index_(-1)
 		, texture_sampler_index_(-1)
+		, bone_matrices_(NULL)
+		, bone_palette_set_(false)
 	{
 	}
 
@@ -149,18 +154,50 @@ namespace gef
 
 		device_interface_->SetVertexShaderVariable(light_position_variable_index_, (float*)light_positions);
 
+		bone_matrices_ = shader_data.bone_matrices();
+		SetBoneMatrices();
+
+		device_interface_->SetPixelShaderVariable(ambient_light_colour_variable_index_, (float*)&ambient_light_colour);
+		device_interface_->SetPixelShaderVariable(light_colour_variable_index_, (float*)light_colours);
+	}
+
+	void Default3DSkinningShader::SetBoneMatrices()
+	{
+		bone_palette_set_ = false;
+		if (bone_matrices_variable_index_ == -1 || !bone_matrices_)
+			return;
+
 		// need to transpose the bone matrices for the shader
-		if (bone_matrices_variable_index_ != -1)
-		{
-			UInt32 matrix_index = 0;
-			for (std::vector<gef::Matrix44>::const_iterator matrix_iter = shader_data.bone_matrices()->begin(); matrix_iter != shader_data.bone_matrices()->end(); ++matrix_iter, ++matrix_index)
-				mesh_data_.bones_matrices[matrix_index].Transpose((*matrix_iter));
+		const Int32 matrix_count = bone_matrices_->size() < MAX_NUM_BONE_MATRICES ? (Int32)bone_matrices_->size() : MAX_NUM_BONE_MATRICES;
+		for (Int32 matrix_index = 0; matrix_index < matrix_count; ++matrix_index)
+			mesh_data_.bones_matrices[matrix_index].Transpose((*bone_matrices_)[matrix_index]);
+
+		// only the matrices that are used are copied to the GPU
+		device_interface_->SetVertexShaderVariable(bone_matrices_variable_index_, mesh_data_.bones_matrices[0].float_ptr(), matrix_count);
+		device_interface_->LimitVertexShaderVariableUpload(bone_matrices_variable_index_, matrix_count);
+	}
+
+	void Default3DSkinningShader::SetPrimitiveData(const gef::Primitive& primitive)
+	{
+		if (bone_matrices_variable_index_ == -1 || !bone_matrices_)
+			return;
 
-			device_interface_->SetVertexShaderVariable(bone_matrices_variable_index_, mesh_data_.bones_matrices[0].float_ptr(), (Int32)shader_data.bone_matrices()->size());
+		const std::vector<Int32>& bone_palette = primitive.bone_palette();
+		if (bone_palette.empty())
+		{
+			// put back all the bone matrices if the last primitive replaced them with its palette
+			if (bone_palette_set_)
+				SetBoneMatrices();
+			return;
 		}
 
-		device_interface_->SetPixelShaderVariable(ambient_light_colour_variable_index_, (float*)&ambient_light_colour);
-		device_interface_->SetPixelShaderVariable(light_colour_variable_index_, (float*)light_colours);
+		const Int32 matrix_count = bone_palette.size() < MAX_NUM_BONE_MATRICES ? (Int32)bone_palette.size() : MAX_NUM_BONE_MATRICES;
+		for (Int32 matrix_index = 0; matrix_index < matrix_count; ++matrix_index)
+			mesh_data_.bones_matrices[matrix_index].Transpose((*bone_matrices_)[bone_palette[matrix_index]]);
+
+		device_interface_->SetVertexShaderVariable(bone_matrices_variable_index_, mesh_data_.bones_matrices[0].float_ptr(), matrix_count);
+		device_interface_->LimitVertexShaderVariableUpload(bone_matrices_variable_index_, matrix_count);
+		bone_palette_set_ = true;
 	}
 
 	void Default3DSkinningShader::SetMeshData(const gef::MeshInstance& mesh_instance)
@@ -168,11 +205,6 @@ namespace gef
 		// calculate world view projection matrix
 		gef::Matrix44 wvp = mesh_instance.transform() * view_projection_matrix_;
 
-		// calculate the transpose of inverse world matrix to transform normals in shader
-		Matrix44 inv_world;
-		inv_world.Inverse(mesh_instance.transform());
-		//inv_world_transpose_matrix.Transpose(inv_world);
-
 		// take transpose of matrices for the shaders
 		gef::Matrix44 wvpT, worldT;
 
@@ -191,11 +223,6 @@ namespace gef
 		// calculate world view projection matrix
 		gef::Matrix44 wvp = transform * view_projection_matrix_;
 
-		// calculate the transpose of inverse world matrix to transform normals in shader
-		Matrix44 inv_world;
-		inv_world.Inverse(transform);
-		//inv_world_transpose_matrix.Transpose(inv_world);
-
 		// take transpose of matrices for the shaders
 		gef::Matrix44 wvpT, worldT;
 
@@ -12,6 +12,7 @@
 #include <gef.h>
 #include <maths/vector4.h>
 #include <maths/matrix44.h>
+#include <vector>
 
 #define MAX_NUM_POINT_LIGHTS 4
 #define MAX_NUM_BONE_MATRICES 128
@@ -54,10 +55,16 @@ namespace gef
 		void SetMeshData(const gef::Matrix44& transform);
 		void SetMaterialData(const gef::Material* material);
 
+		/// @brief Passes only the bone matrices in the primitive's bone palette to the shader, if it has one.
+		void SetPrimitiveData(const gef::Primitive& primitive);
+
 		inline PrimitiveData& primitive_data() { return primitive_data_; }
 	protected:
 		Default3DSkinningShader();
 
+		/// Passes every bone matrix to the shader, up to MAX_NUM_BONE_MATRICES.
+		void SetBoneMatrices();
+
 		Int32 wvp_matrix_variable_index_;
 		Int32 world_matrix_variable_index_;
 //		Int32 invworld_matrix_variable_index_;
@@ -75,6 +82,10 @@ namespace gef
 
 		gef::Matrix44 view_projection_matrix_;
 
+		/// The bone matrices from the last SetSceneData, and whether the shader currently has a primitive's bone palette rather than all of them.
+		const std::vector<Matrix44>* bone_matrices_;
+		bool bone_palette_set_;
+
 	};
 
 } /* namespace gef */
@@ -41,47 +41,35 @@ bool Font::Load(const char* font_name)
 {
 	std::string font_config_filename(font_name);
 	font_config_filename += ".fnt";
-	void* font_file_data = NULL;
+	const void* font_file_data = NULL;
 	Int32 file_size = 0;
 	gef::File* file = gef::File::Create();
 	
 	bool success = true;
+	bool config_initialised = false;
 	success = file->Open(font_config_filename.c_str());
 	if(success)
 	{
-		success = file->GetSize(file_size);
+		// the font config is parsed straight from a mapping of the file
+		success = file->Map(&font_file_data, file_size);
 		if(success)
 		{
-			font_file_data = malloc(file_size);
-			success = font_file_data != NULL;
-			if(success)
-			{
-				Int32 bytes_read;
-				success = file->Read(font_file_data, file_size, bytes_read);
-				if(success)
-					success = bytes_read == file_size;
-			}
+			gef::MemoryStreamBuffer font_buffer(font_file_data, file_size);
+
+			std::istream font_config_stream(&font_buffer);
+			config_initialised = ParseFont(font_config_stream, character_set);
+
+			// don't need the font file data any more
+			file->Unmap();
+			font_file_data = NULL;
 		}
 		file->Close();
-		delete file;
-		file = NULL;
 	}
-
-
-
-	bool config_initialised = false;
+	delete file;
+	file = NULL;
 
 	if(success)
 	{
-		gef::MemoryStreamBuffer font_buffer((char*)font_file_data, file_size);
-
-		std::istream font_config_stream(&font_buffer);
-		config_initialised = ParseFont(font_config_stream, character_set);
-
-		// don't need the font file data any more
-		free(font_file_data);
-		font_file_data = NULL;
-
 		std::string font_texture_filename(font_name);
 		font_texture_filename += "_0.png";
 		gef::ImageData image_data{ font_texture_filename.c_str() };
@@ -0,0 +1,180 @@
+#include <graphics/mesh_bvh.h>
+#include <graphics/mesh_data.h>
+
+namespace gef
+{
+	static UInt32 GetIndex(const PrimitiveData& primitive, const Int32 index_num)
+	{
+		switch (primitive.index_byte_size)
+		{
+		case 1:
+			return static_cast<const UInt8*>(primitive.indices)[index_num];
+		case 2:
+			return static_cast<const UInt16*>(primitive.indices)[index_num];
+		default:
+			return static_cast<const UInt32*>(primitive.indices)[index_num];
+		}
+	}
+
+	static const Vector4 GetPosition(const VertexData& vertex_data, const UInt32 index)
+	{
+		// the position is always at the start of the vertex
+		const float* position = reinterpret_cast<const float*>(static_cast<const char*>(vertex_data.vertices) + index*vertex_data.vertex_byte_size);
+		return Vector4(position[0], position[1], position[2]);
+	}
+
+	// tests the triangles in a leaf of the hierarchy four at a time
+	class MeshBvh::LeafTest
+	{
+	public:
+		LeafTest(const MeshBvh& mesh_bvh, const Ray& ray) :
+			mesh_bvh_(mesh_bvh),
+			ray_(ray),
+			closest_order_(-1)
+		{
+		}
+
+		bool operator()(const Int32 first_order, const Int32 count, float& distance)
+		{
+			bool hit = false;
+			const Int32 end_order = first_order + count;
+			for (Int32 order = first_order; order < end_order; order += 4)
+			{
+				TrianglePacket triangles;
+				for (Int32 axis = 0; axis < 3; ++axis)
+				{
+					triangles.v0[axis] = SimdLoad(&mesh_bvh_.v0_[axis][order]);
+					triangles.edge1[axis] = SimdLoad(&mesh_bvh_.edge1_[axis][order]);
+					triangles.edge2[axis] = SimdLoad(&mesh_bvh_.edge2_[axis][order]);
+				}
+
+				float distances[4];
+				Int32 hits = ray_.IntersectsTriangles(triangles, distance, distances);
+
+				// lanes past the end of the leaf belong to other leaves
+				if (end_order - order < 4)
+					hits &= (1 << (end_order - order)) - 1;
+
+				for (Int32 lane = 0; hits != 0; ++lane, hits >>= 1)
+				{
+					if ((hits & 1) && distances[lane] <= distance)
+					{
+						distance = distances[lane];
+						closest_order_ = order + lane;
+						hit = true;
+					}
+				}
+			}
+
+			return hit;
+		}
+
+		inline Int32 closest_order() const { return closest_order_; }
+
+	private:
+		const MeshBvh& mesh_bvh_;
+		const Ray& ray_;
+		Int32 closest_order_;
+	};
+
+	MeshBvh::MeshBvh()
+	{
+	}
+
+	void MeshBvh::Build(const MeshData& mesh_data)
+	{
+		std::vector<Vector4> vertices;
+		std::vector<Aabb> triangle_bounds;
+		std::vector<Int32> primitive_indices;
+		std::vector<Int32> triangle_indices;
+
+		for (std::vector<PrimitiveData*>::const_iterator primitive_iter = mesh_data.primitives.begin(); primitive_iter != mesh_data.primitives.end(); ++primitive_iter)
+		{
+			const PrimitiveData& primitive = **primitive_iter;
+
+			Int32 index_step;
+			Int32 triangle_count;
+			if (primitive.type == TRIANGLE_LIST)
+			{
+				index_step = 3;
+				triangle_count = primitive.num_indices / 3;
+			}
+			else if (primitive.type == TRIANGLE_STRIP)
+			{
+				index_step = 1;
+				triangle_count = primitive.num_indices - 2;
+			}
+			else
+				continue;
+
+			for (Int32 triangle_num = 0; triangle_num < triangle_count; ++triangle_num)
+			{
+				const Int32 first_index = triangle_num*index_step;
+				const UInt32 index0 = GetIndex(primitive, first_index);
+				const UInt32 index1 = GetIndex(primitive, first_index + 1);
+				const UInt32 index2 = GetIndex(primitive, first_index + 2);
+
+				// skip the degenerate triangles used to join triangle strips
+				if (index0 == index1 || index1 == index2 || index0 == index2)
+					continue;
+
+				Aabb bounds;
+				for (Int32 corner = 0; corner < 3; ++corner)
+				{
+					const Vector4 position = GetPosition(mesh_data.vertex_data, GetIndex(primitive, first_index + corner));
+					vertices.push_back(position);
+					bounds.Update(position);
+				}
+				triangle_bounds.push_back(bounds);
+				primitive_indices.push_back((Int32)(primitive_iter - mesh_data.primitives.begin()));
+				triangle_indices.push_back(triangle_num);
+			}
+		}
+
+		const Int32 triangle_count = (Int32)triangle_bounds.size();
+		bvh_.Build(triangle_count > 0 ? &triangle_bounds[0] : NULL, triangle_count);
+
+		// pad with zeros so four values can be loaded starting from any triangle
+		for (Int32 axis = 0; axis < 3; ++axis)
+		{
+			v0_[axis].assign(triangle_count + 3, 0.0f);
+			edge1_[axis].assign(triangle_count + 3, 0.0f);
+			edge2_[axis].assign(triangle_count + 3, 0.0f);
+		}
+		primitive_indices_.resize(triangle_count);
+		triangle_indices_.resize(triangle_count);
+
+		for (Int32 order = 0; order < triangle_count; ++order)
+		{
+			const Int32 triangle_index = bvh_.ordered_object_index(order);
+			const Vector4& v0 = vertices[triangle_index * 3];
+			const Vector4 edge1 = vertices[triangle_index * 3 + 1] - v0;
+			const Vector4 edge2 = vertices[triangle_index * 3 + 2] - v0;
+
+			for (Int32 axis = 0; axis < 3; ++axis)
+			{
+				v0_[axis][order] = v0[axis];
+				edge1_[axis][order] = edge1[axis];
+				edge2_[axis][order] = edge2[axis];
+			}
+			primitive_indices_[order] = primitive_indices[triangle_index];
+			triangle_indices_[order] = triangle_indices[triangle_index];
+		}
+	}
+
+	bool MeshBvh::Raycast(const Ray& ray, const float max_distance, MeshRayHit* hit) const
+	{
+		float distance = max_distance;
+		LeafTest leaf_test(*this, ray);
+		if (!bvh_.Raycast(ray, distance, leaf_test))
+			return false;
+
+		if (hit)
+		{
+			hit->distance = distance;
+			hit->primitive_index = primitive_indices_[leaf_test.closest_order()];
+			hit->triangle_index = triangle_indices_[leaf_test.closest_order()];
+		}
+		return true;
+	}
+}
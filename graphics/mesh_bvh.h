@@ -0,0 +1,78 @@
+#ifndef _GEF_MESH_BVH_H
+#define _GEF_MESH_BVH_H
+
+#include <gef.h>
+#include <maths/bvh.h>
+#include <maths/ray.h>
+#include <vector>
+
+namespace gef
+{
+	// forward declarations
+	struct MeshData;
+
+	/**
+	The result of a successful ray test against a MeshBvh.
+	*/
+	struct MeshRayHit
+	{
+		/// Distance along the ray to the hit.
+		float distance;
+
+		/// Index of the primitive in MeshData::primitives that contains the triangle that was hit.
+		Int32 primitive_index;
+
+		/// Index of the triangle in the primitive. For triangle lists the triangle uses indices [3*triangle_index, 3*triangle_index+2],
+		/// for triangle strips it uses indices [triangle_index, triangle_index+2].
+		Int32 triangle_index;
+	};
+
+	/**
+	A bounding volume hierarchy of the triangles in a mesh for picking and line of sight tests.
+	Build it once from the mesh data and then test as many rays against it as needed. The triangles are copied
+	so the mesh data doesn't need to be kept once the hierarchy has been built.
+	*/
+	class MeshBvh
+	{
+	public:
+		/// @brief Default constructor. Creates an empty hierarchy.
+		MeshBvh();
+
+		/// @brief Builds the hierarchy from the triangle list and triangle strip primitives of a mesh.
+		/// @param[in] mesh_data	The mesh data. The vertex position must be the first three floats of each vertex.
+		/// @note Any previous contents of the hierarchy are discarded.
+		void Build(const MeshData& mesh_data);
+
+		/// @brief Finds the nearest triangle hit by a ray.
+		/// @param[in] ray				The ray, in the mesh's space. Use Ray::Transform with the inverse of the mesh instance's transform to test a world space ray.
+		/// @param[in] max_distance		Triangles further along the ray than this are ignored.
+		/// @param[out] hit				If not NULL, receives the details of the hit.
+		/// @return true if a triangle was hit.
+		bool Raycast(const Ray& ray, const float max_distance, MeshRayHit* hit = NULL) const;
+
+		/// @brief Get the number of triangles in the hierarchy.
+		inline Int32 triangle_count() const { return bvh_.object_count(); }
+
+		/// @brief Get the bounds of all the triangles in the hierarchy.
+		inline const Aabb bounds() const { return bvh_.bounds(); }
+
+	private:
+		class LeafTest;
+
+		/// Hierarchy of the triangle bounds.
+		Bvh bvh_;
+
+		/// Triangle data in the order of the hierarchy leaves, with each component in a separate array so
+		/// the triangles in a leaf can be loaded straight in to a TrianglePacket.
+		/// Each array is padded with three zeros so four values can be loaded starting from any triangle.
+		std::vector<float> v0_[3];
+		std::vector<float> edge1_[3];
+		std::vector<float> edge2_[3];
+
+		/// The primitive and triangle number of each triangle, also in the order of the hierarchy leaves.
+		std::vector<Int32> primitive_indices_;
+		std::vector<Int32> triangle_indices_;
+	};
+}
+
+#endif // _GEF_MESH_BVH_H
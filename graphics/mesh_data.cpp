@@ -1,8 +1,160 @@
 #include <graphics/mesh_data.h>
+#include <graphics/mesh.h>
+#include <graphics/default_3d_skinning_shader.h>
 #include <cstdlib>
+#include <cstring>
 
 namespace gef
 {
+	// set in the primitive type written to a stream when a bone palette follows the indices
+	static const Int32 kBonePaletteFlag = 0x10000;
+
+	const Int32 MeshData::kMinBonePaletteSize = 12;
+	const Int32 MeshData::kMaxBonePaletteSize = MAX_NUM_BONE_MATRICES;
+
+	/**
+	Builds the primitives and vertices for MeshData::SplitBonePalettes, one primitive at a time.
+	*/
+	class BonePaletteSplitter
+	{
+	public:
+		BonePaletteSplitter(const Mesh::SkinnedVertex* vertices, const Int32 num_vertices, const Int32 max_palette_size) :
+			vertices_(vertices),
+			max_palette_size_(max_palette_size),
+			vertex_remap_(num_vertices, -1),
+			joint_slots_(256, -1)
+		{
+			new_vertices_.reserve(num_vertices);
+		}
+
+		/// Adds a triangle or line, starting a new primitive first if its joints don't fit in the current palette.
+		void AddElement(const UInt32* element_indices, const Int32 element_size, const PrimitiveData& source)
+		{
+			if ((Int32)palette_.size() + CountNewJoints(element_indices, element_size) > max_palette_size_)
+				Flush(source);
+
+			for (Int32 element_vertex_num = 0; element_vertex_num < element_size; ++element_vertex_num)
+			{
+				const UInt32 vertex_index = element_indices[element_vertex_num];
+				if (vertex_remap_[vertex_index] == -1)
+				{
+					Mesh::SkinnedVertex vertex = vertices_[vertex_index];
+					for (Int32 influence_num = 0; influence_num < 4; ++influence_num)
+					{
+						if (vertex.bone_weights[influence_num] > 0.0f)
+						{
+							const UInt8 joint_index = vertex.bone_indices[influence_num];
+							if (joint_slots_[joint_index] == -1)
+							{
+								joint_slots_[joint_index] = (Int32)palette_.size();
+								palette_.push_back(joint_index);
+							}
+							vertex.bone_indices[influence_num] = (UInt8)joint_slots_[joint_index];
+						}
+						else
+						{
+							vertex.bone_indices[influence_num] = 0;
+						}
+					}
+
+					vertex_remap_[vertex_index] = (Int32)new_vertices_.size();
+					used_vertices_.push_back(vertex_index);
+					new_vertices_.push_back(vertex);
+				}
+
+				indices_.push_back(vertex_remap_[vertex_index]);
+			}
+		}
+
+		/// Finishes the current primitive, if it has anything in it.
+		void Flush(const PrimitiveData& source)
+		{
+			if (!indices_.empty())
+			{
+				UInt32 max_index = 0;
+				for (std::vector<UInt32>::const_iterator index_iter = indices_.begin(); index_iter != indices_.end(); ++index_iter)
+					max_index = *index_iter > max_index ? *index_iter : max_index;
+
+				PrimitiveData* primitive = new PrimitiveData();
+				primitive->material_name_id = source.material_name_id;
+				primitive->type = source.type == LINE_LIST ? LINE_LIST : TRIANGLE_LIST;
+				primitive->num_indices = (Int32)indices_.size();
+				primitive->index_byte_size = (source.index_byte_size == 2 && max_index <= 0xffff) ? 2 : 4;
+				primitive->indices = malloc(primitive->num_indices*primitive->index_byte_size);
+				for (Int32 index_num = 0; index_num < primitive->num_indices; ++index_num)
+				{
+					if (primitive->index_byte_size == 2)
+						static_cast<UInt16*>(primitive->indices)[index_num] = (UInt16)indices_[index_num];
+					else
+						static_cast<UInt32*>(primitive->indices)[index_num] = indices_[index_num];
+				}
+				primitive->bone_palette = palette_;
+				primitives_.push_back(primitive);
+			}
+
+			// vertices are copied again by the next primitive that uses them, as its palette is different
+			for (std::vector<Int32>::const_iterator joint_iter = palette_.begin(); joint_iter != palette_.end(); ++joint_iter)
+				joint_slots_[*joint_iter] = -1;
+			for (std::vector<UInt32>::const_iterator vertex_iter = used_vertices_.begin(); vertex_iter != used_vertices_.end(); ++vertex_iter)
+				vertex_remap_[*vertex_iter] = -1;
+
+			indices_.clear();
+			palette_.clear();
+			used_vertices_.clear();
+		}
+
+		inline std::vector<Mesh::SkinnedVertex>& new_vertices() { return new_vertices_; }
+		inline std::vector<PrimitiveData*>& primitives() { return primitives_; }
+
+	private:
+		Int32 CountNewJoints(const UInt32* element_indices, const Int32 element_size) const
+		{
+			Int32 new_joints[12];
+			Int32 new_joint_count = 0;
+			for (Int32 element_vertex_num = 0; element_vertex_num < element_size; ++element_vertex_num)
+			{
+				const Mesh::SkinnedVertex& vertex = vertices_[element_indices[element_vertex_num]];
+				for (Int32 influence_num = 0; influence_num < 4; ++influence_num)
+				{
+					const Int32 joint_index = vertex.bone_indices[influence_num];
+					if (vertex.bone_weights[influence_num] <= 0.0f || joint_slots_[joint_index] != -1)
+						continue;
+
+					bool found = false;
+					for (Int32 new_joint_num = 0; new_joint_num < new_joint_count; ++new_joint_num)
+						found = found || new_joints[new_joint_num] == joint_index;
+					if (!found)
+						new_joints[new_joint_count++] = joint_index;
+				}
+			}
+
+			return new_joint_count;
+		}
+
+		const Mesh::SkinnedVertex* vertices_;
+		Int32 max_palette_size_;
+
+		/// The index in new_vertices_ of each source vertex used by the current primitive, and the palette slot of each joint it uses. -1 if not used yet.
+		std::vector<Int32> vertex_remap_;
+		std::vector<Int32> joint_slots_;
+
+		/// The current primitive.
+		std::vector<UInt32> indices_;
+		std::vector<Int32> palette_;
+		std::vector<UInt32> used_vertices_;
+
+		std::vector<Mesh::SkinnedVertex> new_vertices_;
+		std::vector<PrimitiveData*> primitives_;
+	};
+
+	static UInt32 GetIndex(const PrimitiveData& primitive, const Int32 index_num)
+	{
+		if (primitive.index_byte_size == 2)
+			return static_cast<const UInt16*>(primitive.indices)[index_num];
+		else
+			return static_cast<const UInt32*>(primitive.indices)[index_num];
+	}
+
 	MeshData::MeshData()
 	{
 	}
@@ -63,6 +215,75 @@ namespace gef
 
 
 
+	bool MeshData::SplitBonePalettes(const Int32 max_palette_size)
+	{
+		if ((vertex_data.num_vertices == 0) || (vertex_data.vertex_byte_size != sizeof(Mesh::SkinnedVertex)) || (max_palette_size < kMinBonePaletteSize))
+			return false;
+
+		// the shader only has room for MAX_NUM_BONE_MATRICES, and palette slots are stored in the vertices' UInt8 bone indices
+		if (max_palette_size > kMaxBonePaletteSize)
+			return false;
+
+		// every primitive must be indexed, as the vertices are rebuilt
+		for (std::vector<PrimitiveData*>::const_iterator prim_iter = primitives.begin(); prim_iter != primitives.end(); ++prim_iter)
+		{
+			const PrimitiveData& primitive = **prim_iter;
+			if (!primitive.bone_palette.empty() || !primitive.indices || primitive.num_indices == 0 || (primitive.index_byte_size != 2 && primitive.index_byte_size != 4))
+				return false;
+			if (primitive.type != TRIANGLE_LIST && primitive.type != TRIANGLE_STRIP && primitive.type != LINE_LIST)
+				return false;
+		}
+
+		BonePaletteSplitter splitter((const Mesh::SkinnedVertex*)vertex_data.vertices, vertex_data.num_vertices, max_palette_size);
+
+		for (std::vector<PrimitiveData*>::const_iterator prim_iter = primitives.begin(); prim_iter != primitives.end(); ++prim_iter)
+		{
+			const PrimitiveData& primitive = **prim_iter;
+			UInt32 element_indices[3];
+
+			if (primitive.type == TRIANGLE_STRIP)
+			{
+				for (Int32 triangle_num = 0; triangle_num + 2 < primitive.num_indices; ++triangle_num)
+				{
+					// every other triangle in a strip is wound the other way
+					element_indices[0] = GetIndex(primitive, triangle_num + (triangle_num & 1));
+					element_indices[1] = GetIndex(primitive, triangle_num + 1 - (triangle_num & 1));
+					element_indices[2] = GetIndex(primitive, triangle_num + 2);
+
+					// strips use degenerate triangles to join separate strips
+					if (element_indices[0] != element_indices[1] && element_indices[1] != element_indices[2] && element_indices[0] != element_indices[2])
+						splitter.AddElement(element_indices, 3, primitive);
+				}
+			}
+			else
+			{
+				const Int32 element_size = primitive.type == LINE_LIST ? 2 : 3;
+				for (Int32 index_num = 0; index_num + element_size <= primitive.num_indices; index_num += element_size)
+				{
+					for (Int32 element_vertex_num = 0; element_vertex_num < element_size; ++element_vertex_num)
+						element_indices[element_vertex_num] = GetIndex(primitive, index_num + element_vertex_num);
+					splitter.AddElement(element_indices, element_size, primitive);
+				}
+			}
+
+			splitter.Flush(primitive);
+		}
+
+		// replace the vertices and primitives
+		const std::vector<Mesh::SkinnedVertex>& new_vertices = splitter.new_vertices();
+		free(vertex_data.vertices);
+		vertex_data.num_vertices = (Int32)new_vertices.size();
+		vertex_data.vertices = malloc(new_vertices.size()*sizeof(Mesh::SkinnedVertex));
+		if (!new_vertices.empty())
+			memcpy(vertex_data.vertices, &new_vertices[0], new_vertices.size()*sizeof(Mesh::SkinnedVertex));
+
+		for (std::vector<PrimitiveData*>::iterator prim_iter = primitives.begin(); prim_iter != primitives.end(); ++prim_iter)
+			delete *prim_iter;
+		primitives = splitter.primitives();
+
+		return true;
+	}
+
 	VertexData::VertexData() :
 		vertices(NULL)
 	{
@@ -126,7 +347,12 @@ namespace gef
 		stream.read((char*)&material_name_id, sizeof(gef::StringId));
 		stream.read((char*)&num_indices, sizeof(Int32));
 		stream.read((char*)&index_byte_size, sizeof(Int32));
-		stream.read((char*)&type, sizeof(PrimitiveType));
+
+		// the type is followed by a bone palette if it has the palette flag
+		Int32 type_value;
+		stream.read((char*)&type_value, sizeof(Int32));
+		const bool has_bone_palette = type_value != UNDEFINED && (type_value & kBonePaletteFlag) != 0;
+		type = (PrimitiveType)(has_bone_palette ? type_value & ~kBonePaletteFlag : type_value);
 
 		indices = malloc(num_indices*index_byte_size);
 		if(indices)
@@ -134,6 +360,15 @@ namespace gef
 		else
 			success = false;
 
+		if (has_bone_palette)
+		{
+			Int32 bone_palette_size;
+			stream.read((char*)&bone_palette_size, sizeof(Int32));
+			bone_palette.resize(bone_palette_size);
+			if (bone_palette_size > 0)
+				stream.read((char*)&bone_palette[0], bone_palette_size*sizeof(Int32));
+		}
+
 		return success;
 	}
 
@@ -148,9 +383,20 @@ namespace gef
 		stream.write((char*)&material_name_id, sizeof(gef::StringId));
 		stream.write((char*)&num_indices, sizeof(Int32));
 		stream.write((char*)&index_byte_size, sizeof(Int32));
-		stream.write((char*)&type, sizeof(PrimitiveType));
+
+		Int32 type_value = type;
+		if (!bone_palette.empty())
+			type_value |= kBonePaletteFlag;
+		stream.write((char*)&type_value, sizeof(Int32));
 		stream.write((char*)indices, num_indices*index_byte_size);
 
+		if (!bone_palette.empty())
+		{
+			Int32 bone_palette_size = (Int32)bone_palette.size();
+			stream.write((char*)&bone_palette_size, sizeof(Int32));
+			stream.write((char*)&bone_palette[0], bone_palette_size*sizeof(Int32));
+		}
+
 		return success;
 	}
 
@@ -37,6 +37,10 @@ namespace gef
 		Int32 num_indices;
 		Int32 index_byte_size;
 		PrimitiveType type;
+
+		/// The joints used by the primitive when its vertex bone indices have been remapped by MeshData::SplitBonePalettes.
+		/// Bone index i of a vertex used by the primitive refers to joint bone_palette[i]. Empty if the bone indices are joint indices.
+		std::vector<Int32> bone_palette;
 	};
 
 	struct VertexData
@@ -61,6 +65,20 @@ namespace gef
 		bool Read(std::istream& stream);
 		bool Write(std::ostream& stream) const;
 
+		/// @brief Splits the primitives of a skinned mesh so each one uses no more than a maximum number of joints, and
+		/// gives each one a bone palette of the joints it uses, so only those bone matrices need to be passed to the shader.
+		/// Vertex bone indices are remapped to palette slots, and vertices used by more than one primitive are copied.
+		/// Triangle strips are converted to triangle lists.
+		/// @param[in] max_palette_size		The most joints a primitive can use, from kMinBonePaletteSize to kMaxBonePaletteSize.
+		/// @return false if the mesh isn't skinned, has already been split or the palette size is out of range.
+		bool SplitBonePalettes(const Int32 max_palette_size);
+
+		/// The smallest palette any one triangle fits in, as each of its vertices has up to four joints.
+		static const Int32 kMinBonePaletteSize;
+
+		/// The most bone matrices the skinning shader is passed, MAX_NUM_BONE_MATRICES.
+		static const Int32 kMaxBonePaletteSize;
+
 		VertexData vertex_data;
 		std::vector<PrimitiveData*> primitives;
 		gef::StringId name_id;
@@ -6,12 +6,14 @@
 #include <graphics/primitive.h>
 #include <system/platform.h>
 #include <graphics/texture.h>
+#include <graphics/resource_cache.h>
 
 
 namespace gef
 {
 	Model::Model() :
-		mesh_(NULL)
+		mesh_(NULL),
+		resource_cache_(NULL)
 	{
 	}
 
@@ -23,7 +25,12 @@ namespace gef
 	void Model::Release()
 	{
 		for(UInt32 texture_num=0;texture_num<textures_.size();++texture_num)
-			DeleteNull(textures_[texture_num]);
+		{
+			if(resource_cache_)
+				resource_cache_->ReleaseTexture(textures_[texture_num]);
+			else
+				DeleteNull(textures_[texture_num]);
+		}
 		textures_.clear();
 		DeleteNull(mesh_);
 	}
@@ -9,6 +9,7 @@ namespace gef
 	class Mesh;
 	class Texture;
 	class Material;
+	class ResourceCache;
 
 	class Model
 	{
@@ -21,12 +22,16 @@ namespace gef
 		inline Mesh* mesh() { return mesh_; }
 		inline void set_textures(const std::vector<Texture*>& textures) { textures_ = textures; }
 
+		/// @brief Sets the cache the textures were borrowed from, so Release gives them back to it rather than deleting them.
+		inline void set_resource_cache(ResourceCache* resource_cache) { resource_cache_ = resource_cache; }
+
 		inline void AddMaterial(Material* material) { materials_.push_back(material); }
 		inline const Material* material(Int32 material_num) const { return materials_[material_num]; }
 	private:
 		Mesh* mesh_;
 		std::vector<Texture*> textures_;
 		std::vector<Material*> materials_;
+		ResourceCache* resource_cache_;
 	};
 }
 
@@ -2,6 +2,7 @@
 #define _GEF_PRIMITIVE_H
 
 #include <gef.h>
+#include <vector>
 
 namespace gef
 {
@@ -36,12 +37,17 @@ namespace gef
 		inline void set_type(PrimitiveType type) { type_ = type; }
 		inline PrimitiveType type() const { return type_; }
 
+		/// @brief Get the joints used by the primitive, see PrimitiveData::bone_palette. Empty if the vertex bone indices are joint indices.
+		inline const std::vector<Int32>& bone_palette() const { return bone_palette_; }
+		inline void set_bone_palette(const std::vector<Int32>& bone_palette) { bone_palette_ = bone_palette; }
+
 	protected:
 
 		const Material* material_;
 		PrimitiveType type_;
 		IndexBuffer* index_buffer_;
 		Platform& platform_;
+		std::vector<Int32> bone_palette_;
 
 	};
 
@@ -0,0 +1,254 @@
+#include <graphics/resource_cache.h>
+#include <graphics/texture.h>
+#include <graphics/material.h>
+#include <graphics/mesh.h>
+#include <graphics/primitive.h>
+#include <graphics/mesh_data.h>
+#include <graphics/image_data.h>
+#include <system/crc.h>
+#include <vector>
+
+namespace gef
+{
+	ResourceCache::ResourceCache()
+	{
+	}
+
+	ResourceCache::~ResourceCache()
+	{
+		// meshes refer to materials and materials to textures, so they're deleted in that order
+		for (std::multimap<UInt32, Mesh*>::iterator mesh_iter = meshes_.begin(); mesh_iter != meshes_.end(); ++mesh_iter)
+			delete mesh_iter->second;
+
+		for (std::multimap<UInt32, Material*>::iterator material_iter = materials_.begin(); material_iter != materials_.end(); ++material_iter)
+			delete material_iter->second;
+
+		for (std::multimap<UInt32, Texture*>::iterator texture_iter = textures_.begin(); texture_iter != textures_.end(); ++texture_iter)
+			delete texture_iter->second;
+	}
+
+	// FNV-1a, so mesh data is compared with a 64-bit hash as well as the CRC it's found by
+	static UInt64 GetHash64(const void* data, const size_t size)
+	{
+		const UInt8* bytes = (const UInt8*)data;
+		UInt64 hash = 0xcbf29ce484222325ULL;
+		for (size_t byte_num = 0; byte_num < size; ++byte_num)
+		{
+			hash ^= bytes[byte_num];
+			hash *= 0x100000001b3ULL;
+		}
+
+		return hash;
+	}
+
+	template <class Value> static void AppendContent(std::string& content, const Value& value)
+	{
+		content.append((const char*)&value, sizeof(Value));
+	}
+
+	template <class Resource> Resource* ResourceCache::Find(std::multimap<UInt32, Resource*>& resources, std::map<const void*, Entry>& entries, const std::string& content)
+	{
+		// resources with the same key are only the same if they were created from the same content
+		typedef typename std::multimap<UInt32, Resource*>::iterator ResourceIterator;
+		const std::pair<ResourceIterator, ResourceIterator> range = resources.equal_range(CRC::GetCRC(content.data(), (UInt32)content.size()));
+		for (ResourceIterator resource_iter = range.first; resource_iter != range.second; ++resource_iter)
+		{
+			Entry& entry = entries[resource_iter->second];
+			if (entry.content == content)
+			{
+				++entry.reference_count;
+				return resource_iter->second;
+			}
+		}
+
+		return NULL;
+	}
+
+	template <class Resource> void ResourceCache::Add(std::multimap<UInt32, Resource*>& resources, std::map<const void*, Entry>& entries, const std::string& content, Resource* resource)
+	{
+		const UInt32 key = CRC::GetCRC(content.data(), (UInt32)content.size());
+		resources.insert(std::make_pair(key, resource));
+
+		Entry& entry = entries[resource];
+		entry.key = key;
+		entry.reference_count = 1;
+		entry.content = content;
+	}
+
+	template <class Resource> bool ResourceCache::Release(std::multimap<UInt32, Resource*>& resources, std::map<const void*, Entry>& entries, const Resource* resource)
+	{
+		// resources that aren't in the cache, e.g. NULL textures, are ignored
+		std::map<const void*, Entry>::iterator entry_iter = entries.find(resource);
+		if (entry_iter == entries.end())
+			return false;
+
+		typedef typename std::multimap<UInt32, Resource*>::iterator ResourceIterator;
+		const std::pair<ResourceIterator, ResourceIterator> range = resources.equal_range(entry_iter->second.key);
+		ResourceIterator resource_iter = range.first;
+		while (resource_iter != range.second && resource_iter->second != resource)
+			++resource_iter;
+
+		if (resource_iter == range.second)
+			return false;
+
+		if (--entry_iter->second.reference_count > 0)
+			return false;
+
+		// the caller deletes the resource once it has released anything the resource refers to
+		resources.erase(resource_iter);
+		entries.erase(entry_iter);
+		return true;
+	}
+
+	Texture* ResourceCache::FindTexture(const char* filename)
+	{
+		std::string content;
+		GetTextureContent(filename, content);
+		return Find(textures_, entries_, content);
+	}
+
+	void ResourceCache::AddTexture(const char* filename, Texture* texture)
+	{
+		std::string content;
+		GetTextureContent(filename, content);
+		Add(textures_, entries_, content, texture);
+	}
+
+	Texture* ResourceCache::LoadTexture(const Platform& platform, const char* filename)
+	{
+		Texture* texture = FindTexture(filename);
+		if (texture)
+			return texture;
+
+		ImageData image_data(filename);
+		if (image_data.image() == NULL)
+			return NULL;
+
+		texture = Texture::Create(platform, image_data);
+		if (texture)
+			AddTexture(filename, texture);
+
+		return texture;
+	}
+
+	void ResourceCache::ReleaseTexture(const Texture* texture)
+	{
+		if (Release(textures_, entries_, texture))
+			delete texture;
+	}
+
+	Material* ResourceCache::FindMaterial(const MaterialData& material_data)
+	{
+		std::string content;
+		GetMaterialContent(material_data, content);
+		return Find(materials_, entries_, content);
+	}
+
+	void ResourceCache::AddMaterial(const MaterialData& material_data, Material* material)
+	{
+		std::string content;
+		GetMaterialContent(material_data, content);
+		Add(materials_, entries_, content, material);
+
+		// the material keeps its texture
+		if (material->texture() && GetReferenceCount(material->texture()) > 0)
+			++entries_[material->texture()].reference_count;
+	}
+
+	void ResourceCache::ReleaseMaterial(const Material* material)
+	{
+		if (Release(materials_, entries_, material))
+		{
+			const Texture* texture = material->texture();
+			delete material;
+
+			// only textures in the cache are released
+			ReleaseTexture(texture);
+		}
+	}
+
+	Mesh* ResourceCache::FindMesh(const MeshData& mesh_data, const std::map<StringId, MaterialData*>& material_data)
+	{
+		std::string content;
+		GetMeshContent(mesh_data, material_data, content);
+		return Find(meshes_, entries_, content);
+	}
+
+	void ResourceCache::AddMesh(const MeshData& mesh_data, const std::map<StringId, MaterialData*>& material_data, Mesh* mesh)
+	{
+		std::string content;
+		GetMeshContent(mesh_data, material_data, content);
+		Add(meshes_, entries_, content, mesh);
+
+		// the mesh keeps the materials of its primitives
+		for (UInt32 primitive_num = 0; primitive_num < mesh->num_primitives(); ++primitive_num)
+		{
+			const Material* material = mesh->GetPrimitive(primitive_num)->material();
+			if (material && GetReferenceCount(material) > 0)
+				++entries_[material].reference_count;
+		}
+	}
+
+	void ResourceCache::ReleaseMesh(const Mesh* mesh)
+	{
+		if (Release(meshes_, entries_, mesh))
+		{
+			std::vector<const Material*> primitive_materials;
+			primitive_materials.reserve(mesh->num_primitives());
+			for (UInt32 primitive_num = 0; primitive_num < mesh->num_primitives(); ++primitive_num)
+				primitive_materials.push_back(mesh->GetPrimitive(primitive_num)->material());
+
+			delete mesh;
+
+			for (std::vector<const Material*>::const_iterator material_iter = primitive_materials.begin(); material_iter != primitive_materials.end(); ++material_iter)
+				ReleaseMaterial(*material_iter);
+		}
+	}
+
+	Int32 ResourceCache::GetReferenceCount(const void* resource) const
+	{
+		std::map<const void*, Entry>::const_iterator entry_iter = entries_.find(resource);
+		return entry_iter != entries_.end() ? entry_iter->second.reference_count : 0;
+	}
+
+	void ResourceCache::GetTextureContent(const char* filename, std::string& content)
+	{
+		content = filename;
+	}
+
+	void ResourceCache::GetMaterialContent(const MaterialData& material_data, std::string& content)
+	{
+		content.clear();
+		AppendContent(content, material_data.colour);
+		content += material_data.diffuse_texture;
+	}
+
+	void ResourceCache::GetMeshContent(const MeshData& mesh_data, const std::map<StringId, MaterialData*>& material_data, std::string& content)
+	{
+		// a copy of the vertices and indices would double the memory used by cached meshes, so they're compared by size and a 64-bit hash
+		content.clear();
+		AppendContent(content, mesh_data.vertex_data.num_vertices);
+		AppendContent(content, mesh_data.vertex_data.vertex_byte_size);
+		AppendContent(content, GetHash64(mesh_data.vertex_data.vertices, (size_t)mesh_data.vertex_data.num_vertices*mesh_data.vertex_data.vertex_byte_size));
+
+		std::string material_content;
+		for (std::vector<PrimitiveData*>::const_iterator prim_iter = mesh_data.primitives.begin(); prim_iter != mesh_data.primitives.end(); ++prim_iter)
+		{
+			const PrimitiveData& primitive = **prim_iter;
+			AppendContent(content, (Int32)primitive.type);
+			AppendContent(content, primitive.num_indices);
+			AppendContent(content, primitive.index_byte_size);
+			AppendContent(content, GetHash64(primitive.indices, (size_t)primitive.num_indices*primitive.index_byte_size));
+			AppendContent(content, (UInt32)primitive.bone_palette.size());
+			AppendContent(content, primitive.bone_palette.empty() ? 0 : GetHash64(&primitive.bone_palette[0], primitive.bone_palette.size()*sizeof(Int32)));
+
+			// the material's content is preceded by its size, so the contents of different primitives can't run together
+			material_content.clear();
+			std::map<StringId, MaterialData*>::const_iterator material_iter = material_data.find(primitive.material_name_id);
+			if (material_iter != material_data.end() && material_iter->second)
+				GetMaterialContent(*material_iter->second, material_content);
+			AppendContent(content, (UInt32)material_content.size());
+			content += material_content;
+		}
+	}
+}
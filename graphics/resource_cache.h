@@ -0,0 +1,99 @@
+#ifndef _GEF_RESOURCE_CACHE_H
+#define _GEF_RESOURCE_CACHE_H
+
+#include <gef.h>
+#include <system/string_id.h>
+#include <map>
+#include <string>
+
+namespace gef
+{
+	// forward declarations
+	class Platform;
+	class Texture;
+	class Material;
+	class Mesh;
+	struct MaterialData;
+	struct MeshData;
+
+	/**
+	Shares textures, materials and meshes between everything that loads them, e.g. the scenes of levels that use the same texture set,
+	so each one is only decoded and created once. One cache is meant to be used for the whole of the application.
+	Resources are found by what they were created from. Textures are found by their filename and materials by their colour and texture.
+	Meshes are found by the sizes of their vertices, indices and bone palettes, 64-bit hashes of their contents and their materials.
+	Each resource has a reference count. Find and Add give the caller a reference, and the resource is deleted when the last one is released.
+	Materials keep a reference to their texture, and meshes to the materials of their primitives, if those are in the cache.
+	The cache isn't thread safe, so it should only be used by the thread that creates renderer objects.
+	*/
+	class ResourceCache
+	{
+	public:
+		ResourceCache();
+
+		/// @note Resources that haven't been released are deleted.
+		~ResourceCache();
+
+		/// @brief Finds the texture loaded from a file and adds a reference to it.
+		/// @return The texture, or NULL if there isn't one for the file.
+		Texture* FindTexture(const char* filename);
+
+		/// @brief Adds a texture loaded from a file, which then belongs to the cache. The caller is given a reference to it.
+		/// @note There mustn't already be a texture for the file.
+		void AddTexture(const char* filename, Texture* texture);
+
+		/// @brief Finds the texture for an image file, or decodes the file and creates one if it's not in the cache.
+		/// @return The texture with a reference added, or NULL if the file couldn't be decoded.
+		Texture* LoadTexture(const Platform& platform, const char* filename);
+
+		/// @brief Releases a reference to a texture, deleting the texture if it was the last one.
+		void ReleaseTexture(const Texture* texture);
+
+		Material* FindMaterial(const MaterialData& material_data);
+		void AddMaterial(const MaterialData& material_data, Material* material);
+		void ReleaseMaterial(const Material* material);
+
+		/// @param[in] mesh_data		The mesh data.
+		/// @param[in] material_data	The material data of the scene, used to find the primitives' materials.
+		Mesh* FindMesh(const MeshData& mesh_data, const std::map<StringId, MaterialData*>& material_data);
+		void AddMesh(const MeshData& mesh_data, const std::map<StringId, MaterialData*>& material_data, Mesh* mesh);
+		void ReleaseMesh(const Mesh* mesh);
+
+		/// @brief Gets the number of references to a resource, or zero if it's not in the cache.
+		Int32 GetReferenceCount(const void* resource) const;
+
+		inline Int32 texture_count() const { return (Int32)textures_.size(); }
+		inline Int32 material_count() const { return (Int32)materials_.size(); }
+		inline Int32 mesh_count() const { return (Int32)meshes_.size(); }
+
+	private:
+		ResourceCache(const ResourceCache&);
+		ResourceCache& operator=(const ResourceCache&);
+
+		struct Entry
+		{
+			UInt32 key;
+			Int32 reference_count;
+
+			/// What the resource was created from, compared when a resource with the same key is found.
+			std::string content;
+		};
+
+		static void GetTextureContent(const char* filename, std::string& content);
+		static void GetMaterialContent(const MaterialData& material_data, std::string& content);
+		static void GetMeshContent(const MeshData& mesh_data, const std::map<StringId, MaterialData*>& material_data, std::string& content);
+
+		template <class Resource> static Resource* Find(std::multimap<UInt32, Resource*>& resources, std::map<const void*, Entry>& entries, const std::string& content);
+		template <class Resource> static void Add(std::multimap<UInt32, Resource*>& resources, std::map<const void*, Entry>& entries, const std::string& content, Resource* resource);
+		template <class Resource> static bool Release(std::multimap<UInt32, Resource*>& resources, std::map<const void*, Entry>& entries, const Resource* resource);
+
+		/// The resources of each type by the CRC of their content. Different content can have the same CRC.
+		std::multimap<UInt32, Texture*> textures_;
+		std::multimap<UInt32, Material*> materials_;
+		std::multimap<UInt32, Mesh*> meshes_;
+
+		/// The key, reference count and content of every resource.
+		std::map<const void*, Entry> entries_;
+	};
+}
+
+#endif // _GEF_RESOURCE_CACHE_H
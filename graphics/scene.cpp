@@ -8,14 +8,23 @@
 #include <graphics/image_data.h>
 #include <assets/png_loader.h>
 #include <graphics/material.h>
+#include <graphics/resource_cache.h>
+#include <system/worker_pool.h>
 
 #include <system/file.h>
 #include <system/memory_stream_buffer.h>
 #include <fstream>
+#include <set>
 #include <assert.h>
+#include <string.h>
 
 namespace gef
 {
+	Scene::Scene() :
+		resource_cache(NULL)
+	{
+	}
+
 	Scene::~Scene()
 	{
 		// free up skeletons
@@ -26,17 +35,30 @@ namespace gef
 //		for(std::list<MeshData>::iterator mesh_iter = mesh_data.begin(); mesh_iter != mesh_data.end(); ++mesh_iter)
 //			delete *mesh_iter;
 
-		// free up textures
+		// free up textures, materials and meshes, giving back any that were borrowed from the resource cache
 		for(std::list<Texture*>::iterator texture_iter = textures.begin(); texture_iter != textures.end(); ++texture_iter)
-			delete *texture_iter;
+		{
+			if(resource_cache && resource_cache->GetReferenceCount(*texture_iter) > 0)
+				resource_cache->ReleaseTexture(*texture_iter);
+			else
+				delete *texture_iter;
+		}
 
-		// free up materials
 		for(std::list<Material*>::iterator material_iter = materials.begin(); material_iter != materials.end(); ++material_iter)
-			delete *material_iter;
+		{
+			if(resource_cache && resource_cache->GetReferenceCount(*material_iter) > 0)
+				resource_cache->ReleaseMaterial(*material_iter);
+			else
+				delete *material_iter;
+		}
 
-		// free up meshes
 		for (std::list<Mesh*>::iterator mesh_iter = meshes.begin(); mesh_iter != meshes.end(); ++mesh_iter)
-			delete *mesh_iter;
+		{
+			if(resource_cache && resource_cache->GetReferenceCount(*mesh_iter) > 0)
+				resource_cache->ReleaseMesh(*mesh_iter);
+			else
+				delete *mesh_iter;
+		}
 
 
 		// free up animations
@@ -46,6 +68,16 @@ namespace gef
 
 	Mesh* Scene::CreateMesh(Platform& platform, const MeshData& mesh_data, const bool read_only)
 	{
+		// a mesh with the same vertices, indices and materials may already have been created by another scene.
+		// meshes that can be written to aren't shared, as the changes would show in every scene using them
+		ResourceCache* mesh_cache = read_only ? resource_cache : NULL;
+		if(mesh_cache)
+		{
+			Mesh* cached_mesh = mesh_cache->FindMesh(mesh_data, material_data_map);
+			if(cached_mesh)
+				return cached_mesh;
+		}
+
 		Mesh* mesh = new Mesh(platform);
 		mesh->set_aabb(mesh_data.aabb);
 		mesh->set_bounding_sphere(gef::Sphere(mesh->aabb()));
@@ -60,6 +92,7 @@ namespace gef
 			Primitive* primitive = mesh->GetPrimitive(prim_index);
 			primitive->set_type((*prim_iter)->type);
 			primitive->InitIndexBuffer(platform, (*prim_iter)->indices, (*prim_iter)->num_indices, (*prim_iter)->index_byte_size, read_only);
+			primitive->set_bone_palette((*prim_iter)->bone_palette);
 
 			if ((*prim_iter)->material_name_id != 0)
 			{
@@ -78,6 +111,41 @@ namespace gef
 			//}
 		}
 
+		if(mesh_cache)
+			mesh_cache->AddMesh(mesh_data, material_data_map, mesh);
+
+		return mesh;
+	}
+
+	Mesh* Scene::CreateMesh(Platform& platform, const SceneFile& scene_file, const SceneFile::Section& section, const bool read_only)
+	{
+		const SceneFile::MeshHeader& mesh_header = scene_file.GetMeshHeader(section);
+
+		Mesh* mesh = new Mesh(platform);
+		mesh->set_aabb(Aabb(mesh_header.aabb_min, mesh_header.aabb_max));
+		mesh->set_bounding_sphere(gef::Sphere(mesh->aabb()));
+
+		// the vertices and indices are passed from the file data without being copied
+		mesh->InitVertexBuffer(platform, scene_file.GetVertices(section), mesh_header.num_vertices, mesh_header.vertex_byte_size, read_only);
+
+		mesh->AllocatePrimitives(mesh_header.primitive_count);
+
+		for (Int32 prim_index = 0; prim_index < mesh_header.primitive_count; ++prim_index)
+		{
+			const SceneFile::PrimitiveHeader& primitive_header = scene_file.GetPrimitiveHeader(section, prim_index);
+			const Int32* bone_palette = scene_file.GetBonePalette(section, prim_index);
+
+			Primitive* primitive = mesh->GetPrimitive(prim_index);
+			primitive->set_type((PrimitiveType)primitive_header.type);
+			primitive->InitIndexBuffer(platform, scene_file.GetIndices(section, prim_index), primitive_header.num_indices, primitive_header.index_byte_size, read_only);
+			primitive->set_bone_palette(std::vector<Int32>(bone_palette, bone_palette + primitive_header.bone_palette_size));
+
+			if (primitive_header.material_name_id != 0)
+			{
+				primitive->set_material(materials_map[primitive_header.material_name_id]);
+			}
+		}
+
 		return mesh;
 	}
 
@@ -91,14 +159,67 @@ namespace gef
 	}
 
 
-	void Scene::CreateMaterials(const Platform& platform)
+	void Scene::CreateMaterials(const Platform& platform, WorkerPool* worker_pool)
 	{
+		// decoding the images is most of the work, so all of them are decoded at once before any texture is created
+		std::vector<std::string> texture_names;
+		GetNewTextureNames(texture_names);
 
-		// go through all the materials and create new textures for them
-//		for(std::map<std::string, std::string>::iterator materialIter = materials_.begin();materialIter!=materials_.end();++materialIter)
+		// textures already in the resource cache are borrowed rather than decoded again
+		if(resource_cache)
+		{
+			std::vector<std::string>::iterator texture_name_iter = texture_names.begin();
+			while(texture_name_iter != texture_names.end())
+			{
+				Texture* texture = resource_cache->FindTexture(texture_name_iter->c_str());
+				if(texture)
+				{
+					string_id_table.Add(*texture_name_iter);
+					textures.push_back(texture);
+					textures_map[gef::GetStringId(*texture_name_iter)] = texture;
+					texture_name_iter = texture_names.erase(texture_name_iter);
+				}
+				else
+				{
+					++texture_name_iter;
+				}
+			}
+		}
+
+		std::vector<ImageData*> images;
+		DecodeImages(texture_names, images, worker_pool);
+
+		// textures are created on this thread in the order the materials use them
+		for(size_t texture_num=0;texture_num<texture_names.size();++texture_num)
+		{
+			string_id_table.Add(texture_names[texture_num]);
+
+			if(images[texture_num] != NULL)
+			{
+				Texture* texture = Texture::Create(platform, *images[texture_num]);
+				textures.push_back(texture);
+				textures_map[gef::GetStringId(texture_names[texture_num])] = texture;
+				if(resource_cache && texture)
+					resource_cache->AddTexture(texture_names[texture_num].c_str(), texture);
+
+				delete images[texture_num];
+				images[texture_num] = NULL;
+			}
+		}
+
+		// go through all the materials and give them their textures
 		for(std::list<MaterialData>::iterator materialIter = material_data.begin();materialIter!=material_data.end();++materialIter)
 		{
-			Material* material = new Material();
+			// a material with the same colour and texture may already have been created by another scene
+			Material* material = resource_cache ? resource_cache->FindMaterial(*materialIter) : NULL;
+			if(material)
+			{
+				materials.push_back(material);
+				materials_map[materialIter->name_id] = material;
+				continue;
+			}
+
+			material = new Material();
 			materials.push_back(material);
 			materials_map[materialIter->name_id] = material;
 
@@ -111,24 +232,64 @@ namespace gef
 			{
 				gef::StringId texture_name_id = gef::GetStringId(materialIter->diffuse_texture);
 				std::map<gef::StringId, Texture*>::iterator find_result = textures_map.find(texture_name_id);
-				if(find_result == textures_map.end())
-				{
-					string_id_table.Add(materialIter->diffuse_texture);
-
-					ImageData image_data{ materialIter->diffuse_texture.c_str() };
-					if(image_data.image() != NULL)
-					{
-						Texture* texture = Texture::Create(platform, image_data);
-						textures.push_back(texture);
-						textures_map[texture_name_id] = texture;
-						material->set_texture(texture);
-					}
-				}
-				else
-				{
+				if(find_result != textures_map.end())
 					material->set_texture(find_result->second);
-				}
 			}
+
+			if(resource_cache)
+				resource_cache->AddMaterial(*materialIter, material);
+		}
+	}
+
+	void Scene::GetNewTextureNames(std::vector<std::string>& texture_names) const
+	{
+		std::set<gef::StringId> texture_name_ids;
+		for(std::list<MaterialData>::const_iterator materialIter = material_data.begin();materialIter!=material_data.end();++materialIter)
+		{
+			if(materialIter->diffuse_texture == "")
+				continue;
+
+			gef::StringId texture_name_id = gef::GetStringId(materialIter->diffuse_texture);
+			if(textures_map.find(texture_name_id) == textures_map.end() && texture_name_ids.insert(texture_name_id).second)
+				texture_names.push_back(materialIter->diffuse_texture);
+		}
+	}
+
+	struct DecodeImagesData
+	{
+		const std::vector<std::string>* filenames;
+		std::vector<ImageData*>* images;
+	};
+
+	static void DecodeImage(void* user_data, const Int32 image_index)
+	{
+		const DecodeImagesData& data = *static_cast<DecodeImagesData*>(user_data);
+		ImageData* image_data = new ImageData((*data.filenames)[image_index].c_str());
+		if(image_data->image() == NULL)
+		{
+			delete image_data;
+			image_data = NULL;
+		}
+		(*data.images)[image_index] = image_data;
+	}
+
+	void Scene::DecodeImages(const std::vector<std::string>& filenames, std::vector<ImageData*>& images, WorkerPool* worker_pool)
+	{
+		images.assign(filenames.size(), NULL);
+
+		DecodeImagesData data;
+		data.filenames = &filenames;
+		data.images = &images;
+
+		// images are taken one at a time as their sizes vary a lot
+		if(worker_pool)
+		{
+			worker_pool->Run((Int32)filenames.size(), DecodeImage, &data);
+		}
+		else
+		{
+			for(Int32 image_num=0;image_num<(Int32)filenames.size();++image_num)
+				DecodeImage(&data, image_num);
 		}
 	}
 
@@ -155,42 +316,36 @@ namespace gef
 	bool Scene::ReadSceneFromFile(const Platform& platform, const char* filename)
 	{
 		bool success = true;
-		void* file_data = NULL;
 		File* file = gef::File::Create();
-		Int32 file_size;
 
 		success = file->Open(filename);
 		if(success)
 		{
-			success = file->GetSize(file_size);
-			if(success)
+			// the file contents are read straight from the mapping rather than copied in to a buffer first
+			const void* file_data = NULL;
+			Int32 file_size = 0;
+			success = file->Map(&file_data, file_size);
+			if(success && SceneFile::IsSceneFile(file_data, file_size))
 			{
-				file_data = malloc(file_size);
-				success = file_data != NULL;
-				if(success)
-				{
-					Int32 bytes_read;
-					success = file->Read(file_data, file_size, bytes_read);
-					if(success)
-						success = bytes_read == file_size;
-				}
-
+				// version 2 files are read from the file data directly
+				SceneFile scene_file;
+				success = scene_file.Open(file_data, file_size);
 				if(success)
-				{
-					gef::MemoryStreamBuffer stream_buffer((char*)file_data, file_size);
-
-					std::istream input_stream(&stream_buffer);
-					success = ReadScene(input_stream);
-
-					// don't need the font file data any more
-					free(file_data);
-					file_data = NULL;
-				}
+					success = ReadScene(scene_file);
+			}
+			else if(success)
+			{
+				gef::MemoryStreamBuffer stream_buffer(file_data, file_size);
 
+				std::istream input_stream(&stream_buffer);
+				success = ReadScene(input_stream);
 			}
 
+			file->Unmap();
 			file->Close();
 		}
+
+		delete file;
 		return success;
 	}
 
@@ -205,6 +360,32 @@ namespace gef
 		Int32 string_count;
 
 		stream.read((char*)&mesh_count, sizeof(Int32));
+
+		// a version 2 file starts with its magic number rather than the mesh count
+		if((UInt32)mesh_count == SceneFile::kMagic)
+		{
+			SceneFile::Header file_header;
+			file_header.magic = SceneFile::kMagic;
+			stream.read((char*)&file_header.version, sizeof(SceneFile::Header) - sizeof(UInt32));
+			if(stream.fail() || file_header.file_size < sizeof(SceneFile::Header))
+				return false;
+
+			UInt8* file_data = (UInt8*)malloc(file_header.file_size);
+			if(file_data == NULL)
+				return false;
+
+			memcpy(file_data, &file_header, sizeof(SceneFile::Header));
+			stream.read((char*)file_data + sizeof(SceneFile::Header), file_header.file_size - sizeof(SceneFile::Header));
+
+			SceneFile scene_file;
+			success = !stream.fail() && scene_file.Open(file_data, file_header.file_size);
+			if(success)
+				success = ReadScene(scene_file);
+
+			free(file_data);
+			return success;
+		}
+
 		stream.read((char*)&material_count, sizeof(Int32));
 		stream.read((char*)&skeleton_count, sizeof(Int32));
 		stream.read((char*)&animation_count, sizeof(Int32));
@@ -279,8 +460,70 @@ namespace gef
 		return success;
 	}
 
-	bool Scene::WriteScene(std::ostream& stream) const
+	bool Scene::ReadScene(const SceneFile& scene_file)
 	{
+		for(Int32 section_num=0;section_num<scene_file.section_count();++section_num)
+		{
+			const SceneFile::Section& section = scene_file.section(section_num);
+			if(!scene_file.VerifySection(section))
+				return false;
+
+			bool success = true;
+			switch(section.type)
+			{
+			case SceneFile::kStringTable:
+				success = scene_file.ReadStringTable(section, string_id_table);
+				break;
+
+			case SceneFile::kMaterial:
+				{
+					material_data.push_back(MaterialData());
+					MaterialData& material = material_data.back();
+					success = scene_file.ReadMaterial(section, material);
+					material_data_map[material.name_id] = &material;
+				}
+				break;
+
+			case SceneFile::kMesh:
+				mesh_data.push_back(MeshData());
+				success = scene_file.ReadMesh(section, mesh_data.back());
+				break;
+
+			case SceneFile::kSkeleton:
+				{
+					Skeleton* skeleton = new Skeleton();
+					skeletons.push_back(skeleton);
+					success = scene_file.ReadSkeleton(section, *skeleton);
+				}
+				break;
+
+			case SceneFile::kAnimation:
+				{
+					Animation* animation = new Animation();
+					success = scene_file.ReadAnimation(section, *animation);
+					if(animations.find(animation->name_id()) != animations.end())
+						delete animations[animation->name_id()];
+					animations[animation->name_id()] = animation;
+				}
+				break;
+
+			default:
+				// sections added by later versions are skipped
+				break;
+			}
+
+			if(!success)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool Scene::WriteScene(std::ostream& stream, const UInt32 version) const
+	{
+		if(version == SceneFile::kVersion)
+			return SceneFile::Write(stream, *this);
+
 		bool success = true;
 
 		Int32 mesh_count = (Int32)mesh_data.size();
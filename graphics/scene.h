@@ -4,9 +4,12 @@
 #include <list>
 #include <system/string_id.h>
 #include <graphics/mesh_data.h>
+#include <graphics/scene_file.h>
 #include <ostream>
 #include <istream>
 #include <map>
+#include <vector>
+#include <string>
 
 namespace gef
 {
@@ -15,21 +18,51 @@ namespace gef
 	class Animation;
 	class Platform;
 	class Material;
+	class ImageData;
+	class ResourceCache;
+	class WorkerPool;
 
 	class Scene
 	{
 	public:
+		Scene();
 		~Scene();
 
+		/// @note If resource_cache is set and the mesh is read only, the mesh is shared through the cache and must be released with ResourceCache::ReleaseMesh rather than deleted.
 		Mesh* CreateMesh(Platform& platform, const MeshData& mesh_data, const bool read_only = true);
+
+		/// @brief Creates a mesh straight from the vertices and indices of a mesh section of a version 2 scene file,
+		/// without reading it in to MeshData first. The section must be verified first.
+		Mesh* CreateMesh(Platform& platform, const SceneFile& scene_file, const SceneFile::Section& section, const bool read_only = true);
 		void CreateMeshes(Platform& platform, const bool read_only = true);
-		void CreateMaterials(const Platform& platform);
+
+		/// @brief Creates the materials, and a texture for each distinct diffuse texture that isn't already in textures_map.
+		/// The images are decoded first, then the textures are created in order on the calling thread.
+		/// If resource_cache is set, textures and materials already in it are used rather than being created again.
+		/// @param[in] worker_pool		If not NULL, the images are decoded by its workers as well as the calling thread.
+		void CreateMaterials(const Platform& platform, WorkerPool* worker_pool = NULL);
+
+		/// @brief Gets the distinct diffuse textures of the materials that aren't already in textures_map, in the order they're first used.
+		void GetNewTextureNames(std::vector<std::string>& texture_names) const;
+
+		/// @brief Decodes image files, on several threads at once if given a worker pool.
+		/// @param[in] filenames		The image files.
+		/// @param[out] images			Receives an image for each file, or NULL if the file couldn't be decoded. The caller must delete them.
+		/// @param[in] worker_pool		If not NULL, the images are decoded by its workers as well as the calling thread.
+		static void DecodeImages(const std::vector<std::string>& filenames, std::vector<ImageData*>& images, WorkerPool* worker_pool);
 
 		bool WriteSceneToFile(const Platform& platform, const char* filename) const;
 		bool ReadSceneFromFile(const Platform& platform, const char* filename);
 
+		/// @brief Reads a version 1 or version 2 scene.
 		bool ReadScene(std::istream& Stream);
-		bool WriteScene(std::ostream& Stream) const;
+
+		/// @brief Verifies and reads every section of a version 2 scene file.
+		bool ReadScene(const SceneFile& scene_file);
+
+		/// @brief Writes the scene.
+		/// @param[in] version	1 for the original format, which is read from start to end, or SceneFile::kVersion.
+		bool WriteScene(std::ostream& Stream, const UInt32 version = SceneFile::kVersion) const;
 //		void WriteStringTable(std::istream& Stream) const;
 //		void ReadStringTable(std::istream& Stream);
 
@@ -52,6 +85,10 @@ namespace gef
 		std::map<gef::StringId, Texture*> textures_map;
 
 		std::vector<gef::StringId> skin_cluster_name_ids;
+
+		/// If not NULL, the textures, materials and meshes are borrowed from this cache and released back to it when the scene is
+		/// deleted, so they're shared with other scenes. Must be set before they're created.
+		ResourceCache* resource_cache;
 	};
 }
 
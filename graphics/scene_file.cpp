@@ -0,0 +1,361 @@
+#include <graphics/scene_file.h>
+#include <graphics/scene.h>
+#include <graphics/mesh_data.h>
+#include <animation/skeleton.h>
+#include <animation/animation.h>
+#include <system/crc.h>
+#include <system/memory_stream_buffer.h>
+#include <sstream>
+#include <istream>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+
+namespace gef
+{
+	static UInt32 Align16(const UInt32 size)
+	{
+		return (size + 15) & ~15u;
+	}
+
+	// true if [offset, offset+size) is inside a block of block_size bytes, without overflowing
+	static bool IsInside(const UInt64 offset, const UInt64 size, const UInt64 block_size)
+	{
+		return offset <= block_size && size <= block_size - offset;
+	}
+
+	static std::string WriteMeshSection(const MeshData& mesh)
+	{
+		const Int32 primitive_count = (Int32)mesh.primitives.size();
+
+		SceneFile::MeshHeader mesh_header;
+		memset(mesh_header.reserved, 0, sizeof(mesh_header.reserved));
+		mesh_header.name_id = mesh.name_id;
+		mesh_header.primitive_count = primitive_count;
+		mesh_header.num_vertices = mesh.vertex_data.num_vertices;
+		mesh_header.vertex_byte_size = mesh.vertex_data.vertex_byte_size;
+		mesh_header.aabb_min = mesh.aabb.min_vtx();
+		mesh_header.aabb_max = mesh.aabb.max_vtx();
+
+		// the headers are multiples of 16 bytes, so the arrays that follow them start aligned
+		UInt32 offset = sizeof(SceneFile::MeshHeader) + primitive_count*sizeof(SceneFile::PrimitiveHeader);
+		mesh_header.vertices_offset = offset;
+		offset += Align16(mesh.vertex_data.num_vertices*mesh.vertex_data.vertex_byte_size);
+
+		std::vector<SceneFile::PrimitiveHeader> primitive_headers(primitive_count);
+		for (Int32 primitive_num = 0; primitive_num < primitive_count; ++primitive_num)
+		{
+			const PrimitiveData& primitive = *mesh.primitives[primitive_num];
+			SceneFile::PrimitiveHeader& primitive_header = primitive_headers[primitive_num];
+			memset(&primitive_header, 0, sizeof(primitive_header));
+			primitive_header.material_name_id = primitive.material_name_id;
+			primitive_header.type = primitive.type;
+			primitive_header.num_indices = primitive.num_indices;
+			primitive_header.index_byte_size = primitive.index_byte_size;
+			primitive_header.indices_offset = offset;
+			offset += Align16(primitive.num_indices*primitive.index_byte_size);
+			primitive_header.bone_palette_size = (Int32)primitive.bone_palette.size();
+			primitive_header.bone_palette_offset = offset;
+			offset += Align16((UInt32)(primitive.bone_palette.size()*sizeof(Int32)));
+		}
+
+		std::string section_data(offset, '\0');
+		char* data = &section_data[0];
+		memcpy(data, &mesh_header, sizeof(mesh_header));
+		if (primitive_count > 0)
+			memcpy(data + sizeof(mesh_header), &primitive_headers[0], primitive_count*sizeof(SceneFile::PrimitiveHeader));
+		if (mesh.vertex_data.vertices)
+			memcpy(data + mesh_header.vertices_offset, mesh.vertex_data.vertices, mesh.vertex_data.num_vertices*mesh.vertex_data.vertex_byte_size);
+
+		for (Int32 primitive_num = 0; primitive_num < primitive_count; ++primitive_num)
+		{
+			const PrimitiveData& primitive = *mesh.primitives[primitive_num];
+			if (primitive.indices)
+				memcpy(data + primitive_headers[primitive_num].indices_offset, primitive.indices, primitive.num_indices*primitive.index_byte_size);
+			if (!primitive.bone_palette.empty())
+				memcpy(data + primitive_headers[primitive_num].bone_palette_offset, &primitive.bone_palette[0], primitive.bone_palette.size()*sizeof(Int32));
+		}
+
+		return section_data;
+	}
+
+	SceneFile::SceneFile() :
+		data_(NULL),
+		size_(0),
+		sections_(NULL)
+	{
+	}
+
+	bool SceneFile::IsSceneFile(const void* data, const UInt32 size)
+	{
+		return data && size >= sizeof(Header) && static_cast<const Header*>(data)->magic == kMagic;
+	}
+
+	bool SceneFile::Open(const void* data, const UInt32 size)
+	{
+		data_ = NULL;
+		size_ = 0;
+		sections_ = NULL;
+
+		if (!IsSceneFile(data, size))
+			return false;
+
+		const Header& file_header = *static_cast<const Header*>(data);
+		if (file_header.version != kVersion || file_header.file_size > size)
+			return false;
+
+		const UInt8* file_data = static_cast<const UInt8*>(data);
+		const UInt64 directory_size = (UInt64)file_header.section_count*sizeof(Section);
+		if (!IsInside(file_header.directory_offset, directory_size, file_header.file_size) || (file_header.directory_offset & 3) != 0)
+			return false;
+
+		if (CRC::GetCRC(file_data + file_header.directory_offset, (UInt32)directory_size) != file_header.directory_checksum)
+			return false;
+
+		const Section* sections = reinterpret_cast<const Section*>(file_data + file_header.directory_offset);
+		for (UInt32 section_num = 0; section_num < file_header.section_count; ++section_num)
+		{
+			const Section& file_section = sections[section_num];
+			if ((file_section.offset & 15) != 0 || !IsInside(file_section.offset, file_section.size, file_header.file_size))
+				return false;
+		}
+
+		data_ = file_data;
+		size_ = file_header.file_size;
+		sections_ = sections;
+		return true;
+	}
+
+	const SceneFile::Section* SceneFile::FindSection(const UInt32 type, const StringId name_id) const
+	{
+		for (Int32 section_num = 0; section_num < section_count(); ++section_num)
+		{
+			if (sections_[section_num].type == type && sections_[section_num].name_id == name_id)
+				return &sections_[section_num];
+		}
+
+		return NULL;
+	}
+
+	bool SceneFile::VerifySection(const Section& section) const
+	{
+		if (CRC::GetCRC(GetSectionData(section), section.size) != section.checksum)
+			return false;
+
+		// the mesh arrays are used in place, so their offsets are checked as well
+		if (section.type == kMesh)
+			return CheckMeshSection(section);
+
+		return true;
+	}
+
+	bool SceneFile::CheckMeshSection(const Section& section) const
+	{
+		if (section.size < sizeof(MeshHeader))
+			return false;
+
+		const MeshHeader& mesh_header = GetMeshHeader(section);
+		if (mesh_header.primitive_count < 0 || mesh_header.num_vertices < 0 || mesh_header.vertex_byte_size < 0)
+			return false;
+		if (!IsInside(sizeof(MeshHeader), (UInt64)mesh_header.primitive_count*sizeof(PrimitiveHeader), section.size))
+			return false;
+		if ((mesh_header.vertices_offset & 15) != 0 || !IsInside(mesh_header.vertices_offset, (UInt64)mesh_header.num_vertices*mesh_header.vertex_byte_size, section.size))
+			return false;
+
+		for (Int32 primitive_num = 0; primitive_num < mesh_header.primitive_count; ++primitive_num)
+		{
+			const PrimitiveHeader& primitive_header = GetPrimitiveHeader(section, primitive_num);
+			if (primitive_header.num_indices < 0 || primitive_header.index_byte_size < 0 || primitive_header.bone_palette_size < 0)
+				return false;
+			if ((primitive_header.indices_offset & 15) != 0 || !IsInside(primitive_header.indices_offset, (UInt64)primitive_header.num_indices*primitive_header.index_byte_size, section.size))
+				return false;
+			if ((primitive_header.bone_palette_offset & 3) != 0 || !IsInside(primitive_header.bone_palette_offset, (UInt64)primitive_header.bone_palette_size*sizeof(Int32), section.size))
+				return false;
+		}
+
+		return true;
+	}
+
+	bool SceneFile::ReadStringTable(const Section& section, StringIdTable& string_id_table) const
+	{
+		const char* strings = reinterpret_cast<const char*>(GetSectionData(section));
+		const char* strings_end = strings + section.size;
+
+		// each string is terminated by a zero
+		while (strings < strings_end)
+		{
+			const char* string_end = static_cast<const char*>(memchr(strings, 0, strings_end - strings));
+			if (!string_end)
+				return false;
+
+			string_id_table.Add(std::string(strings, string_end));
+			strings = string_end + 1;
+		}
+
+		return true;
+	}
+
+	bool SceneFile::ReadMaterial(const Section& section, MaterialData& material_data) const
+	{
+		MemoryStreamBuffer stream_buffer(GetSectionData(section), section.size);
+		std::istream stream(&stream_buffer);
+		return material_data.Read(stream) && !stream.fail();
+	}
+
+	bool SceneFile::ReadMesh(const Section& section, MeshData& mesh_data) const
+	{
+		if (!CheckMeshSection(section))
+			return false;
+
+		const MeshHeader& mesh_header = GetMeshHeader(section);
+		mesh_data.name_id = mesh_header.name_id;
+		mesh_data.aabb.set_min_vtx(mesh_header.aabb_min);
+		mesh_data.aabb.set_max_vtx(mesh_header.aabb_max);
+
+		const UInt32 vertices_size = mesh_header.num_vertices*mesh_header.vertex_byte_size;
+		mesh_data.vertex_data.num_vertices = mesh_header.num_vertices;
+		mesh_data.vertex_data.vertex_byte_size = mesh_header.vertex_byte_size;
+		mesh_data.vertex_data.vertices = malloc(vertices_size);
+		if (!mesh_data.vertex_data.vertices)
+			return false;
+		memcpy(mesh_data.vertex_data.vertices, GetVertices(section), vertices_size);
+
+		for (Int32 primitive_num = 0; primitive_num < mesh_header.primitive_count; ++primitive_num)
+		{
+			const PrimitiveHeader& primitive_header = GetPrimitiveHeader(section, primitive_num);
+
+			PrimitiveData* primitive = new PrimitiveData();
+			mesh_data.primitives.push_back(primitive);
+			primitive->material_name_id = primitive_header.material_name_id;
+			primitive->type = (PrimitiveType)primitive_header.type;
+			primitive->num_indices = primitive_header.num_indices;
+			primitive->index_byte_size = primitive_header.index_byte_size;
+
+			const UInt32 indices_size = primitive_header.num_indices*primitive_header.index_byte_size;
+			primitive->indices = malloc(indices_size);
+			if (!primitive->indices)
+				return false;
+			memcpy(primitive->indices, GetIndices(section, primitive_num), indices_size);
+
+			const Int32* bone_palette = GetBonePalette(section, primitive_num);
+			primitive->bone_palette.assign(bone_palette, bone_palette + primitive_header.bone_palette_size);
+		}
+
+		return true;
+	}
+
+	bool SceneFile::ReadSkeleton(const Section& section, Skeleton& skeleton) const
+	{
+		MemoryStreamBuffer stream_buffer(GetSectionData(section), section.size);
+		std::istream stream(&stream_buffer);
+		return skeleton.Read(stream) && !stream.fail();
+	}
+
+	bool SceneFile::ReadAnimation(const Section& section, Animation& animation) const
+	{
+		MemoryStreamBuffer stream_buffer(GetSectionData(section), section.size);
+		std::istream stream(&stream_buffer);
+		return animation.Read(stream) && !stream.fail();
+	}
+
+	bool SceneFile::Write(std::ostream& stream, const Scene& scene)
+	{
+		std::vector<Section> sections;
+		std::vector<std::string> section_data;
+
+		Section new_section;
+		memset(&new_section, 0, sizeof(new_section));
+
+		// string table
+		{
+			std::string strings;
+			for (std::map<StringId, std::string>::const_iterator string_iter = scene.string_id_table.table().begin(); string_iter != scene.string_id_table.table().end(); ++string_iter)
+				strings.append(string_iter->second.c_str(), string_iter->second.length()+1);
+
+			new_section.type = kStringTable;
+			new_section.name_id = 0;
+			sections.push_back(new_section);
+			section_data.push_back(strings);
+		}
+
+		// materials, skeletons and animations are written as they are in version 1 files
+		for (std::list<MaterialData>::const_iterator material_iter = scene.material_data.begin(); material_iter != scene.material_data.end(); ++material_iter)
+		{
+			std::ostringstream material_stream;
+			material_iter->Write(material_stream);
+
+			new_section.type = kMaterial;
+			new_section.name_id = material_iter->name_id;
+			sections.push_back(new_section);
+			section_data.push_back(material_stream.str());
+		}
+
+		for (std::list<MeshData>::const_iterator mesh_iter = scene.mesh_data.begin(); mesh_iter != scene.mesh_data.end(); ++mesh_iter)
+		{
+			new_section.type = kMesh;
+			new_section.name_id = mesh_iter->name_id;
+			sections.push_back(new_section);
+			section_data.push_back(WriteMeshSection(*mesh_iter));
+		}
+
+		for (std::list<Skeleton*>::const_iterator skeleton_iter = scene.skeletons.begin(); skeleton_iter != scene.skeletons.end(); ++skeleton_iter)
+		{
+			std::ostringstream skeleton_stream;
+			(*skeleton_iter)->Write(skeleton_stream);
+
+			new_section.type = kSkeleton;
+			new_section.name_id = 0;
+			sections.push_back(new_section);
+			section_data.push_back(skeleton_stream.str());
+		}
+
+		for (std::map<StringId, Animation*>::const_iterator animation_iter = scene.animations.begin(); animation_iter != scene.animations.end(); ++animation_iter)
+		{
+			std::ostringstream animation_stream;
+			animation_iter->second->Write(animation_stream);
+
+			new_section.type = kAnimation;
+			new_section.name_id = animation_iter->second->name_id();
+			sections.push_back(new_section);
+			section_data.push_back(animation_stream.str());
+		}
+
+		// lay out the sections after the header and directory
+		const UInt32 section_count = (UInt32)sections.size();
+		UInt32 offset = Align16(sizeof(Header) + section_count*sizeof(Section));
+		for (UInt32 section_num = 0; section_num < section_count; ++section_num)
+		{
+			Section& file_section = sections[section_num];
+			file_section.offset = offset;
+			file_section.size = (UInt32)section_data[section_num].size();
+			file_section.checksum = CRC::GetCRC(section_data[section_num].data(), file_section.size);
+			offset += Align16(file_section.size);
+		}
+
+		Header file_header;
+		memset(&file_header, 0, sizeof(file_header));
+		file_header.magic = kMagic;
+		file_header.version = kVersion;
+		file_header.file_size = offset;
+		file_header.section_count = section_count;
+		file_header.directory_offset = sizeof(Header);
+		file_header.directory_checksum = section_count > 0 ? CRC::GetCRC(&sections[0], section_count*sizeof(Section)) : CRC::GetCRC(NULL, 0);
+
+		stream.write((const char*)&file_header, sizeof(file_header));
+		if (section_count > 0)
+			stream.write((const char*)&sections[0], section_count*sizeof(Section));
+
+		const char padding[16] = { 0 };
+		UInt32 position = sizeof(Header) + section_count*sizeof(Section);
+		for (UInt32 section_num = 0; section_num < section_count; ++section_num)
+		{
+			stream.write(padding, sections[section_num].offset - position);
+			stream.write(section_data[section_num].data(), section_data[section_num].size());
+			position = sections[section_num].offset + sections[section_num].size;
+		}
+		stream.write(padding, offset - position);
+
+		return !stream.fail();
+	}
+}
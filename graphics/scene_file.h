@@ -0,0 +1,154 @@
+#ifndef _GEF_SCENE_FILE_H
+#define _GEF_SCENE_FILE_H
+
+#include <gef.h>
+#include <system/string_id.h>
+#include <maths/vector4.h>
+#include <ostream>
+
+namespace gef
+{
+	// forward declarations
+	class Scene;
+	class Skeleton;
+	class Animation;
+	struct MeshData;
+	struct MaterialData;
+
+	/**
+	Reads version 2 scene files from memory.
+	A version 2 file starts with a Header, followed by a directory of Sections giving the offset, size and checksum of
+	each string table, material, mesh, skeleton and animation. Every section starts on a 16 byte boundary, so one mesh or
+	animation can be found and read without reading anything before it. In mesh sections the vertex and index arrays are
+	16 byte aligned as well, so they can be passed straight from the file data to the GPU without being copied.
+	The file data isn't copied, so it must be kept for as long as the SceneFile and anything taken from it in place is used.
+	*/
+	class SceneFile
+	{
+	public:
+		/// "GSCN" read as a little endian UInt32. Version 1 files start with the mesh count, which is never this large.
+		static const UInt32 kMagic = 0x4e435347;
+		static const UInt32 kVersion = 2;
+
+		enum SectionType
+		{
+			kStringTable = 0,
+			kMaterial,
+			kMesh,
+			kSkeleton,
+			kAnimation
+		};
+
+		struct Header
+		{
+			UInt32 magic;
+			UInt32 version;
+			UInt32 file_size;
+			UInt32 section_count;
+
+			/// The offset of the section directory from the start of the file, and the CRC of the directory.
+			UInt32 directory_offset;
+			UInt32 directory_checksum;
+			UInt32 reserved[2];
+		};
+
+		struct Section
+		{
+			/// A SectionType.
+			UInt32 type;
+
+			/// The name of the material, mesh or animation. Zero for the string table and skeletons.
+			StringId name_id;
+
+			/// The offset from the start of the file, the size in bytes and the CRC of the section data.
+			UInt32 offset;
+			UInt32 size;
+			UInt32 checksum;
+			UInt32 reserved[3];
+		};
+
+		/// The start of a mesh section. The primitive headers follow it.
+		struct MeshHeader
+		{
+			StringId name_id;
+			Int32 primitive_count;
+			Int32 num_vertices;
+			Int32 vertex_byte_size;
+			Vector4 aabb_min;
+			Vector4 aabb_max;
+
+			/// The offset of the vertices from the start of the section.
+			UInt32 vertices_offset;
+			UInt32 reserved[3];
+		};
+
+		struct PrimitiveHeader
+		{
+			StringId material_name_id;
+			Int32 type;
+			Int32 num_indices;
+			Int32 index_byte_size;
+
+			/// The offsets of the indices and the bone palette from the start of the section. The bone palette is an array of Int32.
+			UInt32 indices_offset;
+			UInt32 bone_palette_offset;
+			Int32 bone_palette_size;
+			UInt32 reserved;
+		};
+
+		SceneFile();
+
+		/// @brief Checks the header and section directory of a version 2 scene file. The section data isn't checked until it's read.
+		/// @param[in] data		The file data. Must be 16 byte aligned for arrays taken from it in place to be aligned.
+		/// @param[in] size		The size of the file data in bytes.
+		/// @return false if the data isn't a valid version 2 scene file.
+		bool Open(const void* data, const UInt32 size);
+
+		/// @brief Checks whether data starts with the header of a version 2 scene file, e.g. to choose between this and Scene::ReadScene.
+		static bool IsSceneFile(const void* data, const UInt32 size);
+
+		/// @brief Finds a section.
+		/// @param[in] type		The SectionType.
+		/// @param[in] name_id	The name of the material, mesh or animation.
+		/// @return The first section of the type with the name, or NULL if there isn't one.
+		const Section* FindSection(const UInt32 type, const StringId name_id) const;
+
+		/// @brief Checks the CRC of a section's data.
+		bool VerifySection(const Section& section) const;
+
+		/// @brief Get the data of a section in place.
+		inline const UInt8* GetSectionData(const Section& section) const { return data_ + section.offset; }
+
+		/// @brief Reads the strings in a string table section in to a table. The section must be verified first.
+		bool ReadStringTable(const Section& section, StringIdTable& string_id_table) const;
+
+		/// @brief Reads a section, copying its data. The section must be verified first.
+		bool ReadMaterial(const Section& section, MaterialData& material_data) const;
+		bool ReadMesh(const Section& section, MeshData& mesh_data) const;
+		bool ReadSkeleton(const Section& section, Skeleton& skeleton) const;
+		bool ReadAnimation(const Section& section, Animation& animation) const;
+
+		/// @brief Get the header of a mesh section, for using its arrays in place. The section must be verified first.
+		inline const MeshHeader& GetMeshHeader(const Section& section) const { return *reinterpret_cast<const MeshHeader*>(GetSectionData(section)); }
+		inline const PrimitiveHeader& GetPrimitiveHeader(const Section& section, const Int32 primitive_index) const { return reinterpret_cast<const PrimitiveHeader*>(GetSectionData(section) + sizeof(MeshHeader))[primitive_index]; }
+		inline const void* GetVertices(const Section& section) const { return GetSectionData(section) + GetMeshHeader(section).vertices_offset; }
+		inline const void* GetIndices(const Section& section, const Int32 primitive_index) const { return GetSectionData(section) + GetPrimitiveHeader(section, primitive_index).indices_offset; }
+		inline const Int32* GetBonePalette(const Section& section, const Int32 primitive_index) const { return reinterpret_cast<const Int32*>(GetSectionData(section) + GetPrimitiveHeader(section, primitive_index).bone_palette_offset); }
+
+		/// @brief Writes the contents of a scene as a version 2 file.
+		static bool Write(std::ostream& stream, const Scene& scene);
+
+		inline const Header& header() const { return *reinterpret_cast<const Header*>(data_); }
+		inline Int32 section_count() const { return data_ ? (Int32)header().section_count : 0; }
+		inline const Section& section(const Int32 index) const { return sections_[index]; }
+
+	private:
+		bool CheckMeshSection(const Section& section) const;
+
+		const UInt8* data_;
+		UInt32 size_;
+		const Section* sections_;
+	};
+}
+
+#endif // _GEF_SCENE_FILE_H
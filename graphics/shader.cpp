@@ -51,6 +51,10 @@ namespace gef
 
 	}
 
+	void Shader::SetPrimitiveData(const gef::Primitive& /*primitive*/)
+	{
+	}
+
 
 	bool Shader::LoadShader(const char* filename, const char* base_filepath, char** shader_source, Int32& shader_source_length, const Platform& platform)
 	{
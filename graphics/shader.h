@@ -25,6 +25,9 @@ namespace gef
 		virtual void SetMeshData(const gef::Matrix44& transform);
 		virtual void SetMaterialData(const gef::Material* material);
 
+		/// @brief Called for each primitive before it's drawn, after SetMaterialData.
+		virtual void SetPrimitiveData(const gef::Primitive& primitive);
+
 		inline ShaderInterface* device_interface() { return device_interface_; }
 	protected:
 		bool LoadShader(const char* filename, const char* base_filepath, char** shader_source, Int32& shader_source_length, const Platform& platform);
@@ -15,6 +15,7 @@ namespace gef
 #if 1
         :	vertex_shader_variable_data_(NULL),
 			vertex_shader_variable_data_size_(0),
+			vertex_shader_variable_upload_size_(0),
 			pixel_shader_variable_data_(NULL),
 			pixel_shader_variable_data_size_(0),
 			vertex_size_(0),
@@ -92,6 +93,20 @@ namespace gef
 	}
 
 
+	void ShaderInterface::LimitVertexShaderVariableUpload(Int32 variable_index, Int32 variable_count)
+	{
+		if (variable_count == -1)
+		{
+			vertex_shader_variable_upload_size_ = vertex_shader_variable_data_size_;
+		}
+		else
+		{
+			const ShaderVariable& shader_variable = vertex_shader_variables_[variable_index];
+			const Int32 upload_size = shader_variable.byte_offset + RoundUpToNearest(GetTypeSize(shader_variable.type), 16)*variable_count;
+			vertex_shader_variable_upload_size_ = upload_size < vertex_shader_variable_data_size_ ? upload_size : vertex_shader_variable_data_size_;
+		}
+	}
+
 	void ShaderInterface::AddVertexParameter(const char* parameter_name, VariableType parameter_type, Int32 parameter_byte_offset, const char* semantic_name, int semantic_index)
 	{
 		ShaderParameter shader_parameter;
@@ -147,6 +162,7 @@ namespace gef
 	void ShaderInterface::AllocateVariableData()
 	{
 		vertex_shader_variable_data_ = AllocateVariableData(vertex_shader_variables_, vertex_shader_variable_data_size_);
+		vertex_shader_variable_upload_size_ = vertex_shader_variable_data_size_;
 		pixel_shader_variable_data_ = AllocateVariableData(pixel_shader_variables_, pixel_shader_variable_data_size_);
 	}
 
@@ -68,6 +68,12 @@ namespace gef
 
 		Int32 AddVertexShaderVariable(const char* variable_name, VariableType variable_type, Int32 variable_count = 1);
 		void SetVertexShaderVariable(Int32 variable_index, const void* value, Int32 variable_count = -1);
+
+		/// @brief Limits the vertex shader variable data copied to the GPU by SetVariableData to the end of the first
+		/// elements of an array variable, e.g. the bone matrices actually used by a mesh. Only useful for the last variable.
+		/// @param[in] variable_index	The variable.
+		/// @param[in] variable_count	The number of elements to copy, or -1 to copy all the variable data again.
+		void LimitVertexShaderVariableUpload(Int32 variable_index, Int32 variable_count);
 		Int32 AddPixelShaderVariable(const char* variable_name, VariableType variable_type, Int32 variable_count = 1);
 		void SetPixelShaderVariable(Int32 variable_index, const void* value);
 
@@ -106,6 +112,7 @@ namespace gef
         std::vector<TextureSampler> texture_samplers_;
 		UInt8* vertex_shader_variable_data_;
 		Int32 vertex_shader_variable_data_size_;
+		Int32 vertex_shader_variable_upload_size_;
 		UInt8* pixel_shader_variable_data_;
 		Int32 pixel_shader_variable_data_size_;
 		Int32 vertex_size_;
@@ -6,6 +6,11 @@ namespace gef
 	{
 		bind_pose_.CreateBindPose(&skeleton);
 		bone_matrices_.resize(skeleton.joints().size());
+		bone_dual_quaternions_.resize(skeleton.joints().size());
+
+		inv_bind_poses_.reserve(skeleton.joints().size());
+		for (std::vector<gef::Joint>::const_iterator joint_iter = skeleton.joints().begin(); joint_iter != skeleton.joints().end(); ++joint_iter)
+			inv_bind_poses_.push_back(joint_iter->inv_bind_pose);
 	}
 
 	SkinnedMeshInstance::~SkinnedMeshInstance()
@@ -17,11 +22,14 @@ namespace gef
 	{
 		// calculate bone matrices that need to be passed to the shader
 		// this should be the final pose if multiple animations are blended together
-		std::vector<gef::Matrix44>::const_iterator pose_matrix_iter = pose.global_pose().begin();
-		std::vector<gef::Joint>::const_iterator joint_iter = bind_pose_.skeleton()->joints().begin();
+		if (!bone_matrices_.empty())
+			gef::Matrix44::MultiplyArray(&bone_matrices_[0], &inv_bind_poses_[0], &pose.global_pose()[0], (Int32)bone_matrices_.size());
+	}
 
-		for (std::vector<gef::Matrix44>::iterator bone_matrix_iter = bone_matrices_.begin(); bone_matrix_iter != bone_matrices_.end(); ++bone_matrix_iter, ++joint_iter, ++pose_matrix_iter)
-			*bone_matrix_iter = (joint_iter->inv_bind_pose * *pose_matrix_iter);
+	void SkinnedMeshInstance::UpdateBoneDualQuaternions()
+	{
+		if (!bone_matrices_.empty())
+			gef::DualQuaternion::SetFromMatrixArray(&bone_dual_quaternions_[0], &bone_matrices_[0], (Int32)bone_matrices_.size());
 	}
 
 }
@@ -3,6 +3,7 @@
 
 #include <graphics/mesh_instance.h>
 #include <animation/skeleton.h>
+#include <maths/dual_quaternion.h>
 
 #include <vector>
 
@@ -16,10 +17,17 @@ namespace gef
 
 		void UpdateBoneMatrices(const gef::SkeletonPose& pose);
 
+		/// @brief Converts the bone matrices from the last UpdateBoneMatrices to dual quaternions.
+		/// Each bone takes 8 floats rather than 16, and any scale in the bone matrices is lost.
+		void UpdateBoneDualQuaternions();
+
 		inline std::vector<gef::Matrix44>& bone_matrices() { return bone_matrices_; }
+		inline const std::vector<gef::DualQuaternion>& bone_dual_quaternions() const { return bone_dual_quaternions_; }
 		inline const gef::SkeletonPose& bind_pose() const { return bind_pose_; }
 	protected:
 		std::vector<gef::Matrix44> bone_matrices_;
+		std::vector<gef::DualQuaternion> bone_dual_quaternions_;
+		std::vector<gef::Matrix44> inv_bind_poses_;	// copy of the skeleton's inverse bind poses kept contiguous for Matrix44::MultiplyArray
 		gef::SkeletonPose bind_pose_;
 	};
 
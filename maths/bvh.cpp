@@ -0,0 +1,410 @@
+#include <maths/bvh.h>
+#include <maths/frustum.h>
+#include <maths/sphere.h>
+#include <algorithm>
+#include <cfloat>
+
+namespace gef
+{
+	// number of bins the centroids are sorted in to along each axis when looking for a split
+	static const Int32 kNumSplitBins = 12;
+
+	static const Aabb MergeAabbs(const Aabb& a, const Aabb& b)
+	{
+		const Vector4& a_min = a.min_vtx();
+		const Vector4& a_max = a.max_vtx();
+		const Vector4& b_min = b.min_vtx();
+		const Vector4& b_max = b.max_vtx();
+
+		return Aabb(
+			Vector4(std::min(a_min.x(), b_min.x()), std::min(a_min.y(), b_min.y()), std::min(a_min.z(), b_min.z())),
+			Vector4(std::max(a_max.x(), b_max.x()), std::max(a_max.y(), b_max.y()), std::max(a_max.z(), b_max.z())));
+	}
+
+	// half the surface area, which is all the surface area heuristic needs
+	static float HalfSurfaceArea(const Aabb& aabb)
+	{
+		const Vector4 size = aabb.max_vtx() - aabb.min_vtx();
+		if (size.x() < 0.0f || size.y() < 0.0f || size.z() < 0.0f)
+			return 0.0f;
+
+		return size.x()*size.y() + size.y()*size.z() + size.z()*size.x();
+	}
+
+	static bool AabbsOverlap(const Aabb& a, const Aabb& b)
+	{
+		return a.min_vtx().x() <= b.max_vtx().x() && a.max_vtx().x() >= b.min_vtx().x()
+			&& a.min_vtx().y() <= b.max_vtx().y() && a.max_vtx().y() >= b.min_vtx().y()
+			&& a.min_vtx().z() <= b.max_vtx().z() && a.max_vtx().z() >= b.min_vtx().z();
+	}
+
+	static bool SphereOverlapsAabb(const Vector4& centre, const float radius_sqr, const Aabb& aabb)
+	{
+		float distance_sqr = 0.0f;
+		for (Int32 axis = 0; axis < 3; ++axis)
+		{
+			const float value = centre[axis];
+			float delta = 0.0f;
+			if (value < aabb.min_vtx()[axis])
+				delta = aabb.min_vtx()[axis] - value;
+			else if (value > aabb.max_vtx()[axis])
+				delta = value - aabb.max_vtx()[axis];
+			distance_sqr += delta*delta;
+		}
+
+		return distance_sqr <= radius_sqr;
+	}
+
+	Bvh::Bvh()
+	{
+	}
+
+	void Bvh::Build(const Aabb* aabbs, const Int32 count)
+	{
+		nodes_.clear();
+		object_indices_.resize(count);
+		object_leaves_.resize(count);
+		object_bounds_.assign(aabbs, aabbs + count);
+
+		if (count == 0)
+			return;
+
+		std::vector<Vector4> centroids(count);
+		for (Int32 object_num = 0; object_num < count; ++object_num)
+		{
+			object_indices_[object_num] = object_num;
+			centroids[object_num] = (aabbs[object_num].min_vtx() + aabbs[object_num].max_vtx()) * 0.5f;
+		}
+
+		// a binary tree with at least one object per leaf never needs more than this
+		nodes_.reserve(2 * count - 1);
+		nodes_.push_back(Node());
+		BuildNode(0, centroids, 0, count, -1, 0);
+	}
+
+	void Bvh::BuildNode(const Int32 node_index, const std::vector<Vector4>& centroids, const Int32 first_object, const Int32 object_count, const Int32 parent, const Int32 depth)
+	{
+		{
+			Node& node = nodes_[node_index];
+			node.first_child = -1;
+			node.parent = parent;
+			node.first_object = first_object;
+			node.object_count = object_count;
+			CalculateNodeBounds(node);
+		}
+
+		Int32* const objects = &object_indices_[first_object];
+
+		bool make_leaf = object_count <= 1 || depth >= kMaxDepth;
+
+		// find the split with the lowest surface area heuristic cost
+		Int32 best_axis = -1;
+		Int32 best_split = 0;
+		float best_cost = FLT_MAX;
+		Vector4 centroid_min(FLT_MAX, FLT_MAX, FLT_MAX);
+		Vector4 centroid_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		float bin_scale[3] = { 0.0f, 0.0f, 0.0f };
+
+		if (!make_leaf)
+		{
+			Aabb centroid_bounds;
+			for (Int32 object_num = 0; object_num < object_count; ++object_num)
+				centroid_bounds.Update(centroids[objects[object_num]]);
+			centroid_min = centroid_bounds.min_vtx();
+			centroid_max = centroid_bounds.max_vtx();
+
+			for (Int32 axis = 0; axis < 3; ++axis)
+			{
+				const float extent = centroid_max[axis] - centroid_min[axis];
+				if (extent <= 0.0f)
+					continue;
+				bin_scale[axis] = (float)kNumSplitBins / extent;
+
+				Aabb bin_bounds[kNumSplitBins];
+				Int32 bin_counts[kNumSplitBins] = { 0 };
+				for (Int32 object_num = 0; object_num < object_count; ++object_num)
+				{
+					const Int32 object_index = objects[object_num];
+					const Int32 bin = std::min((Int32)((centroids[object_index][axis] - centroid_min[axis]) * bin_scale[axis]), kNumSplitBins - 1);
+					bin_counts[bin]++;
+					bin_bounds[bin] = MergeAabbs(bin_bounds[bin], object_bounds_[object_index]);
+				}
+
+				// sweep from the right to get the cost of everything to the right of each split
+				float right_costs[kNumSplitBins];
+				Aabb right_bounds;
+				Int32 right_count = 0;
+				for (Int32 bin = kNumSplitBins - 1; bin > 0; --bin)
+				{
+					right_bounds = MergeAabbs(right_bounds, bin_bounds[bin]);
+					right_count += bin_counts[bin];
+					right_costs[bin] = HalfSurfaceArea(right_bounds) * right_count;
+				}
+
+				// then from the left, splitting between bin-1 and bin
+				Aabb left_bounds;
+				Int32 left_count = 0;
+				for (Int32 bin = 1; bin < kNumSplitBins; ++bin)
+				{
+					left_bounds = MergeAabbs(left_bounds, bin_bounds[bin - 1]);
+					left_count += bin_counts[bin - 1];
+					if (left_count == 0 || left_count == object_count)
+						continue;
+
+					const float cost = HalfSurfaceArea(left_bounds) * left_count + right_costs[bin];
+					if (cost < best_cost)
+					{
+						best_cost = cost;
+						best_axis = axis;
+						best_split = bin;
+					}
+				}
+			}
+
+			if (best_axis == -1)
+			{
+				// all the centroids are in the same place so there is no way to separate them
+				make_leaf = true;
+			}
+			else if (object_count <= kMaxLeafObjects)
+			{
+				// compare against the cost of testing every object in a leaf, with a traversal step costing the same as an object test
+				const float parent_area = HalfSurfaceArea(nodes_[node_index].bounds);
+				const float split_cost = 1.0f + (parent_area > 0.0f ? best_cost / parent_area : 0.0f);
+				make_leaf = split_cost >= (float)object_count;
+			}
+		}
+
+		if (make_leaf)
+		{
+			for (Int32 object_num = 0; object_num < object_count; ++object_num)
+				object_leaves_[objects[object_num]] = node_index;
+			return;
+		}
+
+		// partition the objects either side of the split
+		const float axis_min = centroid_min[best_axis];
+		const float axis_scale = bin_scale[best_axis];
+		Int32* const middle = std::partition(objects, objects + object_count,
+			[&](const Int32 object_index)
+			{
+				const Int32 bin = std::min((Int32)((centroids[object_index][best_axis] - axis_min) * axis_scale), kNumSplitBins - 1);
+				return bin < best_split;
+			});
+		const Int32 left_count = (Int32)(middle - objects);
+
+		// children are allocated as a pair so only the first needs to be stored
+		const Int32 first_child = (Int32)nodes_.size();
+		nodes_.push_back(Node());
+		nodes_.push_back(Node());
+		nodes_[node_index].first_child = first_child;
+
+		BuildNode(first_child, centroids, first_object, left_count, node_index, depth + 1);
+		BuildNode(first_child + 1, centroids, first_object + left_count, object_count - left_count, node_index, depth + 1);
+	}
+
+	void Bvh::CalculateNodeBounds(Node& node) const
+	{
+		if (node.first_child == -1)
+		{
+			Aabb bounds;
+			for (Int32 object_num = node.first_object; object_num < node.first_object + node.object_count; ++object_num)
+				bounds = MergeAabbs(bounds, object_bounds_[object_indices_[object_num]]);
+			node.bounds = bounds;
+		}
+		else
+		{
+			node.bounds = MergeAabbs(nodes_[node.first_child].bounds, nodes_[node.first_child + 1].bounds);
+		}
+	}
+
+	void Bvh::Refit(const Aabb* aabbs)
+	{
+		object_bounds_.assign(aabbs, aabbs + object_bounds_.size());
+
+		// children always come after their parent so walking backwards visits them first
+		for (std::vector<Node>::reverse_iterator node = nodes_.rbegin(); node != nodes_.rend(); ++node)
+			CalculateNodeBounds(*node);
+	}
+
+	void Bvh::UpdateObject(const Int32 object_index, const Aabb& aabb)
+	{
+		object_bounds_[object_index] = aabb;
+
+		for (Int32 node_index = object_leaves_[object_index]; node_index != -1; node_index = nodes_[node_index].parent)
+			CalculateNodeBounds(nodes_[node_index]);
+	}
+
+	Int32 Bvh::AddNodeObjects(const Node& node, std::vector<Int32>& results) const
+	{
+		results.insert(results.end(), object_indices_.begin() + node.first_object, object_indices_.begin() + node.first_object + node.object_count);
+		return node.object_count;
+	}
+
+	Int32 Bvh::QueryFrustum(const Frustum& frustum, std::vector<Int32>& results) const
+	{
+		if (nodes_.empty())
+			return 0;
+
+		Int32 stack[kMaxDepth + 2];
+		Int32 stack_size = 0;
+		Int32 found_count = 0;
+
+		stack[stack_size++] = 0;
+		while (stack_size > 0)
+		{
+			const Node& node = nodes_[stack[--stack_size]];
+
+			const FrustumIntersect intersect = frustum.Intersects(node.bounds);
+			if (intersect == FI_OUT)
+				continue;
+
+			// everything under a node that is completely inside is visible without testing any further
+			if (intersect == FI_IN || node.object_count == 1)
+			{
+				found_count += AddNodeObjects(node, results);
+				continue;
+			}
+
+			if (node.first_child == -1)
+			{
+				for (Int32 object_num = node.first_object; object_num < node.first_object + node.object_count; ++object_num)
+				{
+					const Int32 object_index = object_indices_[object_num];
+					if (frustum.Intersects(object_bounds_[object_index]) != FI_OUT)
+					{
+						results.push_back(object_index);
+						found_count++;
+					}
+				}
+				continue;
+			}
+
+			stack[stack_size++] = node.first_child + 1;
+			stack[stack_size++] = node.first_child;
+		}
+
+		return found_count;
+	}
+
+	Int32 Bvh::QuerySphere(const Sphere& sphere, std::vector<Int32>& results) const
+	{
+		if (nodes_.empty())
+			return 0;
+
+		const float radius_sqr = sphere.radius() * sphere.radius();
+
+		Int32 stack[kMaxDepth + 2];
+		Int32 stack_size = 0;
+		Int32 found_count = 0;
+
+		stack[stack_size++] = 0;
+		while (stack_size > 0)
+		{
+			const Node& node = nodes_[stack[--stack_size]];
+			if (!SphereOverlapsAabb(sphere.position(), radius_sqr, node.bounds))
+				continue;
+
+			if (node.first_child == -1)
+			{
+				for (Int32 object_num = node.first_object; object_num < node.first_object + node.object_count; ++object_num)
+				{
+					const Int32 object_index = object_indices_[object_num];
+					if (node.object_count == 1 || SphereOverlapsAabb(sphere.position(), radius_sqr, object_bounds_[object_index]))
+					{
+						results.push_back(object_index);
+						found_count++;
+					}
+				}
+				continue;
+			}
+
+			stack[stack_size++] = node.first_child + 1;
+			stack[stack_size++] = node.first_child;
+		}
+
+		return found_count;
+	}
+
+	Int32 Bvh::QueryAabb(const Aabb& aabb, std::vector<Int32>& results) const
+	{
+		if (nodes_.empty())
+			return 0;
+
+		Int32 stack[kMaxDepth + 2];
+		Int32 stack_size = 0;
+		Int32 found_count = 0;
+
+		stack[stack_size++] = 0;
+		while (stack_size > 0)
+		{
+			const Node& node = nodes_[stack[--stack_size]];
+			if (!AabbsOverlap(aabb, node.bounds))
+				continue;
+
+			if (node.first_child == -1)
+			{
+				for (Int32 object_num = node.first_object; object_num < node.first_object + node.object_count; ++object_num)
+				{
+					const Int32 object_index = object_indices_[object_num];
+					if (node.object_count == 1 || AabbsOverlap(aabb, object_bounds_[object_index]))
+					{
+						results.push_back(object_index);
+						found_count++;
+					}
+				}
+				continue;
+			}
+
+			stack[stack_size++] = node.first_child + 1;
+			stack[stack_size++] = node.first_child;
+		}
+
+		return found_count;
+	}
+
+	Int32 Bvh::QueryRay(const Ray& ray, const float max_distance, std::vector<Int32>& results) const
+	{
+		if (nodes_.empty())
+			return 0;
+
+		Int32 stack[kMaxDepth + 2];
+		Int32 stack_size = 0;
+		Int32 found_count = 0;
+
+		stack[stack_size++] = 0;
+		while (stack_size > 0)
+		{
+			const Node& node = nodes_[stack[--stack_size]];
+			if (!ray.Intersects(node.bounds, max_distance))
+				continue;
+
+			if (node.first_child == -1)
+			{
+				for (Int32 object_num = node.first_object; object_num < node.first_object + node.object_count; ++object_num)
+				{
+					const Int32 object_index = object_indices_[object_num];
+					if (node.object_count == 1 || ray.Intersects(object_bounds_[object_index], max_distance))
+					{
+						results.push_back(object_index);
+						found_count++;
+					}
+				}
+				continue;
+			}
+
+			stack[stack_size++] = node.first_child + 1;
+			stack[stack_size++] = node.first_child;
+		}
+
+		return found_count;
+	}
+
+	const Aabb Bvh::bounds() const
+	{
+		if (nodes_.empty())
+			return Aabb();
+
+		return nodes_[0].bounds;
+	}
+}
@@ -0,0 +1,186 @@
+#ifndef _GEF_BVH_H
+#define _GEF_BVH_H
+
+#include <gef.h>
+#include <maths/aabb.h>
+#include <maths/ray.h>
+#include <vector>
+
+namespace gef
+{
+	// forward declarations
+	class Frustum;
+	class Sphere;
+
+	/**
+	A bounding volume hierarchy of axis aligned bounding boxes.
+	Objects are referred to by the index of their bounding box in the array the hierarchy was built from,
+	so queries return indices that can be used to look up the objects in the caller's own arrays.
+	*/
+	class Bvh
+	{
+	public:
+		/// @brief Default constructor. Creates an empty hierarchy.
+		Bvh();
+
+		/// @brief Builds the hierarchy using the surface area heuristic with binned splits.
+		/// @param[in] aabbs	The bounding boxes of the objects.
+		/// @param[in] count	The number of objects.
+		/// @note Any previous contents of the hierarchy are discarded.
+		void Build(const Aabb* aabbs, const Int32 count);
+
+		/// @brief Updates the bounds of every object and refits the whole hierarchy without changing its structure.
+		/// @param[in] aabbs	The new bounding boxes of the objects. Must hold the same number of objects used to build the hierarchy.
+		/// @note Use this when many objects have moved. If the objects have moved a long way from where they were when
+		/// the hierarchy was built, the queries will become slower and it should be built again.
+		void Refit(const Aabb* aabbs);
+
+		/// @brief Updates the bounds of a single object and the nodes above it.
+		/// @param[in] object_index		The index of the object.
+		/// @param[in] aabb				The new bounding box of the object.
+		void UpdateObject(const Int32 object_index, const Aabb& aabb);
+
+		/// @brief Finds the objects with bounding boxes that are not completely outside a frustum.
+		/// @param[in] frustum		The frustum.
+		/// @param[out] results		The indices of the objects found are added to the end of this array.
+		/// @return The number of objects found.
+		Int32 QueryFrustum(const Frustum& frustum, std::vector<Int32>& results) const;
+
+		/// @brief Finds the objects with bounding boxes that overlap a sphere.
+		/// @param[in] sphere		The sphere.
+		/// @param[out] results		The indices of the objects found are added to the end of this array.
+		/// @return The number of objects found.
+		Int32 QuerySphere(const Sphere& sphere, std::vector<Int32>& results) const;
+
+		/// @brief Finds the objects with bounding boxes that overlap an axis aligned bounding box.
+		/// @param[in] aabb			The bounding box.
+		/// @param[out] results		The indices of the objects found are added to the end of this array.
+		/// @return The number of objects found.
+		Int32 QueryAabb(const Aabb& aabb, std::vector<Int32>& results) const;
+
+		/// @brief Finds the objects with bounding boxes that are hit by a ray.
+		/// @param[in] ray				The ray.
+		/// @param[in] max_distance		Boxes further along the ray than this are ignored.
+		/// @param[out] results			The indices of the objects found are added to the end of this array.
+		/// @return The number of objects found.
+		Int32 QueryRay(const Ray& ray, const float max_distance, std::vector<Int32>& results) const;
+
+		/// @brief Finds the nearest object hit by a ray, visiting the leaves the ray passes through nearest first
+		/// and skipping any that are further away than the nearest hit found so far.
+		/// @param[in] ray				The ray.
+		/// @param[in,out] distance		The maximum distance to search along the ray. Reduced by leaf_test when it finds a hit.
+		/// @param[in] leaf_test		Called for each leaf as leaf_test(first_order, count, distance), where the objects in the leaf are
+		///								ordered_object_index(first_order) to ordered_object_index(first_order+count-1).
+		///								It should return true if it finds a hit closer than distance, and set distance to the hit distance.
+		/// @return true if leaf_test found a hit.
+		template<class LeafTest>
+		bool Raycast(const Ray& ray, float& distance, LeafTest& leaf_test) const;
+
+		/// @brief Get an object index from the order the objects are stored in the leaves of the hierarchy.
+		/// The order only changes when the hierarchy is built.
+		/// @param[in] order	The position of the object in the order.
+		/// @return The index of the object.
+		inline Int32 ordered_object_index(const Int32 order) const { return object_indices_[order]; }
+
+		/// @brief Get the number of objects in the hierarchy.
+		inline Int32 object_count() const { return (Int32)object_bounds_.size(); }
+
+		/// @brief Get the bounds of all the objects in the hierarchy.
+		/// @return The bounds, or an empty box if the hierarchy is empty.
+		const Aabb bounds() const;
+
+	private:
+		/// The maximum number of objects stored in a leaf node.
+		static const Int32 kMaxLeafObjects = 4;
+
+		/// The maximum depth of the hierarchy. Deeper nodes are made in to leaves whatever their size.
+		static const Int32 kMaxDepth = 48;
+
+		struct Node
+		{
+			/// Bounds of all the objects under this node.
+			Aabb bounds;
+
+			/// Index of the first child node, the second child follows it. -1 for leaf nodes.
+			Int32 first_child;
+
+			/// Index of the parent node. -1 for the root node.
+			Int32 parent;
+
+			/// The objects under this node are object_indices_[first_object] to object_indices_[first_object+object_count-1].
+			Int32 first_object;
+			Int32 object_count;
+		};
+
+		void BuildNode(const Int32 node_index, const std::vector<Vector4>& centroids, const Int32 first_object, const Int32 object_count, const Int32 parent, const Int32 depth);
+		void CalculateNodeBounds(Node& node) const;
+		Int32 AddNodeObjects(const Node& node, std::vector<Int32>& results) const;
+
+		/// The nodes. Node 0 is the root and children always come after their parent.
+		std::vector<Node> nodes_;
+
+		/// Object indices ordered so that the objects under each node are contiguous.
+		std::vector<Int32> object_indices_;
+
+		/// The leaf node each object is stored in.
+		std::vector<Int32> object_leaves_;
+
+		/// The bounds of each object.
+		std::vector<Aabb> object_bounds_;
+	};
+
+	template<class LeafTest>
+	bool Bvh::Raycast(const Ray& ray, float& distance, LeafTest& leaf_test) const
+	{
+		float node_distance;
+		if (nodes_.empty() || !ray.Intersects(nodes_[0].bounds, distance, &node_distance))
+			return false;
+
+		Int32 stack[kMaxDepth + 2];
+		float stack_distances[kMaxDepth + 2];
+		Int32 stack_size = 0;
+		bool hit = false;
+
+		stack[stack_size] = 0;
+		stack_distances[stack_size++] = node_distance;
+		while (stack_size > 0)
+		{
+			--stack_size;
+
+			// a closer hit may have been found since the node was pushed
+			if (stack_distances[stack_size] > distance)
+				continue;
+
+			const Node& node = nodes_[stack[stack_size]];
+			if (node.first_child == -1)
+			{
+				if (leaf_test(node.first_object, node.object_count, distance))
+					hit = true;
+				continue;
+			}
+
+			float child_distances[2];
+			const bool child_hits[2] = {
+				ray.Intersects(nodes_[node.first_child].bounds, distance, &child_distances[0]),
+				ray.Intersects(nodes_[node.first_child + 1].bounds, distance, &child_distances[1]) };
+
+			// push the furthest child first so the nearest is visited first
+			const Int32 near_child = child_hits[1] && (!child_hits[0] || child_distances[1] < child_distances[0]) ? 1 : 0;
+			const Int32 far_child = 1 - near_child;
+			if (child_hits[far_child])
+			{
+				stack[stack_size] = node.first_child + far_child;
+				stack_distances[stack_size++] = child_distances[far_child];
+			}
+			if (child_hits[near_child])
+			{
+				stack[stack_size] = node.first_child + near_child;
+				stack_distances[stack_size++] = child_distances[near_child];
+			}
+		}
+
+		return hit;
+	}
+}
+
+#endif // _GEF_BVH_H
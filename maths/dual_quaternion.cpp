@@ -0,0 +1,147 @@
+#include <maths/dual_quaternion.h>
+#include <maths/matrix44.h>
+#include <maths/simd.h>
+
+namespace gef
+{
+	DualQuaternion::DualQuaternion()
+	{
+	}
+
+	DualQuaternion::DualQuaternion(const Quaternion& real_part, const Quaternion& dual_part) :
+		real(real_part),
+		dual(dual_part)
+	{
+	}
+
+	void DualQuaternion::SetFromRotationTranslation(const Quaternion& rotation, const Vector4& translation)
+	{
+		// the dual part is half the translation as a pure quaternion multiplied by the rotation, i.e. rotation*translation
+		// with the operator order of Quaternion, written out because the translation has no w
+		real = rotation;
+		dual.x = 0.5f * (rotation.w*translation.x() + translation.y()*rotation.z - translation.z()*rotation.y);
+		dual.y = 0.5f * (rotation.w*translation.y() + translation.z()*rotation.x - translation.x()*rotation.z);
+		dual.z = 0.5f * (rotation.w*translation.z() + translation.x()*rotation.y - translation.y()*rotation.x);
+		dual.w = -0.5f * (translation.x()*rotation.x + translation.y()*rotation.y + translation.z()*rotation.z);
+	}
+
+	void DualQuaternion::SetFromMatrix(const Matrix44& matrix)
+	{
+		// remove any scale from the rotation rows before taking the rotation from them
+		Matrix44 rotation_matrix = matrix;
+		for (Int32 row = 0; row < 3; ++row)
+		{
+			const Vector4& row_values = matrix.GetRow(row);
+			const float length = sqrtf(row_values.x()*row_values.x() + row_values.y()*row_values.y() + row_values.z()*row_values.z());
+			rotation_matrix.SetRow(row, Vector4(row_values.x() / length, row_values.y() / length, row_values.z() / length, row_values.w()));
+		}
+
+		Quaternion rotation(rotation_matrix);
+		rotation.Normalise();
+		SetFromRotationTranslation(rotation, matrix.GetTranslation());
+	}
+
+	void DualQuaternion::Identity()
+	{
+		real.Identity();
+		dual = Quaternion(0.0f, 0.0f, 0.0f, 0.0f);
+	}
+
+	void DualQuaternion::Normalise()
+	{
+		const float length = real.Length();
+		real = real / length;
+		dual = dual / length;
+	}
+
+	const Vector4 DualQuaternion::GetTranslation() const
+	{
+		// twice the dual part multiplied by the conjugate of the real part
+		return Vector4(
+			2.0f * (real.w*dual.x - dual.w*real.x + real.y*dual.z - real.z*dual.y),
+			2.0f * (real.w*dual.y - dual.w*real.y + real.z*dual.x - real.x*dual.z),
+			2.0f * (real.w*dual.z - dual.w*real.z + real.x*dual.y - real.y*dual.x));
+	}
+
+	const Vector4 DualQuaternion::TransformPoint(const Vector4& point) const
+	{
+		return Quaternion::Rotate(real, point) + GetTranslation();
+	}
+
+	void DualQuaternion::SetFromMatrixArray(DualQuaternion* results, const Matrix44* matrices, const Int32 count)
+	{
+		const SimdVector half = SimdSplat(0.5f);
+		const SimdVector one = SimdSplat(1.0f);
+		const SimdVector two = SimdSplat(2.0f);
+		const SimdVector min_trace = SimdSplat(0.000001f);
+
+		for (Int32 first = 0; first < count; first += 4)
+		{
+			// a partial group repeats the last matrix, and only the results for real matrices are stored
+			const float* matrix_values[4];
+			for (Int32 lane = 0; lane < 4; ++lane)
+				matrix_values[lane] = matrices[first + lane < count ? first + lane : count - 1].float_ptr();
+
+			// transpose each row of the four matrices so every SimdVector holds one element of all four
+			SimdVector m00 = SimdLoad(matrix_values[0]), m01 = SimdLoad(matrix_values[1]), m02 = SimdLoad(matrix_values[2]), m03 = SimdLoad(matrix_values[3]);
+			SimdVector m10 = SimdLoad(matrix_values[0]+4), m11 = SimdLoad(matrix_values[1]+4), m12 = SimdLoad(matrix_values[2]+4), m13 = SimdLoad(matrix_values[3]+4);
+			SimdVector m20 = SimdLoad(matrix_values[0]+8), m21 = SimdLoad(matrix_values[1]+8), m22 = SimdLoad(matrix_values[2]+8), m23 = SimdLoad(matrix_values[3]+8);
+			SimdVector tx = SimdLoad(matrix_values[0]+12), ty = SimdLoad(matrix_values[1]+12), tz = SimdLoad(matrix_values[2]+12), tw = SimdLoad(matrix_values[3]+12);
+			SimdTranspose(m00, m01, m02, m03);
+			SimdTranspose(m10, m11, m12, m13);
+			SimdTranspose(m20, m21, m22, m23);
+			SimdTranspose(tx, ty, tz, tw);
+
+			// remove any scale, the same as SetFromMatrix
+			const SimdVector length0 = SimdSqrt(SimdAdd(SimdAdd(SimdMul(m00, m00), SimdMul(m01, m01)), SimdMul(m02, m02)));
+			const SimdVector length1 = SimdSqrt(SimdAdd(SimdAdd(SimdMul(m10, m10), SimdMul(m11, m11)), SimdMul(m12, m12)));
+			const SimdVector length2 = SimdSqrt(SimdAdd(SimdAdd(SimdMul(m20, m20), SimdMul(m21, m21)), SimdMul(m22, m22)));
+			m00 = SimdDiv(m00, length0); m01 = SimdDiv(m01, length0); m02 = SimdDiv(m02, length0);
+			m10 = SimdDiv(m10, length1); m11 = SimdDiv(m11, length1); m12 = SimdDiv(m12, length1);
+			m20 = SimdDiv(m20, length2); m21 = SimdDiv(m21, length2); m22 = SimdDiv(m22, length2);
+
+			// Quaternion::SetFromMatrix uses the trace when it's large enough and a branch on the largest diagonal element
+			// otherwise, so only matrices that take the first path are converted here
+			const SimdVector trace = SimdAdd(SimdAdd(SimdAdd(m00, m11), m22), one);
+			const int trace_mask = SimdLessMask(min_trace, trace);
+
+			const SimdVector root_trace = SimdSqrt(trace);
+			const SimdVector denominator = SimdMul(two, root_trace);
+			SimdVector qx = SimdDiv(SimdSub(m12, m21), denominator);
+			SimdVector qy = SimdDiv(SimdSub(m20, m02), denominator);
+			SimdVector qz = SimdDiv(SimdSub(m01, m10), denominator);
+			SimdVector qw = SimdDiv(root_trace, two);
+
+			const SimdVector length = SimdSqrt(SimdAdd(SimdAdd(SimdAdd(SimdMul(qx, qx), SimdMul(qy, qy)), SimdMul(qz, qz)), SimdMul(qw, qw)));
+			qx = SimdDiv(qx, length);
+			qy = SimdDiv(qy, length);
+			qz = SimdDiv(qz, length);
+			qw = SimdDiv(qw, length);
+
+			// dual part, as in SetFromRotationTranslation
+			SimdVector dx = SimdMul(half, SimdSub(SimdAdd(SimdMul(qw, tx), SimdMul(ty, qz)), SimdMul(tz, qy)));
+			SimdVector dy = SimdMul(half, SimdSub(SimdAdd(SimdMul(qw, ty), SimdMul(tz, qx)), SimdMul(tx, qz)));
+			SimdVector dz = SimdMul(half, SimdSub(SimdAdd(SimdMul(qw, tz), SimdMul(tx, qy)), SimdMul(ty, qx)));
+			SimdVector dw = SimdMul(SimdNegate(half), SimdAdd(SimdAdd(SimdMul(tx, qx), SimdMul(ty, qy)), SimdMul(tz, qz)));
+
+			SimdTranspose(qx, qy, qz, qw);
+			SimdTranspose(dx, dy, dz, dw);
+			const SimdVector reals[4] = { qx, qy, qz, qw };
+			const SimdVector duals[4] = { dx, dy, dz, dw };
+
+			for (Int32 lane = 0; lane < 4 && first + lane < count; ++lane)
+			{
+				DualQuaternion& result = results[first + lane];
+				if (trace_mask & (1 << lane))
+				{
+					SimdStore(&result.real.x, reals[lane]);
+					SimdStore(&result.dual.x, duals[lane]);
+				}
+				else
+				{
+					result.SetFromMatrix(matrices[first + lane]);
+				}
+			}
+		}
+	}
+}
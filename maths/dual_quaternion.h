@@ -0,0 +1,59 @@
+#ifndef _GEF_DUAL_QUATERNION_H
+#define _GEF_DUAL_QUATERNION_H
+
+#include <gef.h>
+#include <maths/quaternion.h>
+#include <maths/vector4.h>
+
+namespace gef
+{
+	class Matrix44;
+
+	/**
+	A rotation and translation stored as a dual quaternion, in 8 floats rather than the 16 of a Matrix44.
+	Blending dual quaternions and normalising the result keeps the rotation rigid, so skinning with them
+	doesn't collapse joints that twist the way blending matrices does. Scale can't be represented.
+	*/
+	class DualQuaternion
+	{
+	public:
+		/// @brief Default constructor. The values are uninitialised.
+		DualQuaternion();
+
+		/// @brief Constructor.
+		/// @param[in] real_part	The rotation.
+		/// @param[in] dual_part	Half of the translation multiplied by the rotation.
+		DualQuaternion(const Quaternion& real_part, const Quaternion& dual_part);
+
+		/// @brief Sets the dual quaternion from a rotation and a translation.
+		/// @param[in] rotation		The rotation. Must be normalised.
+		/// @param[in] translation	The translation, applied after the rotation.
+		void SetFromRotationTranslation(const Quaternion& rotation, const Vector4& translation);
+
+		/// @brief Sets the dual quaternion from the rotation and translation of a matrix. Any scale in the matrix is removed.
+		void SetFromMatrix(const Matrix44& matrix);
+
+		/// @brief Sets the dual quaternion to no rotation and no translation.
+		void Identity();
+
+		/// @brief Scales both parts so the rotation is normalised.
+		void Normalise();
+
+		/// @brief Get the translation.
+		const Vector4 GetTranslation() const;
+
+		/// @brief Rotates and translates a point.
+		const Vector4 TransformPoint(const Vector4& point) const;
+
+		/// @brief Converts an array of matrices to dual quaternions, four at a time.
+		/// @param[out] results		The dual quaternions, results[i] is matrices[i] with any scale removed.
+		/// @param[in] matrices		The matrices.
+		/// @param[in] count		The number of matrices.
+		static void SetFromMatrixArray(DualQuaternion* results, const Matrix44* matrices, const Int32 count);
+
+		Quaternion real;
+		Quaternion dual;
+	};
+}
+
+#endif // _GEF_DUAL_QUATERNION_H
@@ -2,7 +2,9 @@
 #include <maths/matrix44.h>
 #include <maths/sphere.h>
 #include <maths/aabb.h>
+#include <maths/simd.h>
 #include <math.h>
+#include <cfloat>
 
 namespace gef
 {
@@ -36,43 +38,27 @@ namespace gef
 
 	FrustumIntersect Frustum::Intersects(const Aabb& aabb) const
 	{
-		Vector4 corner[8];
+		// test the box corners nearest to and furthest from each plane (n-vertex and p-vertex)
+		// using the centre and half extents of the box
+		// if the p-vertex is behind any plane, we are out
+		// if the n-vertex is in front of all the planes, then we are fully in
+		const Vector4 centre = (aabb.min_vtx() + aabb.max_vtx())*0.5f;
+		const Vector4 extents = (aabb.max_vtx() - aabb.min_vtx())*0.5f;
 		int total_in = 0;
 
-		// get the corners of the box into the vCorner array
-		corner[0].set_x(aabb.min_vtx().x()); corner[0].set_y(aabb.min_vtx().y()); corner[0].set_z(aabb.min_vtx().z());
-		corner[1].set_x(aabb.min_vtx().x()); corner[1].set_y(aabb.min_vtx().y()); corner[1].set_z(aabb.max_vtx().z());
-		corner[2].set_x(aabb.min_vtx().x()); corner[2].set_y(aabb.max_vtx().y()); corner[2].set_z(aabb.min_vtx().z());
-		corner[3].set_x(aabb.min_vtx().x()); corner[3].set_y(aabb.max_vtx().y()); corner[3].set_z(aabb.max_vtx().z());
-		corner[4].set_x(aabb.max_vtx().x()); corner[4].set_y(aabb.min_vtx().y()); corner[4].set_z(aabb.min_vtx().z());
-		corner[5].set_x(aabb.max_vtx().x()); corner[5].set_y(aabb.min_vtx().y()); corner[5].set_z(aabb.max_vtx().z());
-		corner[6].set_x(aabb.max_vtx().x()); corner[6].set_y(aabb.max_vtx().y()); corner[6].set_z(aabb.min_vtx().z());
-		corner[7].set_x(aabb.max_vtx().x()); corner[7].set_y(aabb.max_vtx().y()); corner[7].set_z(aabb.max_vtx().z());
-
-		// test all 8 corners against the 6 sides 
-		// if all points are behind 1 specific plane, we are out
-		// if we are in with all points, then we are fully in
 		for (int p = 0; p < 6; ++p)
 		{
-			int in_count = 8;
-			int point_in = 1;
+			const Plane& plane = planes_[p];
+			float distance = plane.DistanceFromPoint(centre);
+			float radius = fabsf(plane.a())*extents.x() + fabsf(plane.b())*extents.y() + fabsf(plane.c())*extents.z();
 
-			for (int i = 0; i < 8; ++i)
-			{
-				// test this point against the planes
-				if (planes_[p].ClassifyPoint(corner[i]) == PP_BEHIND)
-				{
-					point_in = 0;
-					--in_count;
-				}
-			}
-
-			// were all the points outside of plane p?
-			if(in_count == 0)
+			// is the p-vertex behind plane p?
+			if (distance + radius < 0.0f)
 				return FI_OUT;
 
-			// check if they were all on the right side of the plane
-			total_in += point_in;
+			// is the n-vertex on the right side of the plane?
+			if (distance - radius >= 0.0f)
+				++total_in;
 		}
 
 		// so if iTotalIn is 6, then all are inside the view
@@ -81,7 +67,226 @@ namespace gef
 
 		// we must be partly in then otherwise
 		return FI_INTERSECTS;
+	}
+
+	// the six planes are stored as two groups of four so one plane equation component
+	// for four planes fits in a SIMD register. The two unused slots get a plane that
+	// nothing can be behind
+	struct FrustumPlanesSoA
+	{
+		SimdVector a[2];
+		SimdVector b[2];
+		SimdVector c[2];
+		SimdVector d[2];
+		SimdVector abs_a[2];
+		SimdVector abs_b[2];
+		SimdVector abs_c[2];
+	};
+
+	static void BuildPlanesSoA(const Plane* planes, FrustumPlanesSoA& soa)
+	{
+		float a[8], b[8], c[8], d[8];
+		for (int p = 0; p < 8; ++p)
+		{
+			if (p < NUM_FRUSTUM_PLANES)
+			{
+				a[p] = planes[p].a();
+				b[p] = planes[p].b();
+				c[p] = planes[p].c();
+				d[p] = planes[p].d();
+			}
+			else
+			{
+				a[p] = 0.0f;
+				b[p] = 0.0f;
+				c[p] = 0.0f;
+				d[p] = FLT_MAX;
+			}
+		}
+
+		for (int group = 0; group < 2; ++group)
+		{
+			soa.a[group] = SimdLoad(&a[group*4]);
+			soa.b[group] = SimdLoad(&b[group*4]);
+			soa.c[group] = SimdLoad(&c[group*4]);
+			soa.d[group] = SimdLoad(&d[group*4]);
+			soa.abs_a[group] = SimdMax(soa.a[group], SimdNegate(soa.a[group]));
+			soa.abs_b[group] = SimdMax(soa.b[group], SimdNegate(soa.b[group]));
+			soa.abs_c[group] = SimdMax(soa.c[group], SimdNegate(soa.c[group]));
+		}
+	}
+
+	// distances from a point to each plane in a group
+	static inline SimdVector PlaneDistances(const FrustumPlanesSoA& soa, const int group, const SimdVector x, const SimdVector y, const SimdVector z)
+	{
+		SimdVector distance = SimdMulAdd(soa.a[group], x, soa.d[group]);
+		distance = SimdMulAdd(soa.b[group], y, distance);
+		return SimdMulAdd(soa.c[group], z, distance);
+	}
+
+	Int32 Frustum::CullSpheres(const Sphere* spheres, const Int32 count, UInt32* visibility) const
+	{
+		FrustumPlanesSoA soa;
+		BuildPlanesSoA(planes_, soa);
+
+		for (Int32 word_num = 0; word_num < VisibilityWordCount(count); ++word_num)
+			visibility[word_num] = 0;
+
+		Int32 visible_count = 0;
+		for (Int32 sphere_num = 0; sphere_num < count; ++sphere_num)
+		{
+			const Sphere& sphere = spheres[sphere_num];
+			const SimdVector centre = SimdLoad(sphere.position().float_ptr());
+			const SimdVector x = SimdSplatX(centre);
+			const SimdVector y = SimdSplatY(centre);
+			const SimdVector z = SimdSplatZ(centre);
+			const SimdVector negative_radius = SimdSplat(-sphere.radius());
+
+			// outside if the centre is further than the radius behind any plane
+			const int outside = SimdLessMask(PlaneDistances(soa, 0, x, y, z), negative_radius)
+				| SimdLessMask(PlaneDistances(soa, 1, x, y, z), negative_radius);
+
+			if (!outside)
+			{
+				visibility[sphere_num >> 5] |= 1u << (sphere_num & 31);
+				++visible_count;
+			}
+		}
+
+		return visible_count;
+	}
+
+	Int32 Frustum::CullAabbs(const Aabb* aabbs, const Int32 count, UInt32* visibility) const
+	{
+		FrustumPlanesSoA soa;
+		BuildPlanesSoA(planes_, soa);
+
+		for (Int32 word_num = 0; word_num < VisibilityWordCount(count); ++word_num)
+			visibility[word_num] = 0;
+
+		const SimdVector half = SimdSplat(0.5f);
+		const SimdVector zero = SimdZero();
+
+		Int32 visible_count = 0;
+		for (Int32 aabb_num = 0; aabb_num < count; ++aabb_num)
+		{
+			const Aabb& aabb = aabbs[aabb_num];
+			const SimdVector min_vtx = SimdLoad(aabb.min_vtx().float_ptr());
+			const SimdVector max_vtx = SimdLoad(aabb.max_vtx().float_ptr());
+			const SimdVector centre = SimdMul(SimdAdd(min_vtx, max_vtx), half);
+			const SimdVector extents = SimdMul(SimdSub(max_vtx, min_vtx), half);
+			const SimdVector x = SimdSplatX(centre);
+			const SimdVector y = SimdSplatY(centre);
+			const SimdVector z = SimdSplatZ(centre);
+			const SimdVector ex = SimdSplatX(extents);
+			const SimdVector ey = SimdSplatY(extents);
+			const SimdVector ez = SimdSplatZ(extents);
+
+			// outside if the p-vertex is behind any plane
+			int outside = 0;
+			for (int group = 0; group < 2; ++group)
+			{
+				SimdVector radius = SimdMul(soa.abs_a[group], ex);
+				radius = SimdMulAdd(soa.abs_b[group], ey, radius);
+				radius = SimdMulAdd(soa.abs_c[group], ez, radius);
+				outside |= SimdLessMask(SimdAdd(PlaneDistances(soa, group, x, y, z), radius), zero);
+			}
+
+			if (!outside)
+			{
+				visibility[aabb_num >> 5] |= 1u << (aabb_num & 31);
+				++visible_count;
+			}
+		}
+
+		return visible_count;
+	}
+
+	FrustumIntersect Frustum::Intersects(const Sphere& sphere, FrustumCullCookie& cookie, const float camera_delta) const
+	{
+		// if the sphere was well inside last time and the planes have barely moved, it is still inside
+		if (cookie.inside_margin > camera_delta)
+		{
+			cookie.inside_margin -= camera_delta;
+			return FI_IN;
+		}
+
+		const Vector4& sphere_centre = sphere.position();
+		float sphere_radius = sphere.radius();
+
+		// the plane that rejected the sphere last time is the most likely to reject it again
+		if (planes_[cookie.last_plane].DistanceFromPoint(sphere_centre) < -sphere_radius)
+		{
+			cookie.inside_margin = -1.0f;
+			return FI_OUT;
+		}
+
+		float inside_margin = FLT_MAX;
+		for (int i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+		{
+			if (i == cookie.last_plane)
+				continue;
+
+			float distance = planes_[i].DistanceFromPoint(sphere_centre);
+			if (distance < -sphere_radius)
+			{
+				cookie.last_plane = i;
+				cookie.inside_margin = -1.0f;
+				return FI_OUT;
+			}
+
+			if (distance - sphere_radius < inside_margin)
+				inside_margin = distance - sphere_radius;
+		}
+
+		// the last plane didn't reject the sphere but it can still intersect it
+		float distance = planes_[cookie.last_plane].DistanceFromPoint(sphere_centre);
+		if (distance - sphere_radius < inside_margin)
+			inside_margin = distance - sphere_radius;
+
+		if (inside_margin >= 0.0f)
+		{
+			cookie.inside_margin = inside_margin;
+			return FI_IN;
+		}
+
+		cookie.inside_margin = -1.0f;
+		return FI_INTERSECTS;
+	}
+
+	Int32 Frustum::CullSpheres(const Sphere* spheres, FrustumCullCookie* cookies, const Int32 count, const float camera_delta, UInt32* visibility) const
+	{
+		for (Int32 word_num = 0; word_num < VisibilityWordCount(count); ++word_num)
+			visibility[word_num] = 0;
+
+		Int32 visible_count = 0;
+		for (Int32 sphere_num = 0; sphere_num < count; ++sphere_num)
+		{
+			if (Intersects(spheres[sphere_num], cookies[sphere_num], camera_delta) != FI_OUT)
+			{
+				visibility[sphere_num >> 5] |= 1u << (sphere_num & 31);
+				++visible_count;
+			}
+		}
+
+		return visible_count;
+	}
+
+	float Frustum::MaximumPlaneShift(const Frustum& previous, const float bounds_radius) const
+	{
+		// for a point p, the change in distance is (n1 - n0).p + (d1 - d0)
+		// which can't be more than |n1 - n0|*|p| + |d1 - d0|
+		float max_shift = 0.0f;
+		for (int i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+		{
+			const Plane& plane = planes_[i];
+			const Plane& previous_plane = previous.planes_[i];
+			float shift = (plane - previous_plane).Length()*bounds_radius + fabsf(plane.d() - previous_plane.d());
+			if (shift > max_shift)
+				max_shift = shift;
+		}
 
+		return max_shift;
 	}
 
 	//
@@ -1,6 +1,7 @@
 #ifndef _GEF_MATHS_FRUSTUM_H
 #define _GEF_MATHS_FRUSTUM_H
 
+#include <gef.h>
 #include <maths/plane.h>
 
 namespace gef
@@ -26,11 +27,70 @@ namespace gef
 		FI_IN,
 		FI_INTERSECTS
 	};
+
+	/**
+	Per object state kept between frames by the coherent culling functions in Frustum.
+	Reset it when the object is teleported or when it changes to a different frustum.
+	*/
+	struct FrustumCullCookie
+	{
+		FrustumCullCookie() : last_plane(0), inside_margin(-1.0f) {}
+
+		/// The plane that last rejected the object. It is tested first next time.
+		Int32 last_plane;
+
+		/// How far the sphere was inside all of the planes the last time it was fully inside, or negative if it wasn't.
+		float inside_margin;
+	};
+
 	class Frustum
 	{
 	public:
 		FrustumIntersect Intersects(const Sphere& sphere) const;
 		FrustumIntersect Intersects(const Aabb& aabb) const;
+
+		/// @brief Tests an array of spheres against the frustum.
+		/// @param[in] spheres		The spheres to test. The frustum planes must have been normalised.
+		/// @param[in] count		The number of spheres.
+		/// @param[out] visibility	Bit mask with a bit set for each sphere that is not completely outside the frustum.
+		///							Sphere i is stored in bit (i % 32) of visibility[i / 32]. See VisibilityWordCount.
+		/// @return The number of spheres that are not completely outside the frustum.
+		Int32 CullSpheres(const Sphere* spheres, const Int32 count, UInt32* visibility) const;
+
+		/// @brief Tests an array of axis aligned bounding boxes against the frustum.
+		/// @param[in] aabbs		The bounding boxes to test.
+		/// @param[in] count		The number of bounding boxes.
+		/// @param[out] visibility	Bit mask with a bit set for each box that is not completely outside the frustum.
+		///							Box i is stored in bit (i % 32) of visibility[i / 32]. See VisibilityWordCount.
+		/// @return The number of boxes that are not completely outside the frustum.
+		Int32 CullAabbs(const Aabb* aabbs, const Int32 count, UInt32* visibility) const;
+
+		/// @brief Tests a sphere against the frustum using the results of previous tests to skip work.
+		/// @param[in] sphere			The sphere to test. The frustum planes must have been normalised.
+		/// @param[in,out] cookie		The state for this sphere from the previous test.
+		/// @param[in] camera_delta		Upper bound on how far any plane has moved relative to the sphere since the previous test, see MaximumPlaneShift.
+		///								A sphere that was fully inside by more than this is still fully inside and isn't tested again.
+		/// @return The result of the test. Unlike Intersects, FI_INTERSECTS is only returned if no plane rejects the sphere.
+		FrustumIntersect Intersects(const Sphere& sphere, FrustumCullCookie& cookie, const float camera_delta) const;
+
+		/// @brief Tests an array of spheres against the frustum using the results of previous tests to skip work.
+		/// @param[in] spheres			The spheres to test. The frustum planes must have been normalised.
+		/// @param[in,out] cookies		The state for each sphere from the previous test.
+		/// @param[in] count			The number of spheres.
+		/// @param[in] camera_delta		Upper bound on how far any plane has moved relative to the spheres since the previous test, see MaximumPlaneShift.
+		/// @param[out] visibility		Bit mask with a bit set for each sphere that is not completely outside the frustum. See CullSpheres.
+		/// @return The number of spheres that are not completely outside the frustum.
+		Int32 CullSpheres(const Sphere* spheres, FrustumCullCookie* cookies, const Int32 count, const float camera_delta, UInt32* visibility) const;
+
+		/// @brief Calculates the furthest any plane of this frustum has moved from the same plane in another frustum.
+		/// @param[in] previous			The frustum to compare with, normally last frame's frustum. Both frustums must have normalised planes.
+		/// @param[in] bounds_radius	The radius around the origin that contains all the objects being culled.
+		/// @return The maximum change in the distance from any plane to any point within bounds_radius of the origin.
+		float MaximumPlaneShift(const Frustum& previous, const float bounds_radius) const;
+
+		/// @brief Get the number of words needed for the visibility mask of count objects.
+		static inline Int32 VisibilityWordCount(const Int32 count) { return (count + 31) / 32; }
+
 		void ExtractPlanesD3D(const Matrix44& viewproj, bool normalise);
 		void ExtractPlanesGL(const Matrix44& viewproj, bool normalise);
 	protected:
@@ -2,11 +2,40 @@
 #include <maths/vector4.h>
 #include <maths/vector4.h>
 #include <maths/quaternion.h>
+#include <maths/simd.h>
 #include <math.h>
 
 
 namespace gef
 {
+	// result = lhs * (r0, r1, r2, r3)
+	// lhs and result point to 16 floats and are allowed to overlap
+	static inline void MultiplyRows(float* result, const float* lhs, const SimdVector r0, const SimdVector r1, const SimdVector r2, const SimdVector r3)
+	{
+		const SimdVector row0 = SimdTransform(SimdLoad(lhs), r0, r1, r2, r3);
+		const SimdVector row1 = SimdTransform(SimdLoad(lhs+4), r0, r1, r2, r3);
+		const SimdVector row2 = SimdTransform(SimdLoad(lhs+8), r0, r1, r2, r3);
+		const SimdVector row3 = SimdTransform(SimdLoad(lhs+12), r0, r1, r2, r3);
+		SimdStore(result, row0);
+		SimdStore(result+4, row1);
+		SimdStore(result+8, row2);
+		SimdStore(result+12, row3);
+	}
+
+	// result and matrix point to 16 floats and are allowed to overlap
+	static inline void TransposeRows(float* result, const float* matrix)
+	{
+		SimdVector row0 = SimdLoad(matrix);
+		SimdVector row1 = SimdLoad(matrix+4);
+		SimdVector row2 = SimdLoad(matrix+8);
+		SimdVector row3 = SimdLoad(matrix+12);
+		SimdTranspose(row0, row1, row2, row3);
+		SimdStore(result, row0);
+		SimdStore(result+4, row1);
+		SimdStore(result+8, row2);
+		SimdStore(result+12, row3);
+	}
+
 
 	Matrix44::Matrix44(const float *m)
 	{
@@ -37,15 +66,37 @@ namespace gef
 	{
 		Matrix44 result;
 
-		for (int i = 0; i < 4; i++)
+		const float* rhs = matrix.float_ptr();
+		MultiplyRows((float*)&result.values_[0], float_ptr(), SimdLoad(rhs), SimdLoad(rhs+4), SimdLoad(rhs+8), SimdLoad(rhs+12));
+
+		return result; 
+	}
+
+	void Matrix44::MultiplyArray(Matrix44* results, const Matrix44* matrices, const Matrix44& matrix, const Int32 count)
+	{
+		const float* rhs = matrix.float_ptr();
+		const SimdVector r0 = SimdLoad(rhs);
+		const SimdVector r1 = SimdLoad(rhs+4);
+		const SimdVector r2 = SimdLoad(rhs+8);
+		const SimdVector r3 = SimdLoad(rhs+12);
+
+		for (Int32 matrix_num = 0; matrix_num < count; ++matrix_num)
+			MultiplyRows((float*)&results[matrix_num].values_[0], matrices[matrix_num].float_ptr(), r0, r1, r2, r3);
+	}
+
+	void Matrix44::MultiplyArray(Matrix44* results, const Matrix44* lhs_matrices, const Matrix44* rhs_matrices, const Int32 count)
+	{
+		for (Int32 matrix_num = 0; matrix_num < count; ++matrix_num)
 		{
-			result.values_[i].set_x(values_[i].x() * matrix.values_[0].x() + values_[i].y() * matrix.values_[1].x() + values_[i].z() * matrix.values_[2].x() + values_[i].w() * matrix.values_[3].x());
-			result.values_[i].set_y(values_[i].x() * matrix.values_[0].y() + values_[i].y() * matrix.values_[1].y() + values_[i].z() * matrix.values_[2].y() + values_[i].w() * matrix.values_[3].y());
-			result.values_[i].set_z(values_[i].x() * matrix.values_[0].z() + values_[i].y() * matrix.values_[1].z() + values_[i].z() * matrix.values_[2].z() + values_[i].w() * matrix.values_[3].z());
-			result.values_[i].set_w(values_[i].x() * matrix.values_[0].w() + values_[i].y() * matrix.values_[1].w() + values_[i].z() * matrix.values_[2].w() + values_[i].w() * matrix.values_[3].w());
+			const float* rhs = rhs_matrices[matrix_num].float_ptr();
+			MultiplyRows((float*)&results[matrix_num].values_[0], lhs_matrices[matrix_num].float_ptr(), SimdLoad(rhs), SimdLoad(rhs+4), SimdLoad(rhs+8), SimdLoad(rhs+12));
 		}
+	}
 
-		return result; 
+	void Matrix44::TransposeArray(Matrix44* results, const Matrix44* matrices, const Int32 count)
+	{
+		for (Int32 matrix_num = 0; matrix_num < count; ++matrix_num)
+			TransposeRows((float*)&results[matrix_num].values_[0], matrices[matrix_num].float_ptr());
 	}
 
 	void Matrix44::LookAt(const Vector4& eye, const Vector4& lookat, const Vector4& up)
@@ -297,8 +348,7 @@ namespace gef
 
 	void Matrix44::Transpose(const Matrix44& matrix)
 	{
-		for (Int32 rowNum = 0; rowNum < 4; ++rowNum)
-			values_[rowNum] = matrix.GetColumn(rowNum);
+		TransposeRows((float*)&values_[0], matrix.float_ptr());
 	}
 
 	void Matrix44::AffineInverse(const Matrix44& matrix)
@@ -321,6 +371,45 @@ namespace gef
 		SetTranslation(invTrans);
 	}
 
+	void Matrix44::AffineInverseScaled(const Matrix44& matrix, float* determinant)
+	{
+		// the inverse of the upper 3x3 has the cross products of pairs of rows as its columns
+		const Vector4& row0 = matrix.GetRow(0);
+		const Vector4& row1 = matrix.GetRow(1);
+		const Vector4& row2 = matrix.GetRow(2);
+		const Vector4 cross12 = row1.CrossProduct(row2);
+		const Vector4 cross20 = row2.CrossProduct(row0);
+		const Vector4 cross01 = row0.CrossProduct(row1);
+
+		float det = row0.DotProduct(cross12);
+		if (det != 0.0f)
+		{
+			const SimdVector inv_det = SimdSplat(1.0f / det);
+			SimdVector inv_row0 = SimdMul(SimdLoad(cross12.float_ptr()), inv_det);
+			SimdVector inv_row1 = SimdMul(SimdLoad(cross20.float_ptr()), inv_det);
+			SimdVector inv_row2 = SimdMul(SimdLoad(cross01.float_ptr()), inv_det);
+			SimdVector inv_row3 = SimdZero();
+			SimdTranspose(inv_row0, inv_row1, inv_row2, inv_row3);
+
+			// translation is -t * inverse(upper 3x3)
+			const SimdVector translation = SimdLoad(matrix.GetRow(3).float_ptr());
+			SimdVector inv_translation = SimdMul(SimdSplatX(translation), inv_row0);
+			inv_translation = SimdMulAdd(SimdSplatY(translation), inv_row1, inv_translation);
+			inv_translation = SimdMulAdd(SimdSplatZ(translation), inv_row2, inv_translation);
+			inv_translation = SimdSelectXYZ(SimdNegate(inv_translation), SimdSplat(1.0f));
+
+			// the w components of the transposed rows come from the zeroed fourth row so the last column is (0, 0, 0, 1)
+			float* result = (float*)&values_[0];
+			SimdStore(result, inv_row0);
+			SimdStore(result+4, inv_row1);
+			SimdStore(result+8, inv_row2);
+			SimdStore(result+12, inv_translation);
+		}
+
+		if(determinant)
+			*determinant = det;
+	}
+
 	void Matrix44::NormaliseRotation()
 	{
 		gef::Quaternion rotation;
@@ -351,36 +440,83 @@ namespace gef
 		return values_[0].x() * v[0] + values_[0].y() * v[1] + values_[0].z() * v[2] + values_[0].w() * v[3];
 	}
 
-	void Matrix44::Inverse(const Matrix44 matrix, float* determinant)
+	// 2x2 matrices stored in a row-major vector (m00, m01, m10, m11)
+
+	// a * b
+	static inline SimdVector Matrix22Multiply(const SimdVector a, const SimdVector b)
+	{
+		return SimdAdd(SimdMul(a, SimdSwizzle<0, 3, 0, 3>(b)), SimdMul(SimdSwizzle<1, 0, 3, 2>(a), SimdSwizzle<2, 1, 2, 1>(b)));
+	}
+
+	// adjugate(a) * b
+	static inline SimdVector Matrix22AdjugateMultiply(const SimdVector a, const SimdVector b)
 	{
-		int a, i, j;
-		Vector4 v, vec[3];
-		float det;
+		return SimdSub(SimdMul(SimdSwizzle<3, 3, 0, 0>(a), b), SimdMul(SimdSwizzle<1, 1, 2, 2>(a), SimdSwizzle<2, 3, 0, 1>(b)));
+	}
 
-		det = matrix.CalculateDeterminant();
-		if ( det!= 0.0f )
+	// a * adjugate(b)
+	static inline SimdVector Matrix22MultiplyAdjugate(const SimdVector a, const SimdVector b)
+	{
+		return SimdSub(SimdMul(a, SimdSwizzle<3, 0, 3, 0>(b)), SimdMul(SimdSwizzle<1, 0, 3, 2>(a), SimdSwizzle<2, 1, 2, 1>(b)));
+	}
+
+	void Matrix44::Inverse(const Matrix44 matrix, float* determinant)
+	{
+		// block-wise inverse, the matrix is split into 2x2 sub matrices
+		// | A B |
+		// | C D |
+		const float* m = matrix.float_ptr();
+		const SimdVector row0 = SimdLoad(m);
+		const SimdVector row1 = SimdLoad(m+4);
+		const SimdVector row2 = SimdLoad(m+8);
+		const SimdVector row3 = SimdLoad(m+12);
+
+		const SimdVector a = SimdShuffle<0, 1, 0, 1>(row0, row1);
+		const SimdVector b = SimdShuffle<2, 3, 2, 3>(row0, row1);
+		const SimdVector c = SimdShuffle<0, 1, 0, 1>(row2, row3);
+		const SimdVector d = SimdShuffle<2, 3, 2, 3>(row2, row3);
+
+		// determinants of the sub matrices (|A|, |B|, |C|, |D|)
+		const SimdVector sub_determinants = SimdSub(
+			SimdMul(SimdShuffle<0, 2, 0, 2>(row0, row2), SimdShuffle<1, 3, 1, 3>(row1, row3)),
+			SimdMul(SimdShuffle<1, 3, 1, 3>(row0, row2), SimdShuffle<0, 2, 0, 2>(row1, row3)));
+		const SimdVector det_a = SimdSplatX(sub_determinants);
+		const SimdVector det_b = SimdSplatY(sub_determinants);
+		const SimdVector det_c = SimdSplatZ(sub_determinants);
+		const SimdVector det_d = SimdSplatW(sub_determinants);
+
+		const SimdVector adj_d_c = Matrix22AdjugateMultiply(d, c);
+		const SimdVector adj_a_b = Matrix22AdjugateMultiply(a, b);
+
+		// adjugates of the blocks of the inverse
+		SimdVector x = SimdSub(SimdMul(det_d, a), Matrix22Multiply(b, adj_d_c));
+		SimdVector w = SimdSub(SimdMul(det_a, d), Matrix22Multiply(c, adj_a_b));
+		SimdVector y = SimdSub(SimdMul(det_b, c), Matrix22MultiplyAdjugate(d, adj_a_b));
+		SimdVector z = SimdSub(SimdMul(det_c, b), Matrix22MultiplyAdjugate(a, adj_d_c));
+
+		// |M| = |A||D| + |B||C| - trace(adjugate(A)B adjugate(D)C)
+		SimdVector trace = SimdMul(adj_a_b, SimdSwizzle<0, 2, 1, 3>(adj_d_c));
+		trace = SimdAdd(trace, SimdSwizzle<2, 3, 0, 1>(trace));
+		trace = SimdAdd(trace, SimdSwizzle<1, 0, 3, 2>(trace));
+		const SimdVector det_m = SimdSub(SimdAdd(SimdMul(det_a, det_d), SimdMul(det_b, det_c)), trace);
+
+		const float det = SimdGetX(det_m);
+		if (det != 0.0f)
 		{
-			for (i=0; i<4; i++)
-			{
-				for (j=0; j<4; j++)
-				{
-					if (j != i )
-					{
-						a = j;
-						if ( j > i )
-							a = a-1;
-
-						vec[a] = matrix.GetRow(j);
-					}
-				}
-
-				v = vec[0].CrossProduct3(vec[1], vec[2]);
-
-
-				float temp = powf(-1.0f, (float)i) / det;
-				SetColumn(i, Vector4(temp*v.x(), temp*v.y(), temp*v.z(), temp*v.w()));
-			}
-	   }
+			// (1/|M|, -1/|M|, -1/|M|, 1/|M|) also applies the signs of the 2x2 adjugates
+			const SimdVector inv_det = SimdDiv(SimdSet(1.0f, -1.0f, -1.0f, 1.0f), det_m);
+			x = SimdMul(x, inv_det);
+			y = SimdMul(y, inv_det);
+			z = SimdMul(z, inv_det);
+			w = SimdMul(w, inv_det);
+
+			// finish the adjugates while putting the blocks back into rows
+			float* result = (float*)&values_[0];
+			SimdStore(result, SimdShuffle<3, 1, 3, 1>(x, y));
+			SimdStore(result+4, SimdShuffle<2, 0, 2, 0>(x, y));
+			SimdStore(result+8, SimdShuffle<3, 1, 3, 1>(z, w));
+			SimdStore(result+12, SimdShuffle<2, 0, 2, 0>(z, w));
+		}
 
 		if(determinant)
 			*determinant = det;
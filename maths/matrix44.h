@@ -137,6 +137,13 @@ namespace gef
 		/// @note It is assumed that the matrix passed in is an affine transformation matrix.
 		void AffineInverse(const Matrix44& matrix);
 
+		/// @brief Set this matrix to the inverse of the matrix provided.
+		/// @param[in] matrix	The affine transformation matrix to be inverted.
+		/// @param[out] determinant		the determinant of the rotation and scale part of the matrix. This can be set to NULL if it's not required.
+		/// @note Unlike AffineInverse, the matrix passed in can contain scaling and shearing. The last column is assumed to be (0, 0, 0, 1).
+		/// This is considerably cheaper than Inverse for world and joint transforms.
+		void AffineInverseScaled(const Matrix44& matrix, float* determinant = NULL);
+
 		/// @brief Removes an scaling from the rotational component of this matrix.
 		void NormaliseRotation();
 
@@ -155,6 +162,26 @@ namespace gef
 		/// @return The result of the operation.
 		const Matrix44 operator*(const Matrix44& matrix) const;
 
+		/// @brief Calculate the product of an array of matrices with a single matrix.
+		/// @param[out] results		The results of the operations, results[i] = matrices[i] * matrix. Can be the same array as matrices.
+		/// @param[in] matrices		The matrices for the first operand of each operation.
+		/// @param[in] matrix		The matrix for the second operand of every operation.
+		/// @param[in] count		The number of matrices in the arrays.
+		static void MultiplyArray(Matrix44* results, const Matrix44* matrices, const Matrix44& matrix, const Int32 count);
+
+		/// @brief Calculate the products of two arrays of matrices.
+		/// @param[out] results			The results of the operations, results[i] = lhs_matrices[i] * rhs_matrices[i]. Can be the same array as either input.
+		/// @param[in] lhs_matrices		The matrices for the first operand of each operation.
+		/// @param[in] rhs_matrices		The matrices for the second operand of each operation.
+		/// @param[in] count			The number of matrices in the arrays.
+		static void MultiplyArray(Matrix44* results, const Matrix44* lhs_matrices, const Matrix44* rhs_matrices, const Int32 count);
+
+		/// @brief Transpose an array of matrices.
+		/// @param[out] results		The transposed matrices. Can be the same array as matrices.
+		/// @param[in] matrices		The matrices to be transposed.
+		/// @param[in] count		The number of matrices in the arrays.
+		static void TransposeArray(Matrix44* results, const Matrix44* matrices, const Int32 count);
+
 		/// @brief Get a particular row from this matrix.
 		/// @param[in] row		The row number.
 		/// @return The contents of selected row.
@@ -207,7 +234,7 @@ namespace gef
 			*(((float*)&values_[row]) + column) = value;
 		}
 
-		inline const float* float_ptr() { return values_[0].float_ptr(); }
+		inline const float* float_ptr() const { return values_[0].float_ptr(); }
 
 	protected:
 		/// The matrix is stored as 4 rows of Vectors
@@ -0,0 +1,191 @@
+#include <maths/ray.h>
+#include <maths/aabb.h>
+#include <maths/sphere.h>
+#include <maths/matrix44.h>
+#include <math.h>
+#include <cfloat>
+
+namespace gef
+{
+	// triangles with a determinant smaller than this are treated as parallel to the ray
+	static const float kParallelEpsilon = 1e-12f;
+
+	// the bounding box test multiplies by the reciprocal of the direction so avoid dividing by zero.
+	// a large finite value keeps the slab distances free of the NaN that inf * 0 would give
+	static float SafeReciprocal(const float value)
+	{
+		return value != 0.0f ? 1.0f / value : FLT_MAX;
+	}
+
+	// dot product of four vectors at once, in the same order as Vector4::DotProduct
+	static SimdVector DotProduct4(const SimdVector a_x, const SimdVector a_y, const SimdVector a_z, const SimdVector b_x, const SimdVector b_y, const SimdVector b_z)
+	{
+		return SimdAdd(SimdAdd(SimdMul(a_x, b_x), SimdMul(a_y, b_y)), SimdMul(a_z, b_z));
+	}
+
+	Ray::Ray()
+	{
+	}
+
+	Ray::Ray(const Vector4& origin, const Vector4& direction) :
+		origin_(origin)
+	{
+		set_direction(direction);
+	}
+
+	void Ray::set_direction(const Vector4& direction)
+	{
+		direction_ = direction;
+		direction_inv_ = Vector4(SafeReciprocal(direction.x()), SafeReciprocal(direction.y()), SafeReciprocal(direction.z()));
+	}
+
+	const Vector4 Ray::GetPoint(const float distance) const
+	{
+		return origin_ + direction_ * distance;
+	}
+
+	const Ray Ray::Transform(const Matrix44& transform_matrix) const
+	{
+		return Ray(origin_.Transform(transform_matrix), direction_.TransformNoTranslation(transform_matrix));
+	}
+
+	bool Ray::Intersects(const Aabb& aabb, const float max_distance, float* distance) const
+	{
+		const SimdVector origin = SimdLoad(origin_.float_ptr());
+		const SimdVector direction_inv = SimdLoad(direction_inv_.float_ptr());
+
+		// distances to the planes of each pair of faces
+		const SimdVector t0 = SimdMul(SimdSub(SimdLoad(aabb.min_vtx().float_ptr()), origin), direction_inv);
+		const SimdVector t1 = SimdMul(SimdSub(SimdLoad(aabb.max_vtx().float_ptr()), origin), direction_inv);
+
+		// put the limits of the ray in w so they are included in the horizontal min and max
+		SimdVector t_near = SimdSelectXYZ(SimdMin(t0, t1), SimdZero());
+		SimdVector t_far = SimdSelectXYZ(SimdMax(t0, t1), SimdSplat(max_distance));
+
+		t_near = SimdMax(t_near, SimdSwizzle<1, 0, 3, 2>(t_near));
+		t_near = SimdMax(t_near, SimdSwizzle<2, 3, 0, 1>(t_near));
+		t_far = SimdMin(t_far, SimdSwizzle<1, 0, 3, 2>(t_far));
+		t_far = SimdMin(t_far, SimdSwizzle<2, 3, 0, 1>(t_far));
+
+		const float entry_distance = SimdGetX(t_near);
+		if (entry_distance > SimdGetX(t_far))
+			return false;
+
+		if (distance)
+			*distance = entry_distance;
+		return true;
+	}
+
+	bool Ray::Intersects(const Sphere& sphere, const float max_distance, float* distance) const
+	{
+		const Vector4 offset = origin_ - sphere.position();
+		const float b = offset.DotProduct(direction_);
+		const float c = offset.LengthSqr() - sphere.radius()*sphere.radius();
+
+		// starts inside the sphere
+		if (c <= 0.0f)
+		{
+			if (distance)
+				*distance = 0.0f;
+			return true;
+		}
+
+		// starts outside and is pointing away
+		if (b > 0.0f)
+			return false;
+
+		const float a = direction_.LengthSqr();
+		const float discriminant = b*b - a*c;
+		if (discriminant < 0.0f || a == 0.0f)
+			return false;
+
+		const float entry_distance = (-b - sqrtf(discriminant)) / a;
+		if (entry_distance > max_distance)
+			return false;
+
+		if (distance)
+			*distance = entry_distance;
+		return true;
+	}
+
+	//
+	// Moller-Trumbore
+	// http://www.graphics.cornell.edu/pubs/1997/MT97.pdf
+	//
+	bool Ray::Intersects(const Vector4& v0, const Vector4& v1, const Vector4& v2, const float max_distance, float* distance) const
+	{
+		const Vector4 edge1 = v1 - v0;
+		const Vector4 edge2 = v2 - v0;
+
+		const Vector4 p = direction_.CrossProduct(edge2);
+		const float determinant = edge1.DotProduct(p);
+		if (fabsf(determinant) <= kParallelEpsilon)
+			return false;
+		const float determinant_inv = 1.0f / determinant;
+
+		const Vector4 t = origin_ - v0;
+		const float u = t.DotProduct(p) * determinant_inv;
+		if (u < 0.0f || u > 1.0f)
+			return false;
+
+		const Vector4 q = t.CrossProduct(edge1);
+		const float v = direction_.DotProduct(q) * determinant_inv;
+		if (v < 0.0f || u + v > 1.0f)
+			return false;
+
+		const float hit_distance = edge2.DotProduct(q) * determinant_inv;
+		if (hit_distance < 0.0f || hit_distance > max_distance)
+			return false;
+
+		if (distance)
+			*distance = hit_distance;
+		return true;
+	}
+
+	Int32 Ray::IntersectsTriangles(const TrianglePacket& triangles, const float max_distance, float distances[4]) const
+	{
+		const SimdVector dir_x = SimdSplat(direction_.x());
+		const SimdVector dir_y = SimdSplat(direction_.y());
+		const SimdVector dir_z = SimdSplat(direction_.z());
+
+		const SimdVector* edge1 = triangles.edge1;
+		const SimdVector* edge2 = triangles.edge2;
+
+		// p = direction x edge2
+		const SimdVector p_x = SimdSub(SimdMul(dir_y, edge2[2]), SimdMul(dir_z, edge2[1]));
+		const SimdVector p_y = SimdSub(SimdMul(dir_z, edge2[0]), SimdMul(dir_x, edge2[2]));
+		const SimdVector p_z = SimdSub(SimdMul(dir_x, edge2[1]), SimdMul(dir_y, edge2[0]));
+
+		const SimdVector determinant = DotProduct4(edge1[0], edge1[1], edge1[2], p_x, p_y, p_z);
+		const SimdVector determinant_inv = SimdDiv(SimdSplat(1.0f), determinant);
+
+		// t = origin - v0
+		const SimdVector t_x = SimdSub(SimdSplat(origin_.x()), triangles.v0[0]);
+		const SimdVector t_y = SimdSub(SimdSplat(origin_.y()), triangles.v0[1]);
+		const SimdVector t_z = SimdSub(SimdSplat(origin_.z()), triangles.v0[2]);
+
+		const SimdVector u = SimdMul(DotProduct4(t_x, t_y, t_z, p_x, p_y, p_z), determinant_inv);
+
+		// q = t x edge1
+		const SimdVector q_x = SimdSub(SimdMul(t_y, edge1[2]), SimdMul(t_z, edge1[1]));
+		const SimdVector q_y = SimdSub(SimdMul(t_z, edge1[0]), SimdMul(t_x, edge1[2]));
+		const SimdVector q_z = SimdSub(SimdMul(t_x, edge1[1]), SimdMul(t_y, edge1[0]));
+
+		const SimdVector v = SimdMul(DotProduct4(dir_x, dir_y, dir_z, q_x, q_y, q_z), determinant_inv);
+		const SimdVector hit_distance = SimdMul(DotProduct4(edge2[0], edge2[1], edge2[2], q_x, q_y, q_z), determinant_inv);
+
+		const SimdVector zero = SimdZero();
+		const SimdVector abs_determinant = SimdMax(determinant, SimdNegate(determinant));
+
+		// the same tests as the single triangle version, with every lane tested and the results combined
+		Int32 hits = SimdLessMask(SimdSplat(kParallelEpsilon), abs_determinant);
+		hits &= ~SimdLessMask(u, zero);
+		hits &= ~SimdLessMask(v, zero);
+		hits &= ~SimdLessMask(SimdSplat(1.0f), SimdAdd(u, v));
+		hits &= ~SimdLessMask(hit_distance, zero);
+		hits &= ~SimdLessMask(SimdSplat(max_distance), hit_distance);
+
+		SimdStore(distances, hit_distance);
+		return hits & 0xf;
+	}
+}
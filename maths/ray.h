@@ -0,0 +1,112 @@
+#ifndef _GEF_RAY_H
+#define _GEF_RAY_H
+
+#include <gef.h>
+#include <maths/vector4.h>
+#include <maths/simd.h>
+
+namespace gef
+{
+	// forward declarations
+	class Matrix44;
+	class Aabb;
+	class Sphere;
+
+	/**
+	Four triangles with the x, y and z components of each value stored in separate vectors so they can be
+	tested against a ray at the same time. Unused lanes should be filled with zeros, which never intersect.
+	*/
+	struct TrianglePacket
+	{
+		/// The first vertex of each triangle.
+		SimdVector v0[3];
+
+		/// The second vertex minus the first vertex of each triangle.
+		SimdVector edge1[3];
+
+		/// The third vertex minus the first vertex of each triangle.
+		SimdVector edge2[3];
+	};
+
+	/**
+	A ray represented by its start position and direction.
+	Distances along the ray are measured in multiples of the direction vector, so they are in world units when it is normalised.
+	*/
+	class Ray
+	{
+	public:
+		/// @brief Default constructor.
+		Ray();
+
+		/// @brief Creates a ray given the start position and direction.
+		/// @param[in] origin		The start position.
+		/// @param[in] direction	The direction.
+		Ray(const Vector4& origin, const Vector4& direction);
+
+		/// @brief Sets the start position.
+		/// @param[in] origin		The start position.
+		inline void set_origin(const Vector4& origin) { origin_ = origin; }
+
+		/// @brief Get the start position.
+		inline const Vector4& origin() const { return origin_; }
+
+		/// @brief Sets the direction.
+		/// @param[in] direction	The direction.
+		void set_direction(const Vector4& direction);
+
+		/// @brief Get the direction.
+		inline const Vector4& direction() const { return direction_; }
+
+		/// @brief Get the position at a distance along the ray.
+		/// @param[in] distance		The distance along the ray.
+		/// @return The position.
+		const Vector4 GetPoint(const float distance) const;
+
+		/// @brief Transforms the ray by a transformation matrix.
+		/// @param[in] transform_matrix		The matrix to transform this ray.
+		/// @return The transformed ray.
+		/// @note The direction is transformed without being normalised so distances along the transformed ray match
+		/// distances along this one. Use this with the inverse of a mesh's transform to test the ray against the mesh data.
+		const Ray Transform(const Matrix44& transform_matrix) const;
+
+		/// @brief Tests the ray against an axis aligned bounding box.
+		/// @param[in] aabb				The bounding box.
+		/// @param[in] max_distance		Intersections further along the ray than this are ignored.
+		/// @param[out] distance		If not NULL, receives the distance the ray enters the box, or zero if it starts inside.
+		/// @return true if the ray hits the box.
+		bool Intersects(const Aabb& aabb, const float max_distance, float* distance = NULL) const;
+
+		/// @brief Tests the ray against a sphere.
+		/// @param[in] sphere			The sphere.
+		/// @param[in] max_distance		Intersections further along the ray than this are ignored.
+		/// @param[out] distance		If not NULL, receives the distance the ray enters the sphere, or zero if it starts inside.
+		/// @return true if the ray hits the sphere.
+		bool Intersects(const Sphere& sphere, const float max_distance, float* distance = NULL) const;
+
+		/// @brief Tests the ray against a triangle. Both sides of the triangle are hit.
+		/// @param[in] v0, v1, v2		The triangle vertices.
+		/// @param[in] max_distance		Intersections further along the ray than this are ignored.
+		/// @param[out] distance		If not NULL, receives the distance to the intersection.
+		/// @return true if the ray hits the triangle.
+		bool Intersects(const Vector4& v0, const Vector4& v1, const Vector4& v2, const float max_distance, float* distance = NULL) const;
+
+		/// @brief Tests the ray against four triangles at once. Both sides of the triangles are hit.
+		/// @param[in] triangles		The triangles.
+		/// @param[in] max_distance		Intersections further along the ray than this are ignored.
+		/// @param[out] distances		Receives the distance to the intersection for each triangle. Only valid for triangles that were hit.
+		/// @return A mask with bit i set if triangle i was hit.
+		Int32 IntersectsTriangles(const TrianglePacket& triangles, const float max_distance, float distances[4]) const;
+
+	private:
+		/// The start position.
+		Vector4 origin_;
+
+		/// The direction.
+		Vector4 direction_;
+
+		/// The reciprocal of each component of the direction, used by the bounding box test.
+		Vector4 direction_inv_;
+	};
+}
+
+#endif // _GEF_RAY_H
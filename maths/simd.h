@@ -0,0 +1,218 @@
+#ifndef _GEF_SIMD_H
+#define _GEF_SIMD_H
+
+// Selects a 4 wide SIMD backend at compile time.
+//
+// SSE2 is used on x86/x64 (the compiler will VEX encode the same intrinsics when building with /arch:AVX),
+// NEON is used on AArch64 and everything else falls back to plain floats.
+// Define GEF_SIMD_SCALAR to force the scalar fallback, e.g. to compare results against the SIMD path.
+//
+// All the operations here are lane-wise and unfused so every backend produces the same bits as the
+// equivalent scalar code. Loads and stores are unaligned because most of the maths types are written
+// to and read from files as raw structs and so can't be given a stricter alignment than float.
+
+#if !defined(GEF_SIMD_SCALAR)
+	#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define GEF_SIMD_SSE
+	#elif defined(__aarch64__) || defined(_M_ARM64)
+		#define GEF_SIMD_NEON
+	#else
+		#define GEF_SIMD_SCALAR
+	#endif
+#endif
+
+#if defined(GEF_SIMD_SSE)
+	#include <emmintrin.h>
+#elif defined(GEF_SIMD_NEON)
+	#include <arm_neon.h>
+#else
+	#include <math.h>
+#endif
+
+namespace gef
+{
+#if defined(GEF_SIMD_SSE)
+
+	typedef __m128 SimdVector;
+
+	inline SimdVector SimdLoad(const float* values) { return _mm_loadu_ps(values); }
+	inline void SimdStore(float* values, const SimdVector v) { _mm_storeu_ps(values, v); }
+	inline SimdVector SimdSet(const float x, const float y, const float z, const float w) { return _mm_setr_ps(x, y, z, w); }
+	inline SimdVector SimdSplat(const float value) { return _mm_set1_ps(value); }
+	inline SimdVector SimdZero() { return _mm_setzero_ps(); }
+	inline float SimdGetX(const SimdVector v) { return _mm_cvtss_f32(v); }
+
+	inline SimdVector SimdAdd(const SimdVector a, const SimdVector b) { return _mm_add_ps(a, b); }
+	inline SimdVector SimdSub(const SimdVector a, const SimdVector b) { return _mm_sub_ps(a, b); }
+	inline SimdVector SimdMul(const SimdVector a, const SimdVector b) { return _mm_mul_ps(a, b); }
+	inline SimdVector SimdDiv(const SimdVector a, const SimdVector b) { return _mm_div_ps(a, b); }
+	inline SimdVector SimdSqrt(const SimdVector v) { return _mm_sqrt_ps(v); }
+	inline SimdVector SimdMin(const SimdVector a, const SimdVector b) { return _mm_min_ps(a, b); }
+	inline SimdVector SimdMax(const SimdVector a, const SimdVector b) { return _mm_max_ps(a, b); }
+	inline SimdVector SimdNegate(const SimdVector v) { return _mm_xor_ps(v, _mm_set1_ps(-0.0f)); }
+
+	template<int X, int Y, int Z, int W>
+	inline SimdVector SimdSwizzle(const SimdVector v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X)); }
+
+	// returns (a[X], a[Y], b[Z], b[W])
+	template<int X, int Y, int Z, int W>
+	inline SimdVector SimdShuffle(const SimdVector a, const SimdVector b) { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X)); }
+
+	inline void SimdTranspose(SimdVector& r0, SimdVector& r1, SimdVector& r2, SimdVector& r3) { _MM_TRANSPOSE4_PS(r0, r1, r2, r3); }
+
+	// returns the x, y and z components of xyz and the w component of w
+	inline SimdVector SimdSelectXYZ(const SimdVector xyz, const SimdVector w)
+	{
+		const __m128 mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+		return _mm_or_ps(_mm_and_ps(mask, xyz), _mm_andnot_ps(mask, w));
+	}
+
+	// returns a mask with a bit set for each lane where a < b
+	inline int SimdLessMask(const SimdVector a, const SimdVector b) { return _mm_movemask_ps(_mm_cmplt_ps(a, b)); }
+
+#elif defined(GEF_SIMD_NEON)
+
+	typedef float32x4_t SimdVector;
+
+	inline SimdVector SimdLoad(const float* values) { return vld1q_f32(values); }
+	inline void SimdStore(float* values, const SimdVector v) { vst1q_f32(values, v); }
+	inline SimdVector SimdSet(const float x, const float y, const float z, const float w) { const float values[4] = { x, y, z, w }; return vld1q_f32(values); }
+	inline SimdVector SimdSplat(const float value) { return vdupq_n_f32(value); }
+	inline SimdVector SimdZero() { return vdupq_n_f32(0.0f); }
+	inline float SimdGetX(const SimdVector v) { return vgetq_lane_f32(v, 0); }
+
+	inline SimdVector SimdAdd(const SimdVector a, const SimdVector b) { return vaddq_f32(a, b); }
+	inline SimdVector SimdSub(const SimdVector a, const SimdVector b) { return vsubq_f32(a, b); }
+	inline SimdVector SimdMul(const SimdVector a, const SimdVector b) { return vmulq_f32(a, b); }
+	inline SimdVector SimdDiv(const SimdVector a, const SimdVector b) { return vdivq_f32(a, b); }
+	inline SimdVector SimdSqrt(const SimdVector v) { return vsqrtq_f32(v); }
+	inline SimdVector SimdMin(const SimdVector a, const SimdVector b) { return vminq_f32(a, b); }
+	inline SimdVector SimdMax(const SimdVector a, const SimdVector b) { return vmaxq_f32(a, b); }
+	inline SimdVector SimdNegate(const SimdVector v) { return vnegq_f32(v); }
+
+	template<int X, int Y, int Z, int W>
+	inline SimdVector SimdSwizzle(const SimdVector v)
+	{
+		float values[4], result[4];
+		vst1q_f32(values, v);
+		result[0] = values[X];
+		result[1] = values[Y];
+		result[2] = values[Z];
+		result[3] = values[W];
+		return vld1q_f32(result);
+	}
+
+	// returns (a[X], a[Y], b[Z], b[W])
+	template<int X, int Y, int Z, int W>
+	inline SimdVector SimdShuffle(const SimdVector a, const SimdVector b)
+	{
+		float a_values[4], b_values[4], result[4];
+		vst1q_f32(a_values, a);
+		vst1q_f32(b_values, b);
+		result[0] = a_values[X];
+		result[1] = a_values[Y];
+		result[2] = b_values[Z];
+		result[3] = b_values[W];
+		return vld1q_f32(result);
+	}
+
+	inline void SimdTranspose(SimdVector& r0, SimdVector& r1, SimdVector& r2, SimdVector& r3)
+	{
+		const float32x4x2_t t01 = vtrnq_f32(r0, r1);
+		const float32x4x2_t t23 = vtrnq_f32(r2, r3);
+		r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+		r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+		r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+		r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+	}
+
+	// returns the x, y and z components of xyz and the w component of w
+	inline SimdVector SimdSelectXYZ(const SimdVector xyz, const SimdVector w)
+	{
+		const uint32_t mask_values[4] = { 0xffffffff, 0xffffffff, 0xffffffff, 0 };
+		return vbslq_f32(vld1q_u32(mask_values), xyz, w);
+	}
+
+	// returns a mask with a bit set for each lane where a < b
+	inline int SimdLessMask(const SimdVector a, const SimdVector b)
+	{
+		const uint32_t bit_values[4] = { 1, 2, 4, 8 };
+		return (int)vaddvq_u32(vandq_u32(vcltq_f32(a, b), vld1q_u32(bit_values)));
+	}
+
+#else
+
+	struct SimdVector
+	{
+		float v[4];
+	};
+
+	inline SimdVector SimdLoad(const float* values) { SimdVector result = { { values[0], values[1], values[2], values[3] } }; return result; }
+	inline void SimdStore(float* values, const SimdVector v) { values[0] = v.v[0]; values[1] = v.v[1]; values[2] = v.v[2]; values[3] = v.v[3]; }
+	inline SimdVector SimdSet(const float x, const float y, const float z, const float w) { SimdVector result = { { x, y, z, w } }; return result; }
+	inline SimdVector SimdSplat(const float value) { return SimdSet(value, value, value, value); }
+	inline SimdVector SimdZero() { return SimdSplat(0.0f); }
+	inline float SimdGetX(const SimdVector v) { return v.v[0]; }
+
+	inline SimdVector SimdAdd(const SimdVector a, const SimdVector b) { return SimdSet(a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]); }
+	inline SimdVector SimdSub(const SimdVector a, const SimdVector b) { return SimdSet(a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]); }
+	inline SimdVector SimdMul(const SimdVector a, const SimdVector b) { return SimdSet(a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]); }
+	inline SimdVector SimdDiv(const SimdVector a, const SimdVector b) { return SimdSet(a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3]); }
+	inline SimdVector SimdSqrt(const SimdVector v) { return SimdSet(sqrtf(v.v[0]), sqrtf(v.v[1]), sqrtf(v.v[2]), sqrtf(v.v[3])); }
+	inline SimdVector SimdMin(const SimdVector a, const SimdVector b) { return SimdSet(a.v[0] < b.v[0] ? a.v[0] : b.v[0], a.v[1] < b.v[1] ? a.v[1] : b.v[1], a.v[2] < b.v[2] ? a.v[2] : b.v[2], a.v[3] < b.v[3] ? a.v[3] : b.v[3]); }
+	inline SimdVector SimdMax(const SimdVector a, const SimdVector b) { return SimdSet(a.v[0] > b.v[0] ? a.v[0] : b.v[0], a.v[1] > b.v[1] ? a.v[1] : b.v[1], a.v[2] > b.v[2] ? a.v[2] : b.v[2], a.v[3] > b.v[3] ? a.v[3] : b.v[3]); }
+	inline SimdVector SimdNegate(const SimdVector v) { return SimdSet(-v.v[0], -v.v[1], -v.v[2], -v.v[3]); }
+
+	template<int X, int Y, int Z, int W>
+	inline SimdVector SimdSwizzle(const SimdVector v) { return SimdSet(v.v[X], v.v[Y], v.v[Z], v.v[W]); }
+
+	// returns (a[X], a[Y], b[Z], b[W])
+	template<int X, int Y, int Z, int W>
+	inline SimdVector SimdShuffle(const SimdVector a, const SimdVector b) { return SimdSet(a.v[X], a.v[Y], b.v[Z], b.v[W]); }
+
+	inline void SimdTranspose(SimdVector& r0, SimdVector& r1, SimdVector& r2, SimdVector& r3)
+	{
+		const SimdVector t0 = SimdSet(r0.v[0], r1.v[0], r2.v[0], r3.v[0]);
+		const SimdVector t1 = SimdSet(r0.v[1], r1.v[1], r2.v[1], r3.v[1]);
+		const SimdVector t2 = SimdSet(r0.v[2], r1.v[2], r2.v[2], r3.v[2]);
+		const SimdVector t3 = SimdSet(r0.v[3], r1.v[3], r2.v[3], r3.v[3]);
+		r0 = t0;
+		r1 = t1;
+		r2 = t2;
+		r3 = t3;
+	}
+
+	// returns the x, y and z components of xyz and the w component of w
+	inline SimdVector SimdSelectXYZ(const SimdVector xyz, const SimdVector w) { return SimdSet(xyz.v[0], xyz.v[1], xyz.v[2], w.v[3]); }
+
+	// returns a mask with a bit set for each lane where a < b
+	inline int SimdLessMask(const SimdVector a, const SimdVector b)
+	{
+		return (a.v[0] < b.v[0] ? 1 : 0) | (a.v[1] < b.v[1] ? 2 : 0) | (a.v[2] < b.v[2] ? 4 : 0) | (a.v[3] < b.v[3] ? 8 : 0);
+	}
+
+#endif
+
+	inline SimdVector SimdSplatX(const SimdVector v) { return SimdSwizzle<0, 0, 0, 0>(v); }
+	inline SimdVector SimdSplatY(const SimdVector v) { return SimdSwizzle<1, 1, 1, 1>(v); }
+	inline SimdVector SimdSplatZ(const SimdVector v) { return SimdSwizzle<2, 2, 2, 2>(v); }
+	inline SimdVector SimdSplatW(const SimdVector v) { return SimdSwizzle<3, 3, 3, 3>(v); }
+
+	// a*b + c, deliberately not fused so the result matches the scalar code
+	inline SimdVector SimdMulAdd(const SimdVector a, const SimdVector b, const SimdVector c) { return SimdAdd(SimdMul(a, b), c); }
+
+	// returns the x, y and z components of v with w set to zero
+	inline SimdVector SimdZeroW(const SimdVector v) { return SimdSelectXYZ(v, SimdZero()); }
+
+	// transforms the row vector v by the four matrix rows r0..r3
+	// result = v.x*r0 + v.y*r1 + v.z*r2 + v.w*r3
+	inline SimdVector SimdTransform(const SimdVector v, const SimdVector r0, const SimdVector r1, const SimdVector r2, const SimdVector r3)
+	{
+		SimdVector result = SimdMul(SimdSplatX(v), r0);
+		result = SimdMulAdd(SimdSplatY(v), r1, result);
+		result = SimdMulAdd(SimdSplatZ(v), r2, result);
+		return SimdMulAdd(SimdSplatW(v), r3, result);
+	}
+}
+
+#endif // _GEF_SIMD_H
@@ -22,9 +22,8 @@ namespace gef
 	void Vector4::Normalise()
 	{
 		float length = Length();
-		values_[0] = values_[0] / length;
-		values_[1] = values_[1] / length;
-		values_[2] = values_[2] / length;
+		const SimdVector v = SimdLoad(values_);
+		SimdStore(values_, SimdSelectXYZ(SimdDiv(v, SimdSplat(length)), v));
 	}
 
 	float Vector4::DotProduct(const Vector4& _vec) const
@@ -36,9 +35,13 @@ namespace gef
 	{
 		Vector4 result;
 
-		result.set_x(values_[1]*_vec.z() - values_[2]*_vec.y());
-		result.set_y(values_[2]*_vec.x() - values_[0]*_vec.z());
-		result.set_z(values_[0]*_vec.y() - values_[1]*_vec.x());
+		const SimdVector a = SimdLoad(values_);
+		const SimdVector b = SimdLoad(_vec.values_);
+		const SimdVector a_yzx = SimdSwizzle<1, 2, 0, 3>(a);
+		const SimdVector a_zxy = SimdSwizzle<2, 0, 1, 3>(a);
+		const SimdVector b_yzx = SimdSwizzle<1, 2, 0, 3>(b);
+		const SimdVector b_zxy = SimdSwizzle<2, 0, 1, 3>(b);
+		SimdStore(result.values_, SimdZeroW(SimdSub(SimdMul(a_yzx, b_zxy), SimdMul(a_zxy, b_yzx))));
 
 		return result;
 	}
@@ -55,11 +58,14 @@ namespace gef
 
 	const Vector4 Vector4::Transform(const class Matrix44& _mat) const
 	{
-		Vector4 result = Vector4(0.0f, 0.0f, 0.0f);
+		Vector4 result;
 
-		result.set_x(values_[0]*_mat.m(0,0)+values_[1]*_mat.m(1,0)+values_[2]*_mat.m(2,0)+_mat.m(3,0));
-		result.set_y(values_[0]*_mat.m(0,1)+values_[1]*_mat.m(1,1)+values_[2]*_mat.m(2,1)+_mat.m(3,1));
-		result.set_z(values_[0]*_mat.m(0,2)+values_[1]*_mat.m(1,2)+values_[2]*_mat.m(2,2)+_mat.m(3,2));
+		const SimdVector v = SimdLoad(values_);
+		SimdVector transformed = SimdMul(SimdSplatX(v), SimdLoad(_mat.GetRow(0).values_));
+		transformed = SimdMulAdd(SimdSplatY(v), SimdLoad(_mat.GetRow(1).values_), transformed);
+		transformed = SimdMulAdd(SimdSplatZ(v), SimdLoad(_mat.GetRow(2).values_), transformed);
+		transformed = SimdAdd(transformed, SimdLoad(_mat.GetRow(3).values_));
+		SimdStore(result.values_, SimdZeroW(transformed));
 
 		return result;
 	}
@@ -88,11 +94,13 @@ namespace gef
 
 	const Vector4 Vector4::TransformNoTranslation(const class Matrix44& _mat) const
 	{
-		Vector4 result = Vector4(0.0f, 0.0f, 0.0f);
+		Vector4 result;
 
-		result.set_x(values_[0]*_mat.m(0,0)+values_[1]*_mat.m(1,0)+values_[2]*_mat.m(2,0));
-		result.set_y(values_[0]*_mat.m(0,1)+values_[1]*_mat.m(1,1)+values_[2]*_mat.m(2,1));
-		result.set_z(values_[0]*_mat.m(0,2)+values_[1]*_mat.m(1,2)+values_[2]*_mat.m(2,2));
+		const SimdVector v = SimdLoad(values_);
+		SimdVector transformed = SimdMul(SimdSplatX(v), SimdLoad(_mat.GetRow(0).values_));
+		transformed = SimdMulAdd(SimdSplatY(v), SimdLoad(_mat.GetRow(1).values_), transformed);
+		transformed = SimdMulAdd(SimdSplatZ(v), SimdLoad(_mat.GetRow(2).values_), transformed);
+		SimdStore(result.values_, SimdZeroW(transformed));
 
 		return result;
 	}
@@ -101,10 +109,8 @@ namespace gef
 	{
 		Vector4 result;
 
-		result.set_x(values_[0] * _mat.m(0, 0) + values_[1] * _mat.m(1, 0) + values_[2] * _mat.m(2, 0) + values_[3] * _mat.m(3, 0));
-		result.set_y(values_[0] * _mat.m(0, 1) + values_[1] * _mat.m(1, 1) + values_[2] * _mat.m(2, 1) + values_[3] * _mat.m(3, 1));
-		result.set_z(values_[0] * _mat.m(0, 2) + values_[1] * _mat.m(1, 2) + values_[2] * _mat.m(2, 2) + values_[3] * _mat.m(3, 2));
-		result.set_w(values_[0] * _mat.m(0, 3) + values_[1] * _mat.m(1, 3) + values_[2] * _mat.m(2, 3) + values_[3] * _mat.m(3, 3));
+		SimdStore(result.values_, SimdTransform(SimdLoad(values_),
+			SimdLoad(_mat.GetRow(0).values_), SimdLoad(_mat.GetRow(1).values_), SimdLoad(_mat.GetRow(2).values_), SimdLoad(_mat.GetRow(3).values_)));
 
 		return result;
 	}
@@ -113,8 +119,8 @@ namespace gef
 
 	void Vector4::Lerp(const Vector4& start, const Vector4& end, const float time)
 	{
-		values_[0] = gef::Lerp(start.x(), end.x(), time);
-		values_[1] = gef::Lerp(start.y(), end.y(), time);
-		values_[2] = gef::Lerp(start.z(), end.z(), time);
+		// same operation order as gef::Lerp so results match the scalar version
+		const SimdVector lerped = SimdAdd(SimdMul(SimdLoad(start.values_), SimdSplat(1.0f - time)), SimdMul(SimdSplat(time), SimdLoad(end.values_)));
+		SimdStore(values_, SimdSelectXYZ(lerped, SimdLoad(values_)));
 	}
 }
\ No newline at end of file
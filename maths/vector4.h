@@ -1,6 +1,7 @@
 #ifndef _GEF_VECTOR3_H
 #define _GEF_VECTOR3_H
 
+#include <maths/simd.h>
 
 namespace gef
 {
@@ -38,7 +39,7 @@ public:
 	const Vector4 TransformW(const class Matrix44& _mat) const;
 	const Vector4 CrossProduct3(const Vector4& v2, const Vector4& v3) const;
 
-	const float* float_ptr() { return &values_[0]; }
+	const float* float_ptr() const { return &values_[0]; }
 
 
 	float x() const;
@@ -52,14 +53,18 @@ public:
 	void set_value(float x, float y, float z);
 	void set_value(float x, float y, float z, float w);
 protected:
-	// store values as an array of floats so the implementation
-	// can be changed at a later date to support use SIMD instructions
+	// store values as an array of floats so the layout stays the same whichever
+	// SIMD backend is selected in maths/simd.h. Vector4 is read and written
+	// directly as part of the scene file structures so it must remain 16 bytes
+	// with no alignment requirement beyond that of float
 	float values_[4];
 public:
 	static const Vector4 kZero;
 	static const Vector4 kOne;
 };
 
+static_assert(sizeof(Vector4) == 4*sizeof(float), "Vector4 layout is part of the scene file format");
+
 }
 
 #include "maths/vector4.inl"
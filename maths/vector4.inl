@@ -29,57 +29,61 @@ namespace gef
 
 	inline const Vector4 Vector4::operator-(const Vector4& _vec) const
 	{
-		return Vector4(values_[0] - _vec.x(), values_[1] - _vec.y(), values_[2] - _vec.z());
+		Vector4 result;
+		SimdStore(result.values_, SimdZeroW(SimdSub(SimdLoad(values_), SimdLoad(_vec.values_))));
+		return result;
 	}
 
 	inline const Vector4 Vector4::operator+(const Vector4& _vec) const
 	{
-		return Vector4(values_[0] + _vec.x(), values_[1] + _vec.y(), values_[2] + _vec.z());
+		Vector4 result;
+		SimdStore(result.values_, SimdZeroW(SimdAdd(SimdLoad(values_), SimdLoad(_vec.values_))));
+		return result;
 	}
 
 	inline Vector4& Vector4::operator+=(const Vector4& _vec)
 	{
-		values_[0] += _vec.x();
-		values_[1] += _vec.y();
-		values_[2] += _vec.z();
+		const SimdVector v = SimdLoad(values_);
+		SimdStore(values_, SimdSelectXYZ(SimdAdd(v, SimdLoad(_vec.values_)), v));
 
 		return *this;
 	}
 
 	inline Vector4& Vector4::operator-=(const Vector4& _vec)
 	{
-		values_[0] -= _vec.x();
-		values_[1] -= _vec.y();
-		values_[2] -= _vec.z();
+		const SimdVector v = SimdLoad(values_);
+		SimdStore(values_, SimdSelectXYZ(SimdSub(v, SimdLoad(_vec.values_)), v));
 
 		return *this;
 	}
 
 	inline const Vector4 Vector4::operator*(const float _scalar) const
 	{
-		return Vector4(values_[0] * _scalar, values_[1] * _scalar, values_[2] * _scalar);
+		Vector4 result;
+		SimdStore(result.values_, SimdZeroW(SimdMul(SimdLoad(values_), SimdSplat(_scalar))));
+		return result;
 	}
 
 	inline const Vector4 Vector4::operator/(const float _scalar) const
 	{
-		return Vector4(values_[0] / _scalar, values_[1] / _scalar, values_[2] / _scalar);
+		Vector4 result;
+		SimdStore(result.values_, SimdZeroW(SimdDiv(SimdLoad(values_), SimdSplat(_scalar))));
+		return result;
 	}
 	
 
 	inline Vector4& Vector4::operator*=(const float _scalar)
 	{
-		values_[0] *= _scalar;
-		values_[1] *= _scalar;
-		values_[2] *= _scalar;
+		const SimdVector v = SimdLoad(values_);
+		SimdStore(values_, SimdSelectXYZ(SimdMul(v, SimdSplat(_scalar)), v));
 
 		return *this;
 	}
 
 	inline Vector4& Vector4::operator/=(const float _scalar)
 	{
-		values_[0] /= _scalar;
-		values_[1] /= _scalar;
-		values_[2] /= _scalar;
+		const SimdVector v = SimdLoad(values_);
+		SimdStore(values_, SimdSelectXYZ(SimdDiv(v, SimdSplat(_scalar)), v));
 
 		return *this;
 	}
@@ -91,7 +95,9 @@ namespace gef
 
 	inline const Vector4 Vector4::operator-() const
 	{
-		return Vector4(-values_[0], -values_[1], -values_[2]);
+		Vector4 result;
+		SimdStore(result.values_, SimdZeroW(SimdNegate(SimdLoad(values_))));
+		return result;
 	}
 
 	inline float Vector4::x() const
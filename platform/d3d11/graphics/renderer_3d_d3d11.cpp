@@ -212,6 +212,7 @@ namespace gef
 
 						//only set default shader data if current shader is the default shader
 						shader_->SetMaterialData(material);
+						shader_->SetPrimitiveData(*primitive);
 
 						// GRC FIXME - probably want to split variable data into scene, object, primitive[material?] based
 						// rather than set all variables per primitive
@@ -284,6 +285,7 @@ namespace gef
 
 						//only set default shader data if current shader is the default shader
 						shader_->SetMaterialData(material);
+						shader_->SetPrimitiveData(*primitive);
 
 						// GRC FIXME - probably want to split variable data into scene, object, primitive[material?] based
 						// rather than set all variables per primitive
@@ -185,7 +185,7 @@ namespace gef
 		if (SUCCEEDED(hresult))
 		{
 			if (vs_data)
-				memcpy(vs_data, vertex_shader_variable_data_, vertex_shader_variable_data_size_);
+				memcpy(vs_data, vertex_shader_variable_data_, vertex_shader_variable_upload_size_);
 			if (ps_data)
 				memcpy(ps_data, pixel_shader_variable_data_, pixel_shader_variable_data_size_);
 
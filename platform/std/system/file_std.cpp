@@ -7,6 +7,9 @@
 
 #include "file_std.h"
 #include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 
 
 
@@ -18,7 +21,9 @@ namespace gef
     }
 
 	FileStd::FileStd()
-	:file_handle_(NULL)
+	:file_handle_(NULL),
+	mapped_data_(NULL),
+	mapped_size_(0)
 	{
 
 	}
@@ -27,6 +32,8 @@ namespace gef
 	{
 		if(file_handle_)
 			Close();
+
+		Unmap();
 	}
 
 	bool FileStd::Open(const char* const filename)
@@ -83,6 +90,42 @@ namespace gef
 			return false;
 	}
 
+	bool FileStd::Map(const void** data, Int32& size)
+	{
+		Unmap();
+
+#ifndef _WIN32
+		struct stat file_status;
+		if(file_handle_ && fstat(fileno(file_handle_), &file_status) == 0 && file_status.st_size > 0 && file_status.st_size <= 0x7fffffff)
+		{
+			void* mapped_data = mmap(NULL, (size_t)file_status.st_size, PROT_READ, MAP_PRIVATE, fileno(file_handle_), 0);
+			if(mapped_data != MAP_FAILED)
+			{
+				mapped_data_ = mapped_data;
+				mapped_size_ = (size_t)file_status.st_size;
+				*data = mapped_data_;
+				size = (Int32)mapped_size_;
+				return true;
+			}
+		}
+#endif
+
+		// empty files can't be mapped, and some file systems don't support it
+		return File::Map(data, size);
+	}
+
+	void FileStd::Unmap()
+	{
+#ifndef _WIN32
+		if(mapped_data_)
+			munmap(mapped_data_, mapped_size_);
+#endif
+		mapped_data_ = NULL;
+		mapped_size_ = 0;
+
+		File::Unmap();
+	}
+
     bool FileStd::Exists(const char *const filename)
     {
         struct stat buffer;
@@ -31,8 +31,16 @@ namespace gef
 
         bool Exists(const char *const filename) override;
 
+		/// @brief Maps the file in to memory with mmap, so its pages are only read when they're first used.
+		bool Map(const void** data, Int32& size) override;
+		void Unmap() override;
+
     private:
 		FILE* file_handle_;
+
+		/// The memory mapped by Map, or NULL if the default Map was used.
+		void* mapped_data_;
+		size_t mapped_size_;
 	};
 }
 
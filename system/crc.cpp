@@ -31,6 +31,36 @@ namespace gef
 	}
 
 
+	// the residual after clocking in each possible byte, starting from zero
+	class CRCTable
+	{
+	public:
+		CRCTable()
+		{
+			for (UInt32 byte = 0; byte < 256; ++byte)
+			{
+				const char byte_value = (char)byte;
+				CRC crc(0);
+				crc.Update(&byte_value, 1);
+				values[byte] = ~crc.GetU32();
+			}
+		}
+
+		UInt32 values[256];
+	};
+
+	UInt32 CRC::GetCRC(const void* data, const UInt32 size)
+	{
+		static const CRCTable table;
+
+		UInt32 residual = ~0u;
+		const UInt8* bytes = static_cast<const UInt8*>(data);
+		for (UInt32 byte_num = 0; byte_num < size; ++byte_num)
+			residual = table.values[(residual ^ bytes[byte_num]) & 0xff] ^ (residual >> 8);
+
+		return ~residual;
+	}
+
 	CRC::CRC(UInt32 _r) : r(_r)
 	{
 
@@ -9,9 +9,15 @@ namespace gef
 
 	class CRC
 	{
+		friend class CRCTable;
 	public:
 		static UInt32 GetCRC(const char* _pString);
 		static UInt32 GetICRC(const char* _pString);
+
+		/// @brief Calculates the same CRC as GetCRC for a block of data, a byte at a time from a table rather than a bit at a time.
+		/// @param[in] data		The data.
+		/// @param[in] size		The size of the data in bytes.
+		static UInt32 GetCRC(const void* data, const UInt32 size);
 		CRC(UInt32 _r=~0);
 	private:
 		void Update(const char *pbuf, int len, bool toUpper = false); // update crc residual 
@@ -4,13 +4,52 @@
 
 namespace gef
 {
-	File::File()
+	File::File() :
+		map_buffer_(NULL)
 	{
 
 	}
 
 	File::~File()
 	{
+		free(map_buffer_);
+	}
+
+	bool File::Map(const void** data, Int32& size)
+	{
+		Unmap();
+
+		size = 0;
+		bool success = GetSize(size);
+		if(success)
+			success = Seek(SF_Start, 0);
+
+		if(success)
+		{
+			// allocate at least one byte so an empty file still gives a valid pointer
+			map_buffer_ = malloc(size > 0 ? size : 1);
+			success = map_buffer_ != NULL;
+		}
+
+		if(success)
+		{
+			Int32 bytes_read = 0;
+			success = Read(map_buffer_, size, bytes_read);
+			if(success)
+				success = bytes_read == size;
+		}
+
+		if(!success)
+			Unmap();
+
+		*data = map_buffer_;
+		return success;
+	}
+
+	void File::Unmap()
+	{
+		free(map_buffer_);
+		map_buffer_ = NULL;
 	}
 
 
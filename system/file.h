@@ -29,9 +29,23 @@ namespace gef
 		virtual bool GetSize(Int32 &size) = 0;
 		bool Load(const char* const filename, void** buffer, Int32& buffer_size);
 
+		/// @brief Gives read-only access to the whole of the open file without copying it in to a buffer, where the platform can map files in to memory.
+		/// Elsewhere the file is read in to a buffer owned by the File.
+		/// @param[out] data	Receives the file contents. Valid until Unmap is called or the File is deleted. Closing the file doesn't release it.
+		/// @param[out] size	Receives the size of the file in bytes.
+		/// @return false if the file couldn't be mapped or read.
+		/// @note Any previous mapping is released first.
+		virtual bool Map(const void** data, Int32& size);
+
+		/// @brief Releases the file contents given by Map.
+		virtual void Unmap();
+
 		static File* Create();
 	protected:
 		File();
+
+		/// The file contents read by the default Map.
+		void* map_buffer_;
 	};
 }
 
@@ -7,4 +7,11 @@ namespace gef
 		setg(buffer, buffer, buffer + size);
 		setp(buffer, buffer + size);
 	}
+
+	MemoryStreamBuffer::MemoryStreamBuffer(const void* buffer, size_t size)
+	{
+		// the get area is only read from, and there's no put area
+		char* read_buffer = const_cast<char*>(static_cast<const char*>(buffer));
+		setg(read_buffer, read_buffer, read_buffer + size);
+	}
 }
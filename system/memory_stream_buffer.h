@@ -9,6 +9,9 @@ namespace gef
 	{
 	public:
 		MemoryStreamBuffer(char* buffer, size_t size);
+
+		/// @brief Reads from memory that mustn't be written to, such as the contents of a File::Map. Nothing can be written to the stream.
+		MemoryStreamBuffer(const void* buffer, size_t size);
 	};
 }
 
@@ -0,0 +1,120 @@
+#include <system/worker_pool.h>
+
+namespace gef
+{
+	WorkerPool::WorkerPool() :
+		item_count_(0),
+		function_(NULL),
+		user_data_(NULL),
+		next_item_(0),
+		generation_(0),
+		busy_worker_count_(0),
+		quit_(false)
+	{
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		CleanUp();
+	}
+
+	void WorkerPool::Init(const Int32 worker_count)
+	{
+		CleanUp();
+
+		quit_ = false;
+		workers_.reserve(worker_count);
+		for (Int32 worker_num = 0; worker_num < worker_count; ++worker_num)
+			workers_.push_back(std::thread(&WorkerPool::WorkerMain, this, generation_));
+	}
+
+	void WorkerPool::CleanUp()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			quit_ = true;
+		}
+		wake_.notify_all();
+
+		for (std::vector<std::thread>::iterator worker_iter = workers_.begin(); worker_iter != workers_.end(); ++worker_iter)
+			worker_iter->join();
+
+		workers_.clear();
+	}
+
+	void WorkerPool::Run(const Int32 item_count, ItemFunction function, void* user_data)
+	{
+		if (item_count <= 0)
+			return;
+
+		item_count_ = item_count;
+		function_ = function;
+		user_data_ = user_data;
+		next_item_ = 0;
+
+		// a single item isn't worth waking the workers for
+		const bool use_workers = !workers_.empty() && item_count > 1;
+		if (use_workers)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				busy_worker_count_ = (Int32)workers_.size();
+				++generation_;
+			}
+			wake_.notify_all();
+		}
+
+		// the calling thread takes items as well rather than just waiting
+		RunItems();
+
+		if (use_workers)
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			while (busy_worker_count_ > 0)
+				finished_.wait(lock);
+		}
+	}
+
+	Int32 WorkerPool::GetDefaultWorkerCount()
+	{
+		// hardware_concurrency can return zero if it doesn't know
+		const Int32 thread_count = (Int32)std::thread::hardware_concurrency();
+		return thread_count > 1 ? thread_count - 1 : 0;
+	}
+
+	void WorkerPool::RunItems()
+	{
+		Int32 item_index = next_item_++;
+		while (item_index < item_count_)
+		{
+			function_(user_data_, item_index);
+			item_index = next_item_++;
+		}
+	}
+
+	void WorkerPool::WorkerMain(UInt32 generation)
+	{
+		// generation is the value when the thread was created, so a worker started after a previous Init doesn't run the old items
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				while (!quit_ && generation == generation_)
+					wake_.wait(lock);
+
+				if (quit_)
+					return;
+
+				generation = generation_;
+			}
+
+			RunItems();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (--busy_worker_count_ == 0)
+					finished_.notify_one();
+			}
+		}
+	}
+}
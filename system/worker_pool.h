@@ -0,0 +1,76 @@
+#ifndef _GEF_WORKER_POOL_H
+#define _GEF_WORKER_POOL_H
+
+#include <gef.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace gef
+{
+	/**
+	A set of worker threads that run a number of items alongside the calling thread, e.g. the jobs of a PoseUpdateBatch or
+	the vertex chunks of a CpuSkinning. The threads are started once by Init and sleep between calls to Run.
+	Items are taken one at a time, so items that vary in cost are still shared out evenly.
+	*/
+	class WorkerPool
+	{
+	public:
+		/// Called once for each item. The items of one Run are called on different threads at the same time,
+		/// so each one must only write to its own data, or lock anything it shares.
+		typedef void (*ItemFunction)(void* user_data, const Int32 item_index);
+
+		WorkerPool();
+		~WorkerPool();
+
+		/// @brief Starts the worker threads.
+		/// @param[in] worker_count		The number of worker threads. Zero runs every item on the thread that calls Run.
+		/// @note Anything from a previous Init is cleaned up first.
+		void Init(const Int32 worker_count);
+
+		/// @brief Stops the worker threads.
+		void CleanUp();
+
+		/// @brief Runs the items on the worker threads and the calling thread, and waits for them all to finish.
+		/// @param[in] item_count	The number of items, numbered from zero.
+		/// @param[in] function		Called for each item.
+		/// @param[in] user_data	Passed to the function.
+		/// @note Must not be called by more than one thread at once, or by an item function.
+		void Run(const Int32 item_count, ItemFunction function, void* user_data);
+
+		/// @brief Gets the number of worker threads that can be used by this machine in addition to the calling thread.
+		static Int32 GetDefaultWorkerCount();
+
+		inline Int32 worker_count() const { return (Int32)workers_.size(); }
+
+	private:
+		WorkerPool(const WorkerPool&);
+		WorkerPool& operator=(const WorkerPool&);
+
+		void RunItems();
+		void WorkerMain(UInt32 generation);
+
+		std::vector<std::thread> workers_;
+
+		/// The arguments of the Run call being run.
+		Int32 item_count_;
+		ItemFunction function_;
+		void* user_data_;
+
+		/// Index of the next item to be taken by a thread.
+		std::atomic<Int32> next_item_;
+
+		/// Protects the members below. wake_ is signalled when generation_ changes or quit_ is set,
+		/// finished_ when the last busy worker finishes.
+		std::mutex mutex_;
+		std::condition_variable wake_;
+		std::condition_variable finished_;
+		UInt32 generation_;
+		Int32 busy_worker_count_;
+		bool quit_;
+	};
+}
+
+#endif // _GEF_WORKER_POOL_H
@@ -0,0 +1,209 @@
+// Checks that Vector4 gives the same results whichever backend maths/simd.h selects.
+//
+// Each operation is compared against plain float code that does the same arithmetic in the same order,
+// so the test passes on a backend only if it is bit-exact with the scalar code. Build and run it once for
+// the native SIMD backend (SSE2 on x86/x64, NEON on AArch64) and once with the scalar fallback, e.g.
+//
+//   g++ -std=c++14 -O2 -ffp-contract=off -I. tests/maths/vector4_simd_test.cpp maths/*.cpp -o vector4_simd_test
+//   g++ -std=c++14 -O2 -ffp-contract=off -DGEF_SIMD_SCALAR -I. tests/maths/vector4_simd_test.cpp maths/*.cpp -o vector4_simd_test_scalar
+//
+// from the root of the repository. Contraction in to fused multiply-adds must be off, as it would change
+// the rounding of the scalar code but not the SIMD code. The program returns non-zero if any check fails.
+
+#include <maths/vector4.h>
+#include <maths/matrix44.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using gef::Vector4;
+using gef::Matrix44;
+
+namespace
+{
+	// the largest difference allowed in units in the last place. The backends only use IEEE add, subtract, multiply,
+	// divide and square root, which are correctly rounded, so normalising is exact as well. A backend that used a
+	// reciprocal or reciprocal square root estimate would need a tolerance here instead
+	const UInt32 kExactUlps = 0;
+	const UInt32 kNormaliseUlps = 0;
+
+	const Int32 kIterationCount = 100000;
+
+	Int32 g_failure_count = 0;
+
+	UInt32 FloatBits(const float value)
+	{
+		UInt32 bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	// maps a float's bits on to a line so the distance between two floats is the number of floats between them
+	Int32 OrderedBits(const float value)
+	{
+		const Int32 bits = (Int32)FloatBits(value);
+		return bits < 0 ? (Int32)0x80000000 - bits : bits;
+	}
+
+	UInt32 UlpDistance(const float a, const float b)
+	{
+		const Int32 a_bits = OrderedBits(a);
+		const Int32 b_bits = OrderedBits(b);
+		return a_bits > b_bits ? (UInt32)a_bits - (UInt32)b_bits : (UInt32)b_bits - (UInt32)a_bits;
+	}
+
+	void Check(const char* operation, const Int32 iteration, const float* result, const float* expected, const Int32 count, const UInt32 max_ulps)
+	{
+		for (Int32 component_num = 0; component_num < count; ++component_num)
+		{
+			if (UlpDistance(result[component_num], expected[component_num]) > max_ulps)
+			{
+				// only the first few failures are shown
+				if (g_failure_count < 20)
+					printf("%s: iteration %d component %d is %.9g (0x%08x), expected %.9g (0x%08x)\n", operation, iteration, component_num,
+						result[component_num], FloatBits(result[component_num]), expected[component_num], FloatBits(expected[component_num]));
+				++g_failure_count;
+			}
+		}
+	}
+
+	void Check(const char* operation, const Int32 iteration, const Vector4& result, const float* expected, const UInt32 max_ulps)
+	{
+		Check(operation, iteration, result.float_ptr(), expected, 4, max_ulps);
+	}
+
+	float RandomFloat()
+	{
+		return ((float)rand() / (float)RAND_MAX) * 20.0f - 10.0f;
+	}
+}
+
+int main()
+{
+	srand(1);
+
+	for (Int32 iteration = 0; iteration < kIterationCount; ++iteration)
+	{
+		float a[4], b[4], m[16], expected[4];
+		for (Int32 component_num = 0; component_num < 4; ++component_num)
+		{
+			a[component_num] = RandomFloat();
+			b[component_num] = RandomFloat();
+		}
+		for (Int32 element_num = 0; element_num < 16; ++element_num)
+			m[element_num] = RandomFloat();
+
+		// keep the scalar away from zero so dividing by it is well defined
+		float scalar = RandomFloat();
+		if (fabsf(scalar) < 0.01f)
+			scalar = 0.01f;
+
+		const Vector4 va(a[0], a[1], a[2], a[3]);
+		const Vector4 vb(b[0], b[1], b[2], b[3]);
+		const Matrix44 matrix(m);
+
+		// results that only have x, y and z clear w, and the compound assignments leave it as it was
+		for (Int32 component_num = 0; component_num < 3; ++component_num)
+			expected[component_num] = a[component_num] + b[component_num];
+		expected[3] = 0.0f;
+		Check("add", iteration, va + vb, expected, kExactUlps);
+
+		Vector4 compound = va;
+		compound += vb;
+		expected[3] = a[3];
+		Check("add assign", iteration, compound, expected, kExactUlps);
+
+		for (Int32 component_num = 0; component_num < 3; ++component_num)
+			expected[component_num] = a[component_num] - b[component_num];
+		expected[3] = 0.0f;
+		Check("subtract", iteration, va - vb, expected, kExactUlps);
+
+		compound = va;
+		compound -= vb;
+		expected[3] = a[3];
+		Check("subtract assign", iteration, compound, expected, kExactUlps);
+
+		for (Int32 component_num = 0; component_num < 3; ++component_num)
+			expected[component_num] = a[component_num] * scalar;
+		expected[3] = 0.0f;
+		Check("multiply", iteration, va * scalar, expected, kExactUlps);
+
+		compound = va;
+		compound *= scalar;
+		expected[3] = a[3];
+		Check("multiply assign", iteration, compound, expected, kExactUlps);
+
+		for (Int32 component_num = 0; component_num < 3; ++component_num)
+			expected[component_num] = a[component_num] / scalar;
+		expected[3] = 0.0f;
+		Check("divide", iteration, va / scalar, expected, kExactUlps);
+
+		compound = va;
+		compound /= scalar;
+		expected[3] = a[3];
+		Check("divide assign", iteration, compound, expected, kExactUlps);
+
+		for (Int32 component_num = 0; component_num < 3; ++component_num)
+			expected[component_num] = -a[component_num];
+		expected[3] = 0.0f;
+		Check("negate", iteration, -va, expected, kExactUlps);
+
+		expected[0] = a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+		const float dot_product = va.DotProduct(vb);
+		Check("dot product", iteration, &dot_product, expected, 1, kExactUlps);
+
+		expected[0] = a[1]*b[2] - a[2]*b[1];
+		expected[1] = a[2]*b[0] - a[0]*b[2];
+		expected[2] = a[0]*b[1] - a[1]*b[0];
+		expected[3] = 0.0f;
+		Check("cross product", iteration, va.CrossProduct(vb), expected, kExactUlps);
+
+		const float length = sqrtf(a[0]*a[0] + a[1]*a[1] + a[2]*a[2]);
+		for (Int32 component_num = 0; component_num < 3; ++component_num)
+			expected[component_num] = a[component_num] / length;
+		expected[3] = a[3];
+		Vector4 normalised = va;
+		normalised.Normalise();
+		Check("normalise", iteration, normalised, expected, kNormaliseUlps);
+
+		const float lerp_time = scalar * 0.05f;
+		for (Int32 component_num = 0; component_num < 3; ++component_num)
+			expected[component_num] = a[component_num]*(1.0f - lerp_time) + lerp_time*b[component_num];
+		expected[3] = b[3];
+		Vector4 lerped = vb;
+		lerped.Lerp(va, vb, lerp_time);
+		Check("lerp", iteration, lerped, expected, kExactUlps);
+
+		// row vectors, so each result is a sum of the matrix rows scaled by the vector's components
+		for (Int32 component_num = 0; component_num < 3; ++component_num)
+			expected[component_num] = ((a[0]*m[component_num] + a[1]*m[4 + component_num]) + a[2]*m[8 + component_num]) + m[12 + component_num];
+		expected[3] = 0.0f;
+		Check("transform", iteration, va.Transform(matrix), expected, kExactUlps);
+
+		for (Int32 component_num = 0; component_num < 3; ++component_num)
+			expected[component_num] = (a[0]*m[component_num] + a[1]*m[4 + component_num]) + a[2]*m[8 + component_num];
+		Check("transform without translation", iteration, va.TransformNoTranslation(matrix), expected, kExactUlps);
+
+		for (Int32 component_num = 0; component_num < 4; ++component_num)
+			expected[component_num] = ((a[0]*m[component_num] + a[1]*m[4 + component_num]) + a[2]*m[8 + component_num]) + a[3]*m[12 + component_num];
+		Check("transform w", iteration, va.TransformW(matrix), expected, kExactUlps);
+	}
+
+#if defined(GEF_SIMD_SSE)
+	const char* backend = "SSE2";
+#elif defined(GEF_SIMD_NEON)
+	const char* backend = "NEON";
+#else
+	const char* backend = "scalar";
+#endif
+
+	if (g_failure_count > 0)
+	{
+		printf("%s backend: %d components differ from the scalar results\n", backend, g_failure_count);
+		return 1;
+	}
+
+	printf("%s backend: %d iterations match the scalar results\n", backend, kIterationCount);
+	return 0;
+}
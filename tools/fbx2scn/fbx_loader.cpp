@@ -313,6 +313,12 @@ bool FBXLoader::Load(const char* const filename, Platform& platform, Scene& scen
 			if(!anim_data_only)
 			{
 				LoadScene(*fbx_scene, scene, platform);
+
+				// SkeletonPose::CalculateGlobalPose needs every joint after its parent. The skin weights still use cluster indices
+				// here and FixUpSkinWeights finds their joints by name, so the vertices are given the sorted joint indices
+				for(std::list<Skeleton*>::iterator skeleton_iter = scene.skeletons.begin(); skeleton_iter != scene.skeletons.end(); ++skeleton_iter)
+					(*skeleton_iter)->SortJoints();
+
 				scene.FixUpSkinWeights();
 			}
 			if(anim_data_only)
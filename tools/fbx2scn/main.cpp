@@ -1,6 +1,8 @@
 #include <platform/win32/system/platform_win32_null_renderer.h>
 #include "fbx_loader.h"
 #include <graphics/scene.h>
+#include <animation/animation.h>
+#include <graphics/mesh_data.h>
 #include <iostream>
 
 
@@ -13,6 +15,11 @@ int main(int argc, char* argv[])
 	char* output_filename = "output.scn";
 	char* input_filename = "";
 	bool animation_only = false;
+	float resample_rate = 0.0f;
+	bool compress_animations = false;
+	float rotation_tolerance = 0.001f;
+	float translation_tolerance = 0.001f;
+	int bone_palette_size = 0;
 
 
 	gef::FBXLoader fbx_loader;
@@ -127,6 +134,21 @@ int main(int argc, char* argv[])
 				}
 				break;
 
+			case 'b':
+				if (stricmp(&argv[arg_num][1], "bone-palette-size") == 0)
+				{
+					if (arg_num < argc - 2)
+						bone_palette_size = atoi(argv[arg_num + 1]);
+				}
+				break;
+
+			case 'c':
+				if (stricmp(&argv[arg_num][1], "compress-animations") == 0)
+				{
+					compress_animations = true;
+				}
+				break;
+
 			case 'e':
 				if(stricmp(&argv[arg_num][1], "enable-skinning") == 0)
 				{
@@ -147,6 +169,19 @@ int main(int argc, char* argv[])
 				}
 				break;
 
+			case 'r':
+				if (stricmp(&argv[arg_num][1], "resample-rate") == 0)
+				{
+					if (arg_num < argc - 2)
+						resample_rate = (float)atof(argv[arg_num + 1]);
+				}
+				else if (stricmp(&argv[arg_num][1], "rotation-tolerance") == 0)
+				{
+					if (arg_num < argc - 2)
+						rotation_tolerance = (float)atof(argv[arg_num + 1]);
+				}
+				break;
+
 			case 't':
 				if(stricmp(&argv[arg_num][1], "texture-extension") == 0)
 				{
@@ -155,12 +190,23 @@ int main(int argc, char* argv[])
 						fbx_loader.set_texture_filename_ext(&argv[arg_num+1][0]);
 					}
 				}
+				else if (stricmp(&argv[arg_num][1], "translation-tolerance") == 0)
+				{
+					if (arg_num < argc - 2)
+						translation_tolerance = (float)atof(argv[arg_num + 1]);
+				}
 				break;
 
 			}
 		}
 	}
 
+	if (bone_palette_size != 0 && (bone_palette_size < gef::MeshData::kMinBonePaletteSize || bone_palette_size > gef::MeshData::kMaxBonePaletteSize))
+	{
+		std::cout << "ERROR: bone palette size must be from " << gef::MeshData::kMinBonePaletteSize << " to " << gef::MeshData::kMaxBonePaletteSize << ": " << bone_palette_size << std::endl;
+		return -1;
+	}
+
 	gef::Scene scene;
 
 	std::cout << std::endl << "FBX to Abertay Framework Scene Builder v0.01" << std::endl << std::endl;;
@@ -175,6 +221,29 @@ int main(int argc, char* argv[])
 	if(success)
 	{
 		std::cout << "file: " << input_filename << " loaded." << std::endl << std::endl;
+
+		if (resample_rate > 0.0f)
+		{
+			std::cout << "Resampling animations at " << resample_rate << " samples per second" << std::endl;
+			for (std::map<gef::StringId, gef::Animation*>::iterator animation_iter = scene.animations.begin(); animation_iter != scene.animations.end(); ++animation_iter)
+				animation_iter->second->Resample(resample_rate);
+		}
+
+		// only keyed animations are compressed, so resampled animations are left as they are
+		if (compress_animations)
+		{
+			std::cout << "Compressing animations with tolerances of " << rotation_tolerance << " radians and " << translation_tolerance << " units" << std::endl;
+			for (std::map<gef::StringId, gef::Animation*>::iterator animation_iter = scene.animations.begin(); animation_iter != scene.animations.end(); ++animation_iter)
+				animation_iter->second->Compress(rotation_tolerance, translation_tolerance);
+		}
+
+		if (bone_palette_size > 0)
+		{
+			std::cout << "Splitting skinned meshes in to bone palettes of up to " << bone_palette_size << " joints" << std::endl;
+			for (std::list<gef::MeshData>::iterator mesh_iter = scene.mesh_data.begin(); mesh_iter != scene.mesh_data.end(); ++mesh_iter)
+				mesh_iter->SplitBonePalettes(bone_palette_size);
+		}
+
 		std::cout << "Writing output file: " << output_filename << std::endl;
 		success = scene.WriteSceneToFile(platform, output_filename);
 		if(success)